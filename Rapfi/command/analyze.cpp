@@ -0,0 +1,394 @@
+/*
+ *  Rapfi, a Gomoku/Renju playing engine supporting piskvork protocol.
+ *  Copyright (C) 2022  Rapfi developers
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../core/iohelper.h"
+#include "../core/utils.h"
+#include "../game/board.h"
+#include "../search/ab/searcher.h"
+#include "../search/searchthread.h"
+#include "argutils.h"
+#include "command.h"
+
+#define CXXOPTS_NO_REGEX
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cxxopts.hpp>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#ifdef MULTI_THREADING
+    #include <thread>
+#endif
+
+namespace {
+
+enum class OutputFormat { CSV, JSON };
+
+/// A position to analyze, read from one line of the input file.
+struct AnalyzeTask
+{
+    std::string      positionString;
+    Rule             rule;
+    int              boardSize;
+    std::vector<Pos> position;
+};
+
+/// The search result of one analyzed position.
+struct AnalyzeResult
+{
+    Pos              bestMove = Pos::NONE;
+    Value            value    = VALUE_NONE;
+    int              depth    = 0;
+    int              selDepth = 0;
+    uint64_t         numNodes = 0;
+    Time             time     = 0;
+    std::vector<Pos> pv;
+};
+
+/// Read all positions from the input stream. Each line consists of a position string,
+/// then optionally the rule and the board size, separated by commas or whitespaces.
+/// A position string of "-" stands for the empty board.
+std::vector<AnalyzeTask> readTasks(std::istream &is, Rule defaultRule, int defaultBoardSize)
+{
+    std::vector<AnalyzeTask> tasks;
+    std::string              line;
+    size_t                   lineCount = 0;
+
+    while (std::getline(is, line)) {
+        lineCount++;
+        std::replace_if(
+            line.begin(),
+            line.end(),
+            [](char ch) { return ch == ',' || ch == '\t' || ch == '\r'; },
+            ' ');
+
+        std::istringstream lineStream(line);
+        AnalyzeTask        task {{}, defaultRule, defaultBoardSize, {}};
+        if (!(lineStream >> task.positionString) || task.positionString[0] == '#')
+            continue;
+
+        try {
+            std::string ruleStr;
+            if (lineStream >> ruleStr)
+                task.rule = Command::parseRule(ruleStr);
+            if (!(lineStream >> task.boardSize) && !lineStream.eof())
+                throw std::invalid_argument("invalid board size");
+            if (task.boardSize < 5 || task.boardSize > MAX_BOARD_SIZE)
+                throw std::invalid_argument("board size must be in range [5,22]");
+
+            if (task.positionString != "-")
+                task.position = Command::parsePositionString(task.positionString,
+                                                             task.boardSize,
+                                                             task.boardSize);
+        }
+        catch (const std::exception &e) {
+            throw std::runtime_error("illegal position [line " + std::to_string(lineCount)
+                                     + "]: " + e.what());
+        }
+
+        tasks.push_back(std::move(task));
+    }
+
+    return tasks;
+}
+
+/// Search one position with the thread pool and collect its result.
+AnalyzeResult analyzePosition(Search::ThreadPool          &pool,
+                              const AnalyzeTask           &task,
+                              const Search::SearchOptions &baseOptions)
+{
+    Board board(task.boardSize);
+    board.newGame(task.rule);
+    for (Pos pos : task.position) {
+        if (!board.isEmpty(pos))
+            throw std::runtime_error("illegal move in position " + task.positionString);
+        board.move(task.rule, pos);
+    }
+
+    Search::SearchOptions options = baseOptions;
+    options.rule                  = {task.rule, GameRule::FREEOPEN};
+
+    AnalyzeResult result;
+    Time          startTime = now();
+    pool.startThinking(board, options);
+    pool.waitForIdle();
+    result.time     = now() - startTime;
+    result.numNodes = pool.nodesSearched();
+
+    auto  mainThread = pool.main();
+    auto &rootMoves  = mainThread->rootMoves;
+    result.bestMove  = mainThread->bestMove;
+
+    auto rm = std::find(rootMoves.begin(), rootMoves.end(), result.bestMove);
+    if (rm != rootMoves.end()) {
+        // Previous PV is empty if the search is stopped before the first iteration
+        bool usePreviousPv = rm->value == VALUE_NONE && !rm->previousPv.empty();
+
+        result.value    = rm->value != VALUE_NONE ? rm->value : rm->previousValue;
+        result.selDepth = rm->selDepth;
+        result.pv       = usePreviousPv ? rm->previousPv : rm->pv;
+    }
+    if (auto sd = dynamic_cast<Search::AB::ABSearchData *>(mainThread->searchData.get()))
+        result.depth = sd->completedDepth;
+
+    return result;
+}
+
+/// Print a move list in the same format as position strings, eg 'h8h7j6'.
+std::string movesToString(const std::vector<Pos> &moves)
+{
+    std::string str;
+    for (Pos pos : moves) {
+        if (pos == Pos::PASS || pos == Pos::NONE)
+            break;
+        str += char('a' + pos.x());
+        str += std::to_string(pos.y() + 1);
+    }
+    return str;
+}
+
+void writeHeader(std::ostream &os, OutputFormat format)
+{
+    if (format == OutputFormat::CSV)
+        os << "index,position,rule,boardsize,bestmove,value,depth,seldepth,nodes,time,pv\n";
+    else
+        os << "[";
+}
+
+void writeResult(std::ostream        &os,
+                 OutputFormat         format,
+                 size_t               index,
+                 const AnalyzeTask   &task,
+                 const AnalyzeResult &result)
+{
+    std::string bestMove = movesToString({result.bestMove});
+    std::string pv       = movesToString(result.pv);
+    int         value    = result.value != VALUE_NONE ? int(result.value) : 0;
+
+    if (format == OutputFormat::CSV) {
+        os << index << ',' << task.positionString << ',' << task.rule << ',' << task.boardSize
+           << ',' << bestMove << ',' << value << ',' << result.depth << ',' << result.selDepth
+           << ',' << result.numNodes << ',' << result.time << ',' << pv << '\n';
+    }
+    else {
+        os << (index ? ",\n" : "\n") << "{\"index\":" << index << ",\"position\":\""
+           << task.positionString << "\",\"rule\":\"" << task.rule
+           << "\",\"boardsize\":" << task.boardSize << ",\"bestmove\":\"" << bestMove
+           << "\",\"value\":" << value << ",\"depth\":" << result.depth
+           << ",\"seldepth\":" << result.selDepth << ",\"nodes\":" << result.numNodes
+           << ",\"time\":" << result.time << ",\"pv\":\"" << pv << "\"}";
+    }
+}
+
+void writeFooter(std::ostream &os, OutputFormat format)
+{
+    if (format == OutputFormat::JSON)
+        os << "\n]\n";
+    os.flush();
+}
+
+}  // namespace
+
+void Command::analyze(int argc, char *argv[])
+{
+    std::vector<AnalyzeTask> tasks;
+    OutputFormat             format;
+    size_t                   numJobs;
+    size_t                   numThreads;
+    size_t                   hashSizeMb;
+    Time                     reportInterval;
+    Search::SearchOptions    options;
+    std::ostream            *os = &std::cout;
+    std::ofstream            outfile;
+
+    cxxopts::Options cmdOptions("rapfi analyze");
+    cmdOptions.add_options()  //
+        ("i,input",
+         "Path to the position file, in which each line is a position string optionally "
+         "followed by its rule and board size",
+         cxxopts::value<std::string>())  //
+        ("o,output",
+         "Save results to a file (default to stdout if not specified)",
+         cxxopts::value<std::string>())  //
+        ("f,format",
+         "Output format, one of [csv, json]",
+         cxxopts::value<std::string>()->default_value("csv"))  //
+        ("j,jobs",
+         "Number of positions to search concurrently, each with its own thread pool",
+         cxxopts::value<size_t>()->default_value("1"))  //
+        ("nodes", "Maximum nodes per position (0 for no limit)", cxxopts::value<uint64_t>())  //
+        ("depth", "Maximum depth per position", cxxopts::value<int>())                       //
+        ("time", "Maximum time (ms) per position", cxxopts::value<Time>())                   //
+        ("report-interval",
+         "Time (ms) between two progress report message",
+         cxxopts::value<Time>()->default_value("10000"))  //
+        ("h,help", "Print analyze usage");
+    addPlayOptions(cmdOptions);
+
+    try {
+        auto args = cmdOptions.parse(argc, argv);
+
+        if (args.count("help")) {
+            std::cout << cmdOptions.help() << std::endl;
+            std::exit(EXIT_SUCCESS);
+        }
+
+        if (!args.count("input"))
+            throw std::invalid_argument("no input position file is specified");
+        std::string   inputPath = args["input"].as<std::string>();
+        std::ifstream inputFile(inputPath);
+        if (!inputFile.is_open())
+            throw std::invalid_argument("unable to open input file " + inputPath);
+        tasks = readTasks(inputFile,
+                          parseRule(args["rule"].as<std::string>()),
+                          args["boardsize"].as<int>());
+
+        if (args.count("output")) {
+            std::string filename = args["output"].as<std::string>();
+            outfile.open(filename);
+            if (!outfile.is_open())
+                throw std::invalid_argument("unable to open file " + filename);
+            os = &outfile;
+        }
+
+        std::string formatStr = args["format"].as<std::string>();
+        if (formatStr == "csv")
+            format = OutputFormat::CSV;
+        else if (formatStr == "json")
+            format = OutputFormat::JSON;
+        else
+            throw std::invalid_argument("unknown output format " + formatStr);
+
+        numJobs        = std::max<size_t>(args["jobs"].as<size_t>(), 1);
+        numThreads     = std::max<size_t>(args["thread"].as<size_t>(), 1);
+        hashSizeMb     = std::max<size_t>(args["hashsize"].as<size_t>(), 1);
+        reportInterval = std::max<Time>(args["report-interval"].as<Time>(), 1);
+
+        if (!args.count("nodes") && !args.count("depth") && !args.count("time"))
+            throw std::invalid_argument("at least one of nodes, depth or time must be limited");
+        if (args.count("nodes"))
+            options.maxNodes = args["nodes"].as<uint64_t>();
+        if (args.count("depth"))
+            options.maxDepth = std::clamp(args["depth"].as<int>(), 1, 99);
+        if (args.count("time"))
+            options.setTimeControl(args["time"].as<Time>(), 0);
+        options.disableOpeningQuery = true;
+    }
+    catch (const std::exception &e) {
+        ERRORL("analyze argument: " << e.what());
+        std::exit(EXIT_FAILURE);
+    }
+
+#ifndef MULTI_THREADING
+    numJobs = 1;
+#endif
+    numJobs = std::min(numJobs, std::max<size_t>(tasks.size(), 1));
+    MESSAGEL("Readed " << tasks.size() << " positions, analyzing with " << numJobs << " jobs of "
+                       << numThreads << " threads.");
+
+    // Each job owns a thread pool, while the transposition table is shared by all jobs
+    Config::MessageMode = MsgMode::NONE;
+    Search::Threads.searcher()->setMemoryLimit(hashSizeMb * 1024);
+    Search::Threads.clear(true);
+
+    std::vector<std::unique_ptr<Search::ThreadPool>> pools;
+    for (size_t i = 0; i < numJobs; i++) {
+        auto &pool = pools.emplace_back(std::make_unique<Search::ThreadPool>());
+        pool->setupEvaluator(Search::Threads.evaluatorMakerFunc());
+        pool->setNumThreads(numThreads);
+        pool->clear(false);
+    }
+
+    std::vector<AnalyzeResult> results(tasks.size());
+    std::vector<bool>          finished(tasks.size(), false);
+    std::atomic<size_t>        nextTaskIndex {0};
+    size_t                     numFinished = 0, numWritten = 0;
+    uint64_t                   totalNodes  = 0;
+    std::mutex                 mutex;
+    std::condition_variable    cv;
+
+    // Write all finished results that are next in the input order
+    auto writeFinishedResults = [&]() {
+        for (; numWritten < tasks.size() && finished[numWritten]; numWritten++)
+            writeResult(*os, format, numWritten, tasks[numWritten], results[numWritten]);
+    };
+
+    auto runJob = [&](Search::ThreadPool &pool) {
+        for (size_t i; (i = nextTaskIndex.fetch_add(1)) < tasks.size();) {
+            AnalyzeResult result;
+            try {
+                result = analyzePosition(pool, tasks[i], options);
+            }
+            catch (const std::exception &e) {
+                ERRORL("analyze [index " << i << "]: " << e.what());
+            }
+
+            {
+                std::lock_guard lock(mutex);
+                results[i]  = std::move(result);
+                finished[i] = true;
+                totalNodes += results[i].numNodes;
+                numFinished++;
+            }
+            cv.notify_one();
+        }
+    };
+
+    writeHeader(*os, format);
+    Time startTime = now();
+#ifdef MULTI_THREADING
+    std::vector<std::thread> jobs;
+    for (auto &pool : pools)
+        jobs.emplace_back(runJob, std::ref(*pool));
+
+    // Write results as soon as they are available in order, and report progress over time
+    Time lastTime = startTime;
+    for (std::unique_lock lock(mutex); numWritten < tasks.size();) {
+        cv.wait_for(lock, std::chrono::milliseconds(reportInterval), [&] {
+            return finished[numWritten];
+        });
+        writeFinishedResults();
+        os->flush();
+
+        if (now() - lastTime >= reportInterval && numWritten < tasks.size()) {
+            Time elapsed = now() - startTime;
+            MESSAGEL("Analyzed " << numFinished << " of " << tasks.size()
+                                 << " positions, position/hour = "
+                                 << numFinished * 3600000.0 / elapsed);
+            lastTime = now();
+        }
+    }
+
+    for (auto &job : jobs)
+        job.join();
+#else
+    runJob(*pools.front());
+#endif
+    writeFinishedResults();
+    writeFooter(*os, format);
+
+    Time   elapsed         = std::max<Time>(now() - startTime, 1);
+    double positionPerHour = tasks.size() * 3600000.0 / elapsed;
+    MESSAGEL("Completed analyzing " << tasks.size() << " positions in " << elapsed / 1000.0
+                                    << " s, nodes/s = " << totalNodes * 1000 / elapsed);
+    MESSAGEL("Position/hour = " << positionPerHour << " (" << positionPerHour / numJobs
+                                << " per job, " << positionPerHour / (numJobs * numThreads)
+                                << " per thread)");
+}
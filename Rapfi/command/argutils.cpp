@@ -22,6 +22,7 @@
     #define CXXOPTS_NO_REGEX
     #include <cxxopts.hpp>
 #endif
+#include <istream>
 #include <string>
 
 Rule Command::parseRule(std::string_view ruleStr)
@@ -113,6 +114,29 @@ Command::parsePositionString(std::string_view positionString, int boardWidth, in
     return position;
 }
 
+std::vector<std::vector<Pos>> Command::readOpenings(std::istream &is, int boardSize)
+{
+    std::vector<std::vector<Pos>> ops;
+    std::string                   opStr;
+    size_t                        lineCount = 0;
+
+    while (std::getline(is, opStr)) {
+        lineCount++;
+        if (opStr.empty())
+            continue;
+
+        try {
+            ops.push_back(parsePositionString(opStr, boardSize, boardSize));
+        }
+        catch (const std::exception &e) {
+            throw std::runtime_error("illegal opening [line " + std::to_string(lineCount)
+                                     + "]: " + e.what());
+        }
+    }
+
+    return ops;
+}
+
 #ifndef NO_COMMAND_MODULES
 
 void Command::addPlayOptions(cxxopts::Options &options)
@@ -21,6 +21,7 @@
 #include "../core/types.h"
 #include "../search/opening.h"
 
+#include <iosfwd>
 #include <stdexcept>
 #include <string_view>
 #include <vector>
@@ -52,6 +53,11 @@ DataWriterType parseDataWriterType(std::string dwType);
 /// @return The parsed pos sequence.
 std::vector<Pos> parsePositionString(std::string_view posStr, int boardWidth, int boardHeight);
 
+/// Read openings from the input stream, one position string per line.
+/// Throws std::runtime_error if any of the openings is not correct.
+/// @return The list of parsed openings.
+std::vector<std::vector<Pos>> readOpenings(std::istream &is, int boardSize);
+
 }  // namespace Command
 
 #ifndef NO_COMMAND_MODULES
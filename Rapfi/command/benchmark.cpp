@@ -18,6 +18,7 @@
 
 #include "../core/hash.h"
 #include "../core/iohelper.h"
+#include "../core/platform.h"
 #include "../core/pos.h"
 #include "../core/types.h"
 #include "../game/board.h"
@@ -28,8 +29,32 @@
 
 #include <iostream>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
+#ifdef COUNT_ALLOCATIONS
+    #include <atomic>
+    #include <cstdlib>
+    #include <new>
+
+/// Number of heap allocations made through the global operator new, which is replaced
+/// below to measure the allocations made by each search in the benchmark.
+static std::atomic<size_t> numAllocations {0};
+
+void *operator new(size_t size)
+{
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
 constexpr size_t         TotalMoveTestNum = 2000000;
 constexpr size_t         TTSizeMB         = 16;
 constexpr CandidateRange CandRange        = CandidateRange::SQUARE3_LINE4;
@@ -62,12 +87,13 @@ static const std::vector<BenchEntry> benchSet = {
 
 struct EngineState
 {
-    size_t  threadNum;
-    size_t  memoryLimitKB;
-    bool    aspirationWindow;
-    int     numIterationAfterSingularRoot;
-    int     numIterationAfterMate;
-    MsgMode messageMode;
+    size_t           threadNum;
+    size_t           memoryLimitKB;
+    bool             aspirationWindow;
+    int              numIterationAfterSingularRoot;
+    int              numIterationAfterMate;
+    MsgMode          messageMode;
+    Numa::BindPolicy bindPolicy;
 };
 
 EngineState saveEngineStateForBenckmark()
@@ -80,12 +106,14 @@ EngineState saveEngineStateForBenckmark()
     state.numIterationAfterSingularRoot = Config::NumIterationAfterSingularRoot;
     state.numIterationAfterMate         = Config::NumIterationAfterMate;
     state.messageMode                   = Config::MessageMode;
+    state.bindPolicy                    = Numa::bindPolicy();
 
     return state;
 }
 
 void recoverEngineState(EngineState state)
 {
+    Numa::setBindPolicy(state.bindPolicy);
     Search::Threads.setNumThreads(state.threadNum);
     Search::Threads.searcher()->setMemoryLimit(state.memoryLimitKB);
     Config::MessageMode                   = state.messageMode;
@@ -94,7 +122,7 @@ void recoverEngineState(EngineState state)
     Config::NumIterationAfterMate         = state.numIterationAfterMate;
 }
 
-void Command::benchmark()
+void Command::benchmark(bool memoryReport, size_t placementThreads)
 {
     std::unique_ptr<Board> board;
     EngineState            backupState = saveEngineStateForBenckmark();
@@ -104,78 +132,129 @@ void Command::benchmark()
     Time   duration        = 0;
     size_t moveCount       = 0;
     size_t testNumPerEntry = TotalMoveTestNum / benchSet.size();
-    for (const auto &benchEntry : benchSet) {
-        board = std::make_unique<Board>(benchEntry.boardSize, CandRange);
-        board->newGame(benchEntry.rule);
-        std::vector<Pos> position =
-            parsePositionString(benchEntry.positionString, board->size(), board->size());
-
-        Time   startTime = now();
-        size_t testNum   = testNumPerEntry / position.size();
-        for (size_t test = 0; test < testNum; test++) {
-            for (size_t i = 0; i < position.size(); i++)
-                board->move(benchEntry.rule, position[i]);
-
-            for (size_t i = 0; i < position.size(); i++)
-                board->undo(benchEntry.rule);
-        }
-        Time endTime = now();
+    auto   moveBench       = [&](auto moveType) {
+        constexpr Board::MoveType MT = decltype(moveType)::value;
+        duration                     = 0;
+        moveCount                    = 0;
 
-        duration += endTime - startTime;
-        moveCount += testNum * position.size();
-    }
+        for (const auto &benchEntry : benchSet) {
+            board = std::make_unique<Board>(benchEntry.boardSize, CandRange);
+            board->newGame(benchEntry.rule);
+            std::vector<Pos> position =
+                parsePositionString(benchEntry.positionString, board->size(), board->size());
+
+            Time   startTime = now();
+            size_t testNum   = testNumPerEntry / position.size();
+            for (size_t test = 0; test < testNum; test++) {
+                for (size_t i = 0; i < position.size(); i++)
+                    board->move<MT>(benchEntry.rule, position[i]);
+
+                for (size_t i = 0; i < position.size(); i++)
+                    board->undo<MT>(benchEntry.rule);
+            }
+            Time endTime = now();
 
+            duration += endTime - startTime;
+            moveCount += testNum * position.size();
+        }
+    };
+
+    moveBench(std::integral_constant<Board::MoveType, Board::MoveType::NORMAL> {});
     MESSAGEL("Total Time (ms): " << duration);
     MESSAGEL("Moves/s: " << moveCount * 1000 / std::max<size_t>(duration, 1));
 
-    MESSAGEL("=========Search Bench=========");
+    // Same line of moves without classical eval maintenance, as used when an
+    // evaluator fully replaces the classical eval
+    moveBench(std::integral_constant<Board::MoveType, Board::MoveType::NO_CLASSICAL_EVAL> {});
+    MESSAGEL("Moves/s (no classical eval): "
+             << moveCount * 1000 / std::max<size_t>(duration, 1));
+
     Config::MessageMode                   = MsgMode::NONE;
     Config::AspirationWindow              = true;
     Config::NumIterationAfterSingularRoot = 0;
     Config::NumIterationAfterMate         = 0;
-    Search::Threads.setNumThreads(1);
-    Search::Threads.searcher()->setMemoryLimit(TTSizeMB * 1024);
     Search::SearchOptions options;
     options.infoMode            = Search::SearchOptions::INFO_NONE;
     options.disableOpeningQuery = true;
-    duration                    = 0;
     size_t searchNodes          = 0;
+    size_t searchAllocations    = 0;
 
-    Hash::XXHasher hasher(TTSizeMB);
+    // Benchmark for search, which hashes the search result of each entry if hasher is given
+    auto searchBench = [&](size_t numThreads, Hash::XXHasher *hasher) {
+        Search::Threads.setNumThreads(numThreads);
+        Search::Threads.searcher()->setMemoryLimit(TTSizeMB * 1024);
+        duration          = 0;
+        searchNodes       = 0;
+        searchAllocations = 0;
+
+        for (const auto &benchEntry : benchSet) {
+            board = std::make_unique<Board>(benchEntry.boardSize, CandRange);
+            board->newGame(benchEntry.rule);
+            std::vector<Pos> position =
+                parsePositionString(benchEntry.positionString, board->size(), board->size());
 
-    for (const auto &benchEntry : benchSet) {
-        board = std::make_unique<Board>(benchEntry.boardSize, CandRange);
-        board->newGame(benchEntry.rule);
-        std::vector<Pos> position =
-            parsePositionString(benchEntry.positionString, board->size(), board->size());
+            for (Pos p : position)
+                board->move(benchEntry.rule, p);
 
-        for (Pos p : position)
-            board->move(benchEntry.rule, p);
+            options.rule     = {benchEntry.rule, GameRule::FREEOPEN};
+            options.maxDepth = benchEntry.searchDepth;
+            Search::Threads.clear(true);
 
-        options.rule     = {benchEntry.rule, GameRule::FREEOPEN};
-        options.maxDepth = benchEntry.searchDepth;
-        Search::Threads.clear(true);
+#ifdef COUNT_ALLOCATIONS
+            size_t startAllocations = numAllocations.load();
+#endif
+            Time startTime = now();
+            Search::Threads.startThinking(*board, options, true);
+            Search::Threads.waitForIdle();
+            Time endTime = now();
 
-        Time startTime = now();
-        Search::Threads.startThinking(*board, options, true);
-        Search::Threads.waitForIdle();
-        Time endTime = now();
+            duration += endTime - startTime;
+#ifdef COUNT_ALLOCATIONS
+            searchAllocations += numAllocations.load() - startAllocations;
+#endif
 
-        duration += endTime - startTime;
+            size_t nodes = Search::Threads.nodesSearched();
+            searchNodes += nodes;
 
-        size_t nodes = Search::Threads.nodesSearched();
-        searchNodes += nodes;
+            if (hasher) {
+                // Hash from nodes searched
+                *hasher << nodes;
+                // Hash from the last output eval
+                *hasher << Search::Threads.main()->rootMoves[0].value;
+            }
+        }
+    };
 
-        // Hash from nodes searched
-        hasher << nodes;
-        // Hash from the last output eval
-        hasher << Search::Threads.main()->rootMoves[0].value;
+    // Compare the search speed of thread bind policies with multiple threads. The nodes
+    // searched with multiple threads are not deterministic, thus not hashed.
+    if (placementThreads > 0) {
+        MESSAGEL("=======Placement Bench========");
+        MESSAGEL("Threads: " << placementThreads);
+        for (int i = 0; i < int(Numa::BindPolicy::BIND_POLICY_NB); i++) {
+            Numa::BindPolicy policy = static_cast<Numa::BindPolicy>(i);
+            Numa::setBindPolicy(policy);
+            searchBench(placementThreads, nullptr);
+            MESSAGEL("Policy " << Numa::bindPolicyName(policy) << ": Nodes/s: "
+                               << searchNodes * 1000 / std::max<size_t>(duration, 1));
+        }
+        Numa::setBindPolicy(backupState.bindPolicy);
     }
 
+    MESSAGEL("=========Search Bench=========");
+    Hash::XXHasher hasher(TTSizeMB);
+    searchBench(1, &hasher);
+
+    // Report memory while the evaluators and hash table of the search are still alive
+    if (memoryReport)
+        MemAlloc::printMemoryUsage();
+
     uint32_t hash32 = (uint64_t(hasher) >> 32) ^ uint64_t(hasher);
     MESSAGEL("Total Time (ms): " << duration);
     MESSAGEL("Nodes: " << searchNodes);
     MESSAGEL("Nodes/s: " << searchNodes * 1000 / std::max<size_t>(duration, 1));
+#ifdef COUNT_ALLOCATIONS
+    MESSAGEL("Allocations/search: " << searchAllocations / benchSet.size());
+#endif
     MESSAGEL("Hash: " << std::hex << hash32 << std::dec);
 
     recoverEngineState(backupState);
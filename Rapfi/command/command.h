@@ -67,11 +67,16 @@ bool loadModelFromFile(std::filesystem::path modelPath);
 // Command modules entry
 
 void gomocupLoop();
-void benchmark();
+void benchmark(bool memoryReport = false, size_t placementThreads = 0);
 void opengen(int argc, char *argv[]);
 void tuning(int argc, char *argv[]);
 void selfplay(int argc, char *argv[]);
 void dataprep(int argc, char *argv[]);
 void database(int argc, char *argv[]);
+void simdbench(int argc, char *argv[]);
+void onnxquant(int argc, char *argv[]);
+void analyze(int argc, char *argv[]);
+void match(int argc, char *argv[]);
+void timetune(int argc, char *argv[]);
 
 }  // namespace Command
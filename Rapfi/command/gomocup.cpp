@@ -18,6 +18,7 @@
 
 #include "../config.h"
 #include "../core/iohelper.h"
+#include "../core/platform.h"
 #include "../core/utils.h"
 #include "../database/dbclient.h"
 #include "../database/dbutils.h"
@@ -34,12 +35,14 @@
 #include "../tuning/tunemap.h"
 #include "command.h"
 
+#include <cctype>
+#include <charconv>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
 #include <optional>
-#include <sstream>
+#include <string_view>
 
 #ifdef MULTI_THREADING
     #include <mutex>
@@ -72,15 +75,84 @@ bool checkLastMoveIsNotPass(Board &board)
     return false;
 }
 
-/// Parse a coord in form 'x,y' from in stream and check if the pos is legal.
+/// TokenReader reads whitespace separated protocol tokens line by line into a reused
+/// line buffer, so reading long position lists does not allocate in steady state.
+class TokenReader
+{
+public:
+    explicit TokenReader(std::istream &in) : in(in) {}
+
+    /// Read the next token, or an empty token when reaching EOF.
+    std::string_view next()
+    {
+        while (true) {
+            while (cursor < line.size() && std::isspace(uint8_t(line[cursor])))
+                cursor++;
+            if (cursor < line.size()) {
+                size_t begin = cursor;
+                while (cursor < line.size() && !std::isspace(uint8_t(line[cursor])))
+                    cursor++;
+                return std::string_view(line).substr(begin, cursor - begin);
+            }
+
+            if (!std::getline(in, line))
+                return {};
+            cursor = 0;
+        }
+    }
+
+    /// Discard the remaining tokens of the current line.
+    void skipLine() { cursor = line.size(); }
+
+    /// Read the rest of the current line after the separator that follows the last token.
+    std::string_view restOfLine()
+    {
+        size_t begin = std::min(cursor + 1, line.size());
+        cursor       = line.size();
+        return std::string_view(line).substr(begin);
+    }
+
+private:
+    std::istream &in;
+    std::string   line;
+    size_t        cursor = 0;
+};
+
+/// Reader of position lists and coords from stdin, the rest of the line is skipped after
+/// each command argument.
+TokenReader stdinTokens(std::cin);
+
+/// Check if a token is the 'DONE' terminator of a list, in either case.
+bool isDoneToken(std::string_view token)
+{
+    constexpr std::string_view Done = "DONE";
+    return token.size() == Done.size()
+           && std::equal(token.begin(), token.end(), Done.begin(), [](char a, char b) {
+                  return std::toupper(uint8_t(a)) == b;
+              });
+}
+
+/// Parse integers in form 'a,b,c' from a token into values, without going through
+/// stream extraction. Values after the first one failed to parse are left unchanged.
+void parseIntList(std::string_view token, int *values, int count)
+{
+    const char *ptr = token.data(), *end = token.data() + token.size();
+    for (int i = 0; i < count && ptr < end; i++) {
+        auto [next, ec] = std::from_chars(ptr, end, values[i]);
+        if (ec != std::errc() || (next < end && *next != ','))
+            return;
+        ptr = next + 1;
+    }
+}
+
+/// Parse a coord in form 'x,y' from a token and check if the pos is legal.
 /// Legal means the pos must be an empty cell or an non-consecutive pass move.
-std::optional<Pos> parseLegalCoord(std::istream &is, Board &board)
+std::optional<Pos> parseLegalCoord(std::string_view token, Board &board)
 {
-    int  x = -2, y = -2;
-    char comma;
-    is >> x >> comma >> y;
+    int coord[2] = {-2, -2};
+    parseIntList(token, coord, 2);
 
-    Pos pos = inputCoordConvert(x, y, board.size());
+    Pos pos = inputCoordConvert(coord[0], coord[1], board.size());
     if (board.isLegal(pos)) {
         if (checkLastMoveIsNotPass(board))
             return std::nullopt;
@@ -98,9 +170,11 @@ namespace Command::GomocupProtocol {
 
 std::unique_ptr<Board>        board;
 Search::SearchOptions         options;
-bool                          GUIMode   = false;
-std::atomic_bool              thinking  = false;
-std::optional<CandidateRange> candRange = std::nullopt;
+bool                          GUIMode      = false;
+std::atomic_bool              thinking     = false;
+std::optional<CandidateRange> candRange    = std::nullopt;
+size_t                        maxMemoryKB  = 0;      // max_memory from INFO, 0 if not given
+bool                          candExpanded = false;  // Candidates expanded outside of moves
 
 void sendActionAndUpdateBoard(ActionType action, Pos bestMove)
 {
@@ -139,6 +213,42 @@ void sendActionAndUpdateBoard(ActionType action, Pos bestMove)
     }
 }
 
+/// Shrink the hash table when the measured memory of other subsystems (evaluator weights,
+/// MCTS tree, database cache, ...) leaves less room than the reserved size assumed, so that
+/// the total usage stays within the max_memory given by the manager.
+void enforceMemoryLimit()
+{
+    if (!maxMemoryKB)
+        return;
+
+    // Compare with the requested hash size, as the allocation is rounded up to page size
+    size_t hashKB  = MemAlloc::trackedMemory(MemAlloc::MemoryTag::HASH_TABLE) >> 10;
+    size_t otherKB = (MemAlloc::trackedMemoryTotal() >> 10) - hashKB;
+    size_t limitKB = Search::Threads.searcher()->getMemoryLimit();
+    if (otherKB + limitKB <= maxMemoryKB)
+        return;
+
+    // Resizing is pointless when the searcher does not honour the memory limit
+    if (!Search::Threads.searcher()->hasMemoryLimit()) {
+        ERRORL("Memory usage of " << otherKB + limitKB << " KB exceeds max memory, "
+                                  << "but the searcher can not shrink its memory");
+        return;
+    }
+
+    // Leave some headroom for other subsystems to grow, since every resize clears the table.
+    // Minimal hash size value is 1 KB.
+    size_t reservedKB = otherKB + otherKB / 4;
+    size_t memLimitKB = maxMemoryKB <= reservedKB ? 1 : maxMemoryKB - reservedKB;
+    if (memLimitKB >= limitKB) {
+        ERRORL("Memory usage of " << otherKB << " KB outside hash table exceeds max memory");
+        return;
+    }
+
+    MESSAGEL("Memory usage outside hash table is " << otherKB << " KB, shrink hash to "
+                                                   << memLimitKB << " KB");
+    Search::Threads.searcher()->setMemoryLimit(memLimitKB);
+}
+
 void think(Board                             &board,
            uint16_t                           multiPV     = 1,
            Search::SearchOptions::BalanceMode balanceMode = Search::SearchOptions::BALANCE_NONE,
@@ -159,6 +269,8 @@ void think(Board                             &board,
         Search::Threads.waitForIdle();
     }
 
+    enforceMemoryLimit();
+
     thinking = true;
     Search::Threads.startThinking(board, options, false, [&, startTime = now()]() {
         {
@@ -243,6 +355,13 @@ void getOption()
                 if (maxMemSizeKB < std::max<size_t>(10240, memReservedKB))
                     ERRORL("Max memory too small, might exceeds memory limits");
             }
+            maxMemoryKB = maxMemSizeKB;
+
+            // Reserve at least the memory already measured in other subsystems
+            size_t trackedOtherKB = (MemAlloc::trackedMemoryTotal()
+                                     - MemAlloc::trackedMemory(MemAlloc::MemoryTag::HASH_TABLE))
+                                    >> 10;
+            memReservedKB         = std::max(memReservedKB, trackedOtherKB);
         }
 
         // minimal hash size value is 1 KB
@@ -362,6 +481,7 @@ void getOption()
     }
     else if (token == "NBESTSYM") {
         std::cin >> val;
+        options.collapseSymmetryMoves = val == 1;
     }
     else if (token == "VCTHREAD") {
         std::cin >> val;
@@ -448,13 +568,21 @@ void showHashUsage()
                                           << "%");
 }
 
-void dumpHash()
+void showMemoryUsage()
+{
+    MemAlloc::printMemoryUsage();
+}
+
+void dumpHash(bool incremental)
 {
     auto          path = readPathFromInput();
     std::ofstream hashout(path, std::ios_base::binary);
     if (hashout.is_open()) {
-        Search::TT.dump(hashout);
-        MESSAGEL("Transposition table dumped: " << pathToConsoleString(path));
+        // Incremental dumps fall back to full dumps when there is no usable base
+        if (Search::TT.dump(hashout, {incremental}))
+            MESSAGEL("Transposition table incrementally dumped: " << pathToConsoleString(path));
+        else
+            MESSAGEL("Transposition table dumped: " << pathToConsoleString(path));
     }
     else
         MESSAGEL("Failed to open file: " << pathToConsoleString(path));
@@ -615,7 +743,8 @@ void begin()
 
 void turn()
 {
-    auto pos = parseLegalCoord(std::cin, *board);
+    auto pos = parseLegalCoord(stdinTokens.next(), *board);
+    stdinTokens.skipLine();
     if (!pos.has_value())
         return;
 
@@ -627,39 +756,31 @@ void turn()
 
 void getPosition(bool startThink)
 {
-    board->newGame(options.rule);
     options.multiPV     = 1;
     options.balanceMode = Search::SearchOptions::BALANCE_NONE;
 
-    // Read position sequence
+    // Read position sequence. Buffers are kept across commands to avoid reallocation.
     enum SideFlag { SELF = 1, OPPO = 2, WALL = 3 };
-    std::vector<std::pair<Pos, SideFlag>> position;
-
-    while (true) {
-        std::string coordStr;
-        std::cin >> coordStr;
-        upperInplace(coordStr);
-
-        if (coordStr == "DONE" || std::cin.eof())
-            break;
-
-        std::optional<Pos> pos;
-        int                color = -1;
-        {
-            std::stringstream ss;
-            char              comma;
-            ss << coordStr;
-            pos = parseLegalCoord(ss, *board);
-            ss >> comma >> color;
-        }
-
-        if (pos.has_value()) {
-            if (color == SELF || color == OPPO || color == WALL && *pos != Pos::NONE)
-                position.emplace_back(*pos, static_cast<SideFlag>(color));
-            else
-                ERRORL("Color is not a valid value, must be one of [1, 2, 3].");
-        }
+    static std::vector<std::pair<Pos, SideFlag>> position;
+    static std::vector<Pos>                      moves;
+    position.clear();
+    moves.clear();
+
+    for (std::string_view token; !(token = stdinTokens.next()).empty() && !isDoneToken(token);) {
+        // Coords are checked against an empty board, as the position replaces the board
+        int values[3] = {-2, -2, -1};
+        parseIntList(token, values, 3);
+        Pos pos   = inputCoordConvert(values[0], values[1], board->size());
+        int color = values[2];
+
+        if (pos != Pos::PASS && !board->isInBoard(pos))
+            ERRORL("Coord is not valid or empty.");
+        else if (color == SELF || color == OPPO || color == WALL && pos != Pos::NONE)
+            position.emplace_back(pos, static_cast<SideFlag>(color));
+        else
+            ERRORL("Color is not a valid value, must be one of [1, 2, 3].");
     }
+    stdinTokens.skipLine();
 
     // The first move (either real move or pass) is always considered as BLACK
     Color selfColor = BLACK;
@@ -670,27 +791,61 @@ void getPosition(bool startThink)
         }
     }
 
-    // Put stones on board
+    // Build the move sequence of the position
+    bool consecutivePass = false;
+    bool occupied[FULL_BOARD_CELL_COUNT] {};
     for (auto [pos, side] : position) {
         if (side == WALL)  // Currently wall is not supported
             continue;
 
+        // Drop stones on an occupied cell before they reach the board
+        if (pos != Pos::PASS) {
+            if (occupied[pos]) {
+                ERRORL("Coord is not valid or empty.");
+                continue;
+            }
+            occupied[pos] = true;
+        }
+
         // Make sure current side to move correspond to the input side
         // If not, we add an extra PASS move to flip the side
-        if (side == SELF && board->sideToMove() != selfColor
-            || side == OPPO && board->sideToMove() != ~selfColor) {
-            if (checkLastMoveIsNotPass(*board))
-                return;
-
-            board->move(options.rule, Pos::PASS);
+        Color sideToMove = moves.size() % 2 ? WHITE : BLACK;
+        bool  lastIsPass = !moves.empty() && moves.back() == Pos::PASS;
+        if (side == SELF && sideToMove != selfColor || side == OPPO && sideToMove != ~selfColor) {
+            if ((consecutivePass = lastIsPass))
+                break;
+
+            moves.push_back(Pos::PASS);
+            lastIsPass = true;
         }
 
-        if (pos == Pos::PASS && checkLastMoveIsNotPass(*board))
-            return;
+        if ((consecutivePass = pos == Pos::PASS && lastIsPass))
+            break;
 
-        board->move(options.rule, pos);
+        moves.push_back(pos);
     }
 
+    // Put stones on board. Most positions extend the previous one by a few moves, so we
+    // only undo the moves after the common prefix instead of replaying the whole position.
+    // Expanded candidates are not reverted by undo, so we start a new game to drop them.
+    int commonPly = 0;
+    while (commonPly < board->ply() && commonPly < int(moves.size())
+           && board->getHistoryMove(commonPly) == moves[commonPly])
+        commonPly++;
+    if (commonPly == 0 || candExpanded) {
+        board->newGame(options.rule);
+        candExpanded = false;
+    }
+    while (board->ply() > commonPly)
+        board->undo(options.rule);
+
+    for (size_t i = commonPly; i < moves.size(); i++)
+        board->move(options.rule, moves[i]);
+
+    // The board ends with the pass move that the rejected pass follows
+    if (consecutivePass && checkLastMoveIsNotPass(*board))
+        return;
+
     // Start thinking if needed
     if (startThink)
         think(*board);
@@ -698,23 +853,11 @@ void getPosition(bool startThink)
 
 void getBlock(bool remove = false)
 {
-    int               x, y;
-    char              comma;
-    std::string       coordStr;
-    std::stringstream ss;
-
-    while (true) {
-        std::cin >> coordStr;
-        upperInplace(coordStr);
+    for (std::string_view token; !(token = stdinTokens.next()).empty() && !isDoneToken(token);) {
+        int coord[2] = {-2, -2};
+        parseIntList(token, coord, 2);
 
-        if (coordStr == "DONE")
-            break;
-
-        ss.clear();
-        ss << coordStr;
-        ss >> x >> comma >> y;
-
-        Pos pos = inputCoordConvert(x, y, board->size());
+        Pos pos = inputCoordConvert(coord[0], coord[1], board->size());
         if (!board->isInBoard(pos) || pos == Pos::PASS)
             ERRORL("Block coord is a pass or invalid.");
 
@@ -729,6 +872,7 @@ void getBlock(bool remove = false)
                 options.blockMoves.end());
         }
     }
+    stdinTokens.skipLine();
 }
 
 void nbest()
@@ -768,8 +912,10 @@ void balance(Search::SearchOptions::BalanceMode mode)
     if (mode == Search::SearchOptions::BALANCE_TWO)
         options.balanceBias = -options.balanceBias;
 
-    if (board->ply() == 0)
+    if (board->ply() == 0) {
         Opening::expandCandidateHalfBoard(*board);
+        candExpanded = true;
+    }
 
     think(*board, 1, mode, false, true);
 }
@@ -779,21 +925,12 @@ void getDatabasePosition()
     board->newGame(options.rule);
 
     // Read position sequence
-    while (true) {
-        std::string coordStr;
-        std::cin >> coordStr;
-        upperInplace(coordStr);
-
-        if (coordStr == "DONE")
-            break;
-
-        std::stringstream ss;
-        ss << coordStr;
-        auto pos = parseLegalCoord(ss, *board);
-
+    for (std::string_view token; !(token = stdinTokens.next()).empty() && !isDoneToken(token);) {
+        auto pos = parseLegalCoord(token, *board);
         if (pos.has_value())
             board->move(options.rule, *pos);
     }
+    stdinTokens.skipLine();
 }
 
 void queryDatabaseAll(bool getPosition)
@@ -943,15 +1080,12 @@ void editDatabaseText()
 void editDatabaseBoardLabel()
 {
     using namespace ::Database;
-    std::string coordStr, newText;
-    std::cin >> coordStr;
-    std::cin.ignore(1);
-    std::getline(std::cin, newText);
+    // Copy the tokens out, as the position list below reuses the line buffer
+    std::string coordStr(stdinTokens.next());
+    std::string newText(stdinTokens.restOfLine());
     getDatabasePosition();
 
-    std::stringstream ss;
-    ss << coordStr;
-    auto pos = parseLegalCoord(ss, *board);
+    auto pos = parseLegalCoord(coordStr, *board);
     if (!pos.has_value())
         return;
 
@@ -1317,7 +1451,9 @@ bool runProtocol()
     else if (cmd == "YXSHOWINFO")          setGUIMode();
     else if (cmd == "YXHASHCLEAR")         clearHash();
     else if (cmd == "YXSHOWHASHUSAGE")     showHashUsage();
-    else if (cmd == "YXHASHDUMP")          dumpHash();
+    else if (cmd == "YXSHOWMEMORY")        showMemoryUsage();
+    else if (cmd == "YXHASHDUMP")          dumpHash(false);
+    else if (cmd == "YXHASHDUMPINC")       dumpHash(true);
     else if (cmd == "YXHASHLOAD")          loadHash();
     else if (cmd == "YXSETDATABASE")       setDatabase();
     else if (cmd == "YXSAVEDATABASE")      saveDatabase();
@@ -0,0 +1,507 @@
+/*
+ *  Rapfi, a Gomoku/Renju playing engine supporting piskvork protocol.
+ *  Copyright (C) 2022  Rapfi developers
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../core/iohelper.h"
+#include "../core/utils.h"
+#include "../game/board.h"
+#include "../search/hashtable.h"
+#include "../search/opening.h"
+#include "../search/searchthread.h"
+#include "../search/timecontrol.h"
+#include "../tuning/tunemap.h"
+#include "argutils.h"
+#include "command.h"
+
+#define CXXOPTS_NO_REGEX
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cxxopts.hpp>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#ifdef MULTI_THREADING
+    #include <thread>
+#endif
+
+namespace {
+
+/// MatchEngine is one side of the match, defined by a config file and tune overrides.
+/// As config and tune parameters are process-wide, only one engine can be active at a time.
+struct MatchEngine
+{
+    std::string                                      name;
+    std::filesystem::path                            configPath;
+    std::vector<std::pair<std::string, std::string>> tuneValues;
+    std::unique_ptr<Search::HashTable>               tt;
+
+    std::atomic<uint64_t> numNodes {0};
+    std::atomic<Time>     searchTime {0};
+    std::atomic<uint64_t> numMoves {0};
+};
+
+/// MatchGame is a game slot that plays one game at a time.
+struct MatchGame
+{
+    std::unique_ptr<Search::ThreadPool> pools[2];  // Thread pool of each engine
+    std::unique_ptr<Board>              board;
+    size_t                              gameIndex;
+    int                                 blackEngine;  // Index of the engine playing black
+    Time                                timeLeft[2];
+    bool                                newGame[2];
+    bool                                active = false;
+    bool                                finished;
+    float                               score;  // Score of engine 0 when finished
+
+    int engineToMove() const
+    {
+        return board->sideToMove() == BLACK ? blackEngine : 1 - blackEngine;
+    }
+};
+
+/// Parse tune overrides in the form of "name=value,name=value".
+std::vector<std::pair<std::string, std::string>> parseTuneValues(const std::string &str)
+{
+    std::vector<std::pair<std::string, std::string>> values;
+    std::istringstream                               ss(str);
+    std::string                                      item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty())
+            continue;
+
+        size_t eqPos = item.find('=');
+        if (eqPos == std::string::npos || eqPos == 0)
+            throw std::invalid_argument("invalid tune override " + item);
+        values.emplace_back(item.substr(0, eqPos), item.substr(eqPos + 1));
+    }
+    return values;
+}
+
+/// Mute all output to stdout in its scope, as config loading prints messages.
+struct OutputMuter
+{
+    OutputMuter() { std::cout.setstate(std::ios::failbit); }
+    ~OutputMuter() { std::cout.clear(); }
+};
+
+/// Compute Elo difference and its 95% confidence error bar from the game results.
+std::pair<double, double> computeElo(size_t wins, size_t draws, size_t losses)
+{
+    size_t n = wins + draws + losses;
+    if (n == 0)
+        return {0.0, 0.0};
+
+    auto scoreToElo = [](double s) {
+        s = std::clamp(s, 1e-3, 1 - 1e-3);
+        return -400.0 * std::log10(1.0 / s - 1.0);
+    };
+
+    double score    = (wins + 0.5 * draws) / n;
+    double variance = (wins * std::pow(1.0 - score, 2) + draws * std::pow(0.5 - score, 2)
+                       + losses * std::pow(0.0 - score, 2))
+                      / n;
+    double stderror = std::sqrt(variance / n);
+    double eloLow   = scoreToElo(score - 1.959964 * stderror);
+    double eloHigh  = scoreToElo(score + 1.959964 * stderror);
+    return {scoreToElo(score) + 0.0, (eloHigh - eloLow) / 2};  // Avoid printing -0
+}
+
+}  // namespace
+
+void Command::match(int argc, char *argv[])
+{
+    size_t                        numGames;
+    size_t                        numJobs;
+    size_t                        numThreads;
+    size_t                        hashSizeMb;
+    int                           boardsize;
+    Rule                          rule;
+    Time                          turnTime, matchTime;
+    int                           drawPly;
+    Time                          reportInterval;
+    std::vector<std::vector<Pos>> openings;
+    Opening::OpeningGenConfig     opengenCfg;
+    bool                          generateOpening;
+    MatchEngine                   engines[2];
+    std::ofstream                 timeLogFile;
+    std::mutex                    timeLogMutex;
+
+    cxxopts::Options options("rapfi match");
+    options.add_options()  //
+        ("n,number",
+         "Number of games to play, rounded up to pairs of games with colors reversed",
+         cxxopts::value<size_t>())  //
+        ("config1",
+         "Config file of engine 1 (default to the loaded config)",
+         cxxopts::value<std::string>())  //
+        ("config2",
+         "Config file of engine 2 (default to the loaded config)",
+         cxxopts::value<std::string>())  //
+        ("tune1",
+         "Tune parameter overrides of engine 1, in the form of name=value,name=value",
+         cxxopts::value<std::string>()->default_value(""))  //
+        ("tune2",
+         "Tune parameter overrides of engine 2, in the form of name=value,name=value",
+         cxxopts::value<std::string>()->default_value(""))  //
+        ("j,jobs",
+         "Number of searches running concurrently, each with its own thread pool",
+         cxxopts::value<size_t>()->default_value("1"))  //
+        ("turn-time",
+         "Time (ms) limit of each move",
+         cxxopts::value<Time>()->default_value("1000"))  //
+        ("match-time",
+         "Time (ms) limit of the whole game for each side (0 for no limit)",
+         cxxopts::value<Time>()->default_value("0"))  //
+        ("draw-ply",
+         "Judge draw after this ply (0 for playing until the board is full)",
+         cxxopts::value<int>()->default_value("0"))  //
+        ("opening",
+         "Path to the opening book file. If not specified, auto generated openings are used",
+         cxxopts::value<std::string>())  //
+        ("report-interval",
+         "Time (ms) between two progress report message",
+         cxxopts::value<Time>()->default_value("60000"))  //
+        ("time-log",
+         "Write the time management record of each move to this file (for timetune)",
+         cxxopts::value<std::string>())  //
+        ("h,help", "Print match usage");
+    addPlayOptions(options);
+    addOpengenOptions(options, opengenCfg);
+
+    try {
+        auto args = options.parse(argc, argv);
+
+        if (args.count("help")) {
+            std::cout << options.help() << std::endl;
+            std::exit(EXIT_SUCCESS);
+        }
+
+        numGames       = (args["number"].as<size_t>() + 1) / 2 * 2;
+        numJobs        = std::max<size_t>(args["jobs"].as<size_t>(), 1);
+        numThreads     = std::max<size_t>(args["thread"].as<size_t>(), 1);
+        hashSizeMb     = std::max<size_t>(args["hashsize"].as<size_t>(), 1);
+        boardsize      = args["boardsize"].as<int>();
+        rule           = parseRule(args["rule"].as<std::string>());
+        turnTime       = args["turn-time"].as<Time>();
+        matchTime      = args["match-time"].as<Time>();
+        drawPly        = args["draw-ply"].as<int>();
+        reportInterval = args["report-interval"].as<Time>();
+
+        if (numGames < 2)
+            throw std::invalid_argument("there must be at least one game to play");
+        if (boardsize < 5 || boardsize > MAX_BOARD_SIZE)
+            throw std::invalid_argument("boardsize must be in range [5,22]");
+        if (turnTime <= 0 && matchTime <= 0)
+            throw std::invalid_argument("at least one of turn-time and match-time must be set");
+
+        for (int i = 0; i < 2; i++) {
+            std::string configKey = "config" + std::to_string(i + 1);
+            std::string tuneKey   = "tune" + std::to_string(i + 1);
+            engines[i].configPath = args.count(configKey)
+                                        ? std::filesystem::u8path(args[configKey].as<std::string>())
+                                        : configPath;
+            engines[i].tuneValues = parseTuneValues(args[tuneKey].as<std::string>());
+            engines[i].name       = args.count(configKey) ? args[configKey].as<std::string>()
+                                                          : "engine" + std::to_string(i + 1);
+            for (auto &[name, value] : engines[i].tuneValues)
+                engines[i].name += " " + name + "=" + value;
+        }
+
+        if (args.count("opening")) {
+            std::string   filename = args["opening"].as<std::string>();
+            std::ifstream openingFile(filename);
+            if (!openingFile.is_open())
+                throw std::invalid_argument("unable to open opening file " + filename);
+
+            openings        = readOpenings(openingFile, boardsize);
+            generateOpening = false;
+            if (openings.empty())
+                throw std::invalid_argument("no opening in opening file " + filename);
+        }
+        else {
+            opengenCfg      = parseOpengenConfig(args);
+            generateOpening = true;
+        }
+
+        if (args.count("time-log")) {
+            std::string filename = args["time-log"].as<std::string>();
+            timeLogFile.open(filename);
+            if (!timeLogFile.is_open())
+                throw std::invalid_argument("unable to open time log file " + filename);
+            timeLogFile << "# game engine turnTime matchTime matchTimeLeft ply movesLeft "
+                           "optimum maximum used numIterations [iterations...]\n";
+        }
+    }
+    catch (const std::exception &e) {
+        ERRORL("match argument: " << e.what());
+        std::exit(EXIT_FAILURE);
+    }
+
+#ifndef MULTI_THREADING
+    numJobs = 1;
+#endif
+    Config::MessageMode = MsgMode::NONE;
+    Search::Threads.setNumThreads(numThreads);
+    Search::Threads.searcher()->setMemoryLimit(hashSizeMb * 1024);
+    Search::Threads.clear(true);
+
+    // Prepare one opening with a random transform for each pair of games
+    PRNG                          prng {};
+    std::vector<std::vector<Pos>> gameOpenings;
+    for (size_t i = 0; i < numGames / 2; i++) {
+        std::vector<Pos> &opening = gameOpenings.emplace_back();
+
+        if (generateOpening) {
+            Opening::OpeningGenerator og(boardsize, rule, opengenCfg, prng);
+            while (!og.next() && opengenCfg.balanceWindow > 0
+                   && (opengenCfg.balance1Nodes > 0 || opengenCfg.balance2Nodes > 0))
+                ;
+            for (int ply = 0; ply < og.getBoard().ply(); ply++)
+                opening.push_back(og.getBoard().getHistoryMove(ply));
+        }
+        else {
+            std::uniform_int_distribution<size_t> openingDis(0, openings.size() - 1);
+            std::uniform_int_distribution<int>    transformDis(0, TRANS_NB - 1);
+            size_t                                openingIdx = openingDis(prng);
+            TransformType                         transform  = TransformType(transformDis(prng));
+            for (Pos pos : openings[openingIdx])
+                opening.push_back(applyTransform(pos, boardsize, transform));
+        }
+    }
+    MESSAGEL("Prepared " << gameOpenings.size() << " openings for " << numGames << " games.");
+
+    // Collect base values of all tuned parameters, to restore them for the other engine
+    std::vector<std::pair<std::string, std::string>> baseTuneValues;
+    if (!engines[0].tuneValues.empty() || !engines[1].tuneValues.empty()) {
+        Tuning::TuneMap::init();
+        for (auto &engine : engines)
+            for (auto &[name, value] : engine.tuneValues) {
+                std::ostringstream os;
+                if (!Tuning::TuneMap::tryWriteOption(name, os)) {
+                    ERRORL("match argument: unknown tune parameter " << name);
+                    std::exit(EXIT_FAILURE);
+                }
+                baseTuneValues.emplace_back(name, os.str());
+            }
+    }
+
+    // Each engine keeps its own transposition table, which is swapped into the global
+    // table when the engine becomes active. The global one holds a placeholder otherwise.
+    for (auto &engine : engines)
+        engine.tt = std::make_unique<Search::HashTable>(hashSizeMb * 1024);
+
+    int  activeEngine = -1;
+    auto activate     = [&](int e) {
+        if (activeEngine == e)
+            return;
+        if (activeEngine >= 0)
+            Search::TT.swap(*engines[activeEngine].tt);
+
+        // Reload config only if it differs from the config loaded now
+        if (activeEngine >= 0 ? engines[activeEngine].configPath != engines[e].configPath
+                                  : engines[e].configPath != configPath) {
+            bool success;
+            {
+                OutputMuter muter;
+                configPath = engines[e].configPath;
+                success    = loadConfig();
+            }
+            if (!success) {
+                ERRORL("Failed to load config " << pathToConsoleString(configPath));
+                std::exit(EXIT_FAILURE);
+            }
+            Config::MessageMode = MsgMode::NONE;
+        }
+
+        for (auto &[name, value] : baseTuneValues) {
+            auto it = std::find_if(engines[e].tuneValues.begin(),
+                                   engines[e].tuneValues.end(),
+                                   [&](auto &kv) { return kv.first == name; });
+            std::istringstream is(it != engines[e].tuneValues.end() ? it->second : value);
+            Tuning::TuneMap::tryReadOption(name, is);
+        }
+
+        Search::TT.swap(*engines[e].tt);
+        activeEngine = e;
+    };
+
+    // Create thread pools of each engine for all game slots, with at most numJobs
+    // concurrent searches for each engine in a pair of games
+    std::vector<MatchGame> games(std::min(numGames, numJobs * 2));
+    for (int e = 0; e < 2; e++) {
+        activate(e);
+        for (auto &game : games) {
+            game.pools[e] = std::make_unique<Search::ThreadPool>();
+            game.pools[e]->setupEvaluator(Search::Threads.evaluatorMakerFunc());
+            game.pools[e]->setNumThreads(numThreads);
+        }
+    }
+
+    size_t nextGameIndex = 0;
+    auto   startNewGame  = [&](MatchGame &game) {
+        game.active = nextGameIndex < numGames;
+        if (!game.active)
+            return;
+
+        game.board = std::make_unique<Board>(boardsize);
+        game.board->newGame(rule);
+        for (Pos pos : gameOpenings[nextGameIndex / 2])
+            game.board->move(rule, pos);
+
+        game.gameIndex   = nextGameIndex;
+        game.blackEngine = nextGameIndex % 2;
+        game.timeLeft[0] = game.timeLeft[1] = matchTime;
+        game.newGame[0] = game.newGame[1] = true;
+        game.finished                     = false;
+        nextGameIndex++;
+    };
+
+    // Play one move of the engine in the game, and judge if the game is finished
+    auto playMove = [&](MatchGame &game, int e) {
+        Search::ThreadPool &pool = *game.pools[e];
+        if (game.newGame[e]) {
+            pool.clear(false);
+            game.newGame[e] = false;
+        }
+
+        Search::SearchOptions options;
+        options.rule                = {rule, GameRule::FREEOPEN};
+        options.disableOpeningQuery = true;
+        options.setTimeControl(turnTime, matchTime);
+        if (matchTime > 0)
+            options.timeLeft = std::max<Time>(game.timeLeft[e], 0);
+
+        Time startTime = now();
+        pool.startThinking(*game.board, options);
+        pool.waitForIdle();
+        Time elapsed = now() - startTime;
+
+        engines[e].numNodes += pool.nodesSearched();
+        engines[e].searchTime += elapsed;
+        engines[e].numMoves++;
+
+        const Search::TimeControl *timectl = pool.searcher()->timeControl();
+        if (timeLogFile.is_open() && timectl && !timectl->record().iterations.empty()) {
+            std::lock_guard<std::mutex> lock(timeLogMutex);
+            timeLogFile << game.gameIndex << ' ' << e << ' ' << timectl->record() << '\n';
+        }
+
+        Board &board = *game.board;
+        Color  side  = board.sideToMove();
+        Pos    move  = pool.main()->bestMove;
+        auto   judge = [&](bool engineWins) {
+            game.finished = true;
+            game.score    = (e == 0) == engineWins ? 1.0f : 0.0f;
+        };
+
+        // Lose on time, illegal move or forbidden move
+        game.timeLeft[e] -= elapsed;
+        if ((matchTime > 0 && game.timeLeft[e] < 0) || !board.isInBoard(move)
+            || !board.isEmpty(move)
+            || (rule == RENJU && side == BLACK && board.checkForbiddenPoint(move)))
+            return judge(false);
+
+        bool makesFive = board.cell(move).pattern4[side] == A_FIVE;
+        board.move(rule, move);
+        if (makesFive)
+            return judge(true);
+
+        if (board.movesLeft() == 0 || (drawPly && board.ply() >= drawPly)) {
+            game.finished = true;
+            game.score    = 0.5f;
+        }
+    };
+
+    size_t wins = 0, draws = 0, losses = 0;
+    auto   printResult = [&]() {
+        auto [elo, eloError] = computeElo(wins, draws, losses);
+        size_t numPlayed     = wins + draws + losses;
+        double los           = wins + losses
+                                   ? 0.5 * (1 + std::erf((double(wins) - losses)
+                                                         / std::sqrt(2.0 * (wins + losses))))
+                                   : 0.5;
+        MESSAGEL("Played " << numPlayed << " of " << numGames << " games: " << engines[0].name
+                           << " vs " << engines[1].name << " = " << wins << " - " << draws
+                           << " - " << losses << " [W-D-L], Elo " << elo << " +- " << eloError
+                           << " (95%), LOS " << los * 100 << "%");
+        for (auto &engine : engines) {
+            Time searchTime = std::max<Time>(engine.searchTime, 1);
+            MESSAGEL(engine.name << ": nps = " << engine.numNodes * 1000 / searchTime
+                                 << ", nodes/move = "
+                                 << engine.numNodes / std::max<uint64_t>(engine.numMoves, 1));
+        }
+    };
+
+    for (auto &game : games)
+        startNewGame(game);
+
+    // All games are played in lockstep. In each round, every unfinished game makes one move
+    // by engine 1 then by engine 2, so that only one engine is active at a time.
+    Time startTime = now(), lastTime = startTime;
+    while (std::any_of(games.begin(), games.end(), [](auto &g) { return g.active; })) {
+        for (int e = 0; e < 2; e++) {
+            activate(e);
+
+            std::vector<MatchGame *> gamesToMove;
+            for (auto &game : games)
+                if (game.active && !game.finished && game.engineToMove() == e)
+                    gamesToMove.push_back(&game);
+
+            std::atomic<size_t> nextIndex {0};
+            auto                runJob = [&]() {
+                for (size_t i; (i = nextIndex.fetch_add(1)) < gamesToMove.size();)
+                    playMove(*gamesToMove[i], e);
+            };
+#ifdef MULTI_THREADING
+            std::vector<std::thread> jobs;
+            for (size_t i = 1; i < std::min(numJobs, gamesToMove.size()); i++)
+                jobs.emplace_back(runJob);
+            runJob();
+            for (auto &job : jobs)
+                job.join();
+#else
+            runJob();
+#endif
+        }
+
+        for (auto &game : games) {
+            if (!game.active || !game.finished)
+                continue;
+
+            wins += game.score == 1.0f;
+            draws += game.score == 0.5f;
+            losses += game.score == 0.0f;
+            startNewGame(game);
+        }
+
+        if (now() - lastTime >= reportInterval) {
+            printResult();
+            lastTime = now();
+        }
+    }
+
+    // Restore the global transposition table before all engine tables are released
+    if (activeEngine >= 0)
+        Search::TT.swap(*engines[activeEngine].tt);
+
+    MESSAGEL("Completed playing " << numGames << " games in " << (now() - startTime) / 1000.0
+                                  << " s.");
+    printResult();
+}
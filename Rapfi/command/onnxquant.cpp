@@ -0,0 +1,372 @@
+/*
+ *  Rapfi, a Gomoku/Renju playing engine supporting piskvork protocol.
+ *  Copyright (C) 2022  Rapfi developers
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../core/iohelper.h"
+#include "../core/utils.h"
+#include "../game/board.h"
+#include "../tuning/dataset.h"
+#include "argutils.h"
+#include "command.h"
+
+#ifdef USE_ORT_EVALUATOR
+    #include "../eval/onnxevaluator.h"
+#endif
+
+#define CXXOPTS_NO_REGEX
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cxxopts.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <npy.hpp>
+#include <stdexcept>
+
+using namespace Tuning;
+
+namespace {
+
+/// Options of the onnx quantization utility.
+struct QuantOptions
+{
+    std::string              action;
+    std::vector<std::string> datasetPaths;
+    Command::DatasetType     datasetType;
+    int                      boardSize;
+    Rule                     rule;
+    size_t                   numPositions;
+    uint64_t                 seed;
+    std::string              outputPath;
+    std::string              floatModelPath;
+    std::string              quantModelPath;
+    std::string              device;
+};
+
+/// Samples positions of the given board size and rule uniformly from the dataset
+/// with reservoir sampling, so that the whole dataset need not to fit in memory.
+std::vector<std::vector<Pos>> samplePositions(Dataset &dataset, const QuantOptions &opt)
+{
+    std::vector<std::vector<Pos>> positions;
+    PRNG                          prng(opt.seed);
+    size_t                        numMatched = 0;
+    DataEntry                     entry;
+
+    while (dataset.next(&entry)) {
+        if (entry.boardsize != opt.boardSize || entry.rule != opt.rule)
+            continue;
+
+        if (positions.size() < opt.numPositions)
+            positions.push_back(entry.position);
+        else {
+            size_t index = prng() % (numMatched + 1);
+            if (index < opt.numPositions)
+                positions[index] = entry.position;
+        }
+        numMatched++;
+    }
+
+    MESSAGEL("Sampled " << positions.size() << " positions from " << numMatched
+                        << " matched entries (boardsize " << opt.boardSize << ", rule "
+                        << opt.rule << ").");
+    return positions;
+}
+
+/// Writes the input tensors of a position in the rapfi_model_v1 onnx IO layout:
+/// board_input is [2, H, W] int8 with self and oppo planes of the side to move,
+/// and global_input is [1] float with -1.0 for black and 1.0 for white to move.
+void encodeModelInputs(const Board &board, int8_t *boardInput, float *globalInput)
+{
+    const int   numCells = board.size() * board.size();
+    const Color self     = board.sideToMove();
+
+    for (int y = 0; y < board.size(); y++)
+        for (int x = 0; x < board.size(); x++) {
+            Color c = board.get(Pos {x, y});
+            boardInput[0 * numCells + y * board.size() + x] = c == self;
+            boardInput[1 * numCells + y * board.size() + x] = c == ~self;
+        }
+
+    globalInput[0] = self == BLACK ? -1.0f : 1.0f;
+}
+
+/// Writes the calibration inputs of all sampled positions into a npz file, whose
+/// entries are named after the model inputs so that they can be fed directly to a
+/// static quantization calibration reader.
+void writeCalibrationData(const std::vector<std::vector<Pos>> &positions,
+                          const QuantOptions                  &opt)
+{
+    const unsigned long numEntries = positions.size();
+    const unsigned long boardSize  = opt.boardSize;
+
+    std::vector<int8_t>        boardInput(numEntries * 2 * boardSize * boardSize);
+    std::vector<float>         globalInput(numEntries * 1);
+    std::vector<unsigned long> boardInputShape {numEntries, 2, boardSize, boardSize};
+    std::vector<unsigned long> globalInputShape {numEntries, 1};
+
+    Board board(opt.boardSize);
+    for (size_t i = 0; i < positions.size(); i++) {
+        board.newGame(opt.rule);
+        for (Pos pos : positions[i])
+            board.move(opt.rule, pos);
+
+        encodeModelInputs(board,
+                          boardInput.data() + i * 2 * boardSize * boardSize,
+                          globalInput.data() + i * 1);
+    }
+
+    std::ofstream file(opt.outputPath, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("can not open output file: " + opt.outputPath);
+
+    Compressor compressor(file, Compressor::Type::ZIP_DEFAULT);
+    auto openEntryAndWrite = [&](std::string entryName, const auto &data, const auto &shape) {
+        std::ostream *os = compressor.openOutputStream(entryName);
+        if (!os)
+            throw std::runtime_error("unable to write " + entryName + " in zip");
+        npy::SaveArrayAsNumpy(*os, false, shape.size(), shape.data(), data);
+        compressor.closeStream(*os);
+    };
+
+    openEntryAndWrite("board_input", boardInput, boardInputShape);
+    openEntryAndWrite("global_input", globalInput, globalInputShape);
+
+    MESSAGEL("Wrote " << numEntries << " calibration positions to " << opt.outputPath);
+}
+
+#ifdef USE_ORT_EVALUATOR
+
+/// Evaluation outputs of one model over all sampled positions.
+struct ModelOutputs
+{
+    std::vector<std::array<float, 3>> wld;        // win-loss-draw probability
+    std::vector<Pos>                  bestPolicy;  // top-1 policy move
+    double                            evalSeconds = 0.0;
+};
+
+/// Evaluates all positions with an onnx evaluator. Only the value and policy inference
+/// is timed, while replaying the position into the evaluator is not.
+ModelOutputs evaluateModel(const std::vector<std::vector<Pos>> &positions,
+                           const std::string                   &modelPath,
+                           const QuantOptions                  &opt)
+{
+    using namespace Evaluation;
+
+    onnx::OnnxEvaluator evaluator(opt.boardSize,
+                                  opt.rule,
+                                  Numa::DefaultNumaNodeId,
+                                  Command::getModelFullPath(modelPath),
+                                  opt.device);
+    ModelOutputs        outputs;
+    Board               board(opt.boardSize);
+    PolicyBuffer        policyBuffer(opt.boardSize);
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        board.newGame(opt.rule);
+        for (Pos pos : positions[i])
+            board.move(opt.rule, pos);
+        evaluator.syncWithBoard(board);
+
+        // The first inference also includes the lazy session warmup, thus not timed
+        auto      start = std::chrono::steady_clock::now();
+        ValueType value = evaluator.evaluateValue(board);
+        evaluator.evaluatePolicy(board, policyBuffer);
+        auto end = std::chrono::steady_clock::now();
+        if (i > 0)
+            outputs.evalSeconds += std::chrono::duration<double>(end - start).count();
+
+        Pos   bestMove   = Pos::NONE;
+        float bestPolicy = std::numeric_limits<float>::lowest();
+        FOR_EVERY_EMPTY_POS(&board, pos)
+        {
+            if (policyBuffer[pos] > bestPolicy) {
+                bestPolicy = policyBuffer[pos];
+                bestMove   = pos;
+            }
+        }
+
+        outputs.wld.push_back({value.win(), value.loss(), value.draw()});
+        outputs.bestPolicy.push_back(bestMove);
+    }
+
+    return outputs;
+}
+
+/// Compares a quantized model against its float model and prints the report.
+void compareModels(const std::vector<std::vector<Pos>> &positions, const QuantOptions &opt)
+{
+    if (positions.empty())
+        throw std::runtime_error("no positions to compare");
+
+    ModelOutputs floatOutputs = evaluateModel(positions, opt.floatModelPath, opt);
+    ModelOutputs quantOutputs = evaluateModel(positions, opt.quantModelPath, opt);
+
+    double valueSquaredError = 0.0, winrateAbsError = 0.0;
+    size_t numPolicyAgreed   = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        const auto &f = floatOutputs.wld[i], &q = quantOutputs.wld[i];
+        for (int k = 0; k < 3; k++)
+            valueSquaredError += double(f[k] - q[k]) * double(f[k] - q[k]) / 3;
+        winrateAbsError += std::abs((f[0] - f[1]) - (q[0] - q[1])) * 0.5;
+        numPolicyAgreed += floatOutputs.bestPolicy[i] == quantOutputs.bestPolicy[i];
+    }
+
+    const size_t numTimed       = positions.size() - 1;
+    const double floatEvalSpeed = numTimed / std::max(floatOutputs.evalSeconds, 1e-9);
+    const double quantEvalSpeed = numTimed / std::max(quantOutputs.evalSeconds, 1e-9);
+
+    MESSAGEL("===============================================");
+    MESSAGEL("Positions            : " << positions.size());
+    MESSAGEL("Value MSE (wld)      : " << valueSquaredError / positions.size());
+    MESSAGEL("Winrate MAE          : " << winrateAbsError / positions.size());
+    MESSAGEL("Policy top-1 agreed  : " << std::fixed << std::setprecision(2)
+                                       << 100.0 * numPolicyAgreed / positions.size() << "%");
+    MESSAGEL("Float evals/s        : " << std::fixed << std::setprecision(1) << floatEvalSpeed);
+    MESSAGEL("Quantized evals/s    : " << std::fixed << std::setprecision(1) << quantEvalSpeed);
+    MESSAGEL("Speedup              : " << std::fixed << std::setprecision(3)
+                                       << quantEvalSpeed / floatEvalSpeed);
+    MESSAGEL("===============================================");
+}
+
+#endif
+
+}  // namespace
+
+void Command::onnxquant(int argc, char *argv[])
+{
+    QuantOptions opt;
+
+    cxxopts::Options options(
+        "rapfi onnx quantization utility",
+        "\nPreparing and validating statically quantized int8 onnx models."
+        "\n  calibrate: Samples positions from a dataset and writes a npz with the model"
+        "\n             inputs 'board_input' [N,2,S,S] int8 and 'global_input' [N,1] float,"
+        "\n             to be used as the calibration data of static quantization. Set the"
+        "\n             model metadata 'quantization' to mark the resulting quantized model."
+        "\n  compare:   Reports value MSE, policy top-1 agreement and evals/s of a quantized"
+        "\n             model against its float model on the sampled positions.");
+    options.add_options()  //
+        ("a,action",
+         "One of [calibrate, compare]",
+         cxxopts::value<std::string>()->default_value("calibrate"))  //
+        ("i,input",
+         "Input dataset filename/directory(s)",
+         cxxopts::value<std::vector<std::string>>())  //
+        ("input-type",
+         "Input dataset type, one of [bin, binpack, katago]",
+         cxxopts::value<std::string>()->default_value("binpack"))  //
+        ("dataset-file-extensions",
+         "Extensions to filter dataset file in a directory",
+         cxxopts::value<std::vector<std::string>>()->default_value(".bin,.binpack,.lz4,.npz"))  //
+        ("s,boardsize",
+         "Board size of sampled positions",
+         cxxopts::value<int>()->default_value("15"))  //
+        ("r,rule",
+         "Rule of sampled positions, one of [freestyle, standard, renju]",
+         cxxopts::value<std::string>()->default_value("freestyle"))  //
+        ("n,num-positions",
+         "Number of positions to sample",
+         cxxopts::value<size_t>()->default_value("1000"))  //
+        ("seed", "Random seed of sampling", cxxopts::value<uint64_t>()->default_value("42"))  //
+        ("o,output",
+         "Output calibration npz filename",
+         cxxopts::value<std::string>()->default_value("calibration.npz"))  //
+        ("float-model", "Float onnx model filename", cxxopts::value<std::string>())  //
+        ("quant-model", "Quantized onnx model filename", cxxopts::value<std::string>())  //
+        ("device",
+         "Onnx device to run models",
+         cxxopts::value<std::string>()->default_value("cpu"))  //
+        ("h,help", "Print onnxquant usage");
+
+    try {
+        auto args = options.parse(argc, argv);
+
+        if (args.count("help")) {
+            std::cout << options.help() << std::endl;
+            std::exit(EXIT_SUCCESS);
+        }
+
+        if (!args.count("input"))
+            throw std::invalid_argument("there must be at least one input dataset");
+
+        opt.action       = args["action"].as<std::string>();
+        opt.datasetPaths = makeFileListFromPathList(
+            args["input"].as<std::vector<std::string>>(),
+            args["dataset-file-extensions"].as<std::vector<std::string>>());
+        opt.datasetType  = parseDatasetType(args["input-type"].as<std::string>());
+        opt.boardSize    = args["boardsize"].as<int>();
+        opt.rule         = parseRule(args["rule"].as<std::string>());
+        opt.numPositions = args["num-positions"].as<size_t>();
+        opt.seed         = args["seed"].as<uint64_t>();
+        opt.outputPath   = args["output"].as<std::string>();
+        opt.device       = args["device"].as<std::string>();
+
+        upperInplace(opt.action);
+        if (opt.action == "COMPARE") {
+            if (!args.count("float-model") || !args.count("quant-model"))
+                throw std::invalid_argument("compare action requires float-model and quant-model");
+            opt.floatModelPath = args["float-model"].as<std::string>();
+            opt.quantModelPath = args["quant-model"].as<std::string>();
+#ifndef USE_ORT_EVALUATOR
+            throw std::invalid_argument("onnx runtime evaluator is not enabled in this build");
+#endif
+        }
+        else if (opt.action != "CALIBRATE")
+            throw std::invalid_argument("unknown action " + opt.action);
+
+        if (opt.boardSize < 5 || opt.boardSize > MAX_BOARD_SIZE)
+            throw std::invalid_argument("boardsize must be in range [5, "
+                                        + std::to_string(MAX_BOARD_SIZE) + "]");
+        if (opt.numPositions == 0)
+            throw std::invalid_argument("num-positions must be greater than 0");
+    }
+    catch (const std::exception &e) {
+        ERRORL("onnxquant argument: " << e.what());
+        std::exit(EXIT_FAILURE);
+    }
+
+    try {
+        std::unique_ptr<Dataset> dataset;
+        switch (opt.datasetType) {
+        case Command::DatasetType::SimpleBinary:
+            dataset = std::make_unique<SimpleBinaryDataset>(opt.datasetPaths);
+            break;
+        case Command::DatasetType::PackedBinary:
+            dataset = std::make_unique<PackedBinaryDataset>(opt.datasetPaths);
+            break;
+        case Command::DatasetType::KatagoNumpy:
+            dataset = std::make_unique<KatagoNumpyDataset>(opt.datasetPaths, opt.rule);
+            break;
+        }
+
+        auto positions = samplePositions(*dataset, opt);
+
+        if (opt.action == "CALIBRATE")
+            writeCalibrationData(positions, opt);
+#ifdef USE_ORT_EVALUATOR
+        else
+            compareModels(positions, opt);
+#endif
+    }
+    catch (const std::exception &e) {
+        ERRORL("Error occurred in onnxquant: " << e.what());
+        std::exit(EXIT_FAILURE);
+    }
+}
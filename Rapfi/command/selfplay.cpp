@@ -20,6 +20,7 @@
 #include "../core/utils.h"
 #include "../search/hashtable.h"
 #include "../search/searchthread.h"
+#include "../search/timecontrol.h"
 #include "../tuning/datawriter.h"
 #include "argutils.h"
 #include "command.h"
@@ -56,33 +57,6 @@ static void                  setupSignalHandler(std::function<void()> handler)
 #endif
 }
 
-namespace {
-
-std::vector<std::vector<Pos>> readOpenings(std::istream &is, int boardSize)
-{
-    std::vector<std::vector<Pos>> ops;
-    std::string                   opStr;
-    size_t                        lineCount = 0;
-
-    while (std::getline(is, opStr)) {
-        lineCount++;
-        if (opStr.empty())
-            continue;
-
-        try {
-            ops.push_back(Command::parsePositionString(opStr, boardSize, boardSize));
-        }
-        catch (const std::exception &e) {
-            throw std::runtime_error("illegal opening [line " + std::to_string(lineCount)
-                                     + "]: " + e.what());
-        }
-    }
-
-    return ops;
-}
-
-}  // namespace
-
 using namespace Tuning;
 
 void Command::selfplay(int argc, char *argv[])
@@ -108,6 +82,7 @@ void Command::selfplay(int argc, char *argv[])
     DataWriterType                dataWriterType;
     std::string                   outputPath;
     std::unique_ptr<DataWriter>   dataWriter;
+    std::ofstream                 timeLogFile;
 
     cxxopts::Options options("rapfi selfplay");
     options.add_options()  //
@@ -170,6 +145,9 @@ void Command::selfplay(int argc, char *argv[])
         ("report-interval",
          "Time (ms) between two progress report message",
          cxxopts::value<Time>()->default_value("60000"))  //
+        ("time-log",
+         "Write the time management record of each move to this file (for timetune)",
+         cxxopts::value<std::string>())  //
         ("h,help", "Print selfplay usage");
     addPlayOptions(options);
     addOpengenOptions(options, opengenCfg);
@@ -240,6 +218,15 @@ void Command::selfplay(int argc, char *argv[])
         reportInterval    = args["report-interval"].as<Time>();
         silence           = args.count("no-search-message");
 
+        if (args.count("time-log")) {
+            std::string filename = args["time-log"].as<std::string>();
+            timeLogFile.open(filename);
+            if (!timeLogFile.is_open())
+                throw std::invalid_argument("unable to open time log file " + filename);
+            timeLogFile << "# game side turnTime matchTime matchTimeLeft ply movesLeft "
+                           "optimum maximum used numIterations [iterations...]\n";
+        }
+
         if (meanNodes <= 0)
             throw std::invalid_argument("mean-nodes must be greater than 0");
         if (matePly < 1)
@@ -294,6 +281,7 @@ void Command::selfplay(int argc, char *argv[])
     setupSignalHandler([&]() {
         MESSAGEL("Gracefully exiting...");
         dataWriter.reset();
+        timeLogFile.close();
         std::exit(0);
     });
 
@@ -401,6 +389,11 @@ void Command::selfplay(int argc, char *argv[])
             Search::Threads.waitForIdle();
             auto mainThread = Search::Threads.main();
 
+            const Search::TimeControl *timectl = Search::Threads.searcher()->timeControl();
+            if (timeLogFile.is_open() && timectl && !timectl->record().iterations.empty())
+                timeLogFile << i << ' ' << int(board.sideToMove()) << ' ' << timectl->record()
+                            << '\n';
+
             // We might have no legal move in Renju mode, which is regarded as loss
             if (mainThread->rootMoves.empty()) {
                 searchValue = mated_in(0);
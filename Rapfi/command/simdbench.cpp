@@ -0,0 +1,839 @@
+/*
+ *  Rapfi, a Gomoku/Renju playing engine supporting piskvork protocol.
+ *  Copyright (C) 2022  Rapfi developers
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../core/iohelper.h"
+#include "../core/platform.h"
+#include "../core/utils.h"
+#include "../eval/mix10nnue.h"
+#include "../eval/mix9svqnnue.h"
+#include "../eval/simdops.h"
+#include "command.h"
+
+#define CXXOPTS_NO_REGEX
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cxxopts.hpp>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <xxhash.h>
+
+using namespace Evaluation;
+using simd::InstructionType;
+
+namespace {
+
+/// All bench buffers are allocated with this alignment, so that every kernel
+/// instantiation can use its aligned load/store path regardless of the native ISA.
+constexpr int BenchAlignment = 64;
+
+/// Returns the display name of an instruction type. SSE and AVX2 paths are always
+/// compiled (through simde), but are marked as emulated if the host build lacks them.
+std::string instTypeName(InstructionType inst)
+{
+    switch (inst) {
+    case simd::SCALAR: return "SCALAR";
+#ifdef USE_SSE
+    case simd::SSE: return "SSE";
+#else
+    case simd::SSE: return "SSE*";
+#endif
+#ifdef USE_AVX2
+    case simd::AVX2: return "AVX2";
+#else
+    case simd::AVX2: return "AVX2*";
+#endif
+    case simd::AVX512: return "AVX512";
+    case simd::NEON: return "NEON";
+    case simd::WASM_SIMD: return "WASM_SIMD";
+    default: return "UNKNOWN";
+    }
+}
+
+/// Invoke f(std::integral_constant<InstructionType, I>) for every instruction
+/// type that has been compiled into this binary, starting from SCALAR.
+template <typename Func>
+void forEachInstType(Func &&f)
+{
+    f(std::integral_constant<InstructionType, simd::SCALAR> {});
+    f(std::integral_constant<InstructionType, simd::SSE> {});
+    f(std::integral_constant<InstructionType, simd::AVX2> {});
+#ifdef USE_AVX512
+    f(std::integral_constant<InstructionType, simd::AVX512> {});
+#endif
+#ifdef USE_NEON
+    f(std::integral_constant<InstructionType, simd::NEON> {});
+#endif
+#ifdef USE_WASM_SIMD
+    f(std::integral_constant<InstructionType, simd::WASM_SIMD> {});
+#endif
+}
+
+/// Prevent the compiler from caching memory contents across benchmark iterations.
+inline void clobberMemory()
+{
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+    asm volatile("" : : : "memory");
+#elif defined(_MSC_VER)
+    _ReadWriteBarrier();
+#endif
+}
+
+/// A 64-byte aligned byte buffer that can be copied by value.
+class AlignedBuffer
+{
+public:
+    explicit AlignedBuffer(size_t size = 0)
+        : size_(size)
+        , data_(size ? static_cast<uint8_t *>(MemAlloc::alignedAlloc(
+                           BenchAlignment,
+                           simd::alignDimSize<BenchAlignment, uint8_t>(size)))
+                     : nullptr)
+    {
+        if (data_)
+            std::memset(data_, 0, size_);
+    }
+    AlignedBuffer(const AlignedBuffer &other) : AlignedBuffer(other.size_)
+    {
+        if (data_ && other.data_)
+            std::memcpy(data_, other.data_, size_);
+    }
+    AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+    ~AlignedBuffer()
+    {
+        if (data_)
+            MemAlloc::alignedFree(data_);
+    }
+
+    size_t size() const { return size_; }
+    template <typename T>
+    T *as() const
+    {
+        return reinterpret_cast<T *>(data_);
+    }
+    bool operator==(const AlignedBuffer &other) const
+    {
+        return size_ == other.size_ && (!size_ || std::memcmp(data_, other.data_, size_) == 0);
+    }
+
+private:
+    size_t   size_;
+    uint8_t *data_;
+};
+
+/// Operands of one kernel invocation. Kernels decide how each buffer is used.
+struct KernelData
+{
+    AlignedBuffer input0, input1, weight, bias, output;
+};
+
+/// Fill a buffer with uniformly distributed random integers in [lo, hi].
+template <typename T>
+void fillRandom(PRNG &prng, const AlignedBuffer &buf, int lo, int hi)
+{
+    T     *ptr = buf.as<T>();
+    size_t n   = buf.size() / sizeof(T);
+    for (size_t i = 0; i < n; i++)
+        ptr[i] = static_cast<T>(lo + static_cast<int>(prng() % uint64_t(hi - lo + 1)));
+}
+
+// -------------------------------------------------
+// Kernel definitions
+//
+// Every kernel provides:
+//   - Bytes/Ops: memory traffic and integer operations of one invocation
+//   - make(prng): random operands that respect the input range contract of the kernel
+//   - prepare<I>(data): ISA-dependent weight preprocessing
+//   - run<I>(data): the kernel invocation itself, writing to data.output
+
+template <int Size, typename T>
+struct ZeroKernel
+{
+    static constexpr double Bytes = Size * sizeof(T);
+    static constexpr double Ops   = Size;
+
+    static KernelData make(PRNG &prng)
+    {
+        KernelData d {AlignedBuffer(), AlignedBuffer(), AlignedBuffer(), AlignedBuffer(),
+                      AlignedBuffer(Size * sizeof(T))};
+        fillRandom<T>(prng, d.output, -128, 127);
+        return d;
+    }
+    template <InstructionType I>
+    static void prepare(KernelData &)
+    {}
+    template <InstructionType I>
+    static void run(KernelData &d)
+    {
+        simd::zero<Size, T, BenchAlignment, I>(d.output.as<T>());
+    }
+};
+
+template <int Size, typename T>
+struct CopyKernel
+{
+    static constexpr double Bytes = 2 * Size * sizeof(T);
+    static constexpr double Ops   = Size;
+
+    static KernelData make(PRNG &prng)
+    {
+        KernelData d {AlignedBuffer(Size * sizeof(T)), AlignedBuffer(), AlignedBuffer(),
+                      AlignedBuffer(), AlignedBuffer(Size * sizeof(T))};
+        fillRandom<T>(prng, d.input0, -32768, 32767);
+        return d;
+    }
+    template <InstructionType I>
+    static void prepare(KernelData &)
+    {}
+    template <InstructionType I>
+    static void run(KernelData &d)
+    {
+        simd::copy<Size, T, BenchAlignment, I>(d.output.as<T>(), d.input0.as<T>());
+    }
+};
+
+template <int Size, typename T>
+struct AddKernel
+{
+    static constexpr double Bytes = 3 * Size * sizeof(T);
+    static constexpr double Ops   = Size;
+
+    static KernelData make(PRNG &prng)
+    {
+        KernelData d {AlignedBuffer(Size * sizeof(T)), AlignedBuffer(Size * sizeof(T)),
+                      AlignedBuffer(), AlignedBuffer(), AlignedBuffer(Size * sizeof(T))};
+        fillRandom<T>(prng, d.input0, -16384, 16383);
+        fillRandom<T>(prng, d.input1, -16384, 16383);
+        return d;
+    }
+    template <InstructionType I>
+    static void prepare(KernelData &)
+    {}
+    template <InstructionType I>
+    static void run(KernelData &d)
+    {
+        simd::add<Size, T, BenchAlignment, I>(d.output.as<T>(),
+                                              d.input0.as<T>(),
+                                              d.input1.as<T>());
+    }
+};
+
+/// Clipped relu from int32 to int8/int16. WidthBits limits the instruction width
+/// as done by the callers whose output is narrower than the native register.
+template <int Size, int Divisor, bool NoReLU, typename OutT, size_t WidthBits = 512>
+struct CReLUKernel
+{
+    static constexpr double Bytes = Size * (sizeof(int32_t) + sizeof(OutT));
+    static constexpr double Ops   = Size;
+
+    static KernelData make(PRNG &prng)
+    {
+        KernelData d {AlignedBuffer(Size * sizeof(int32_t)), AlignedBuffer(), AlignedBuffer(),
+                      AlignedBuffer(), AlignedBuffer(Size * sizeof(OutT))};
+        // Cover the saturation range on both sides of the output type
+        int64_t range = int64_t(Divisor) * (std::is_same_v<OutT, int8_t> ? 256 : 65536);
+        range         = std::min<int64_t>(range, 1 << 30);
+        fillRandom<int32_t>(prng, d.input0, -int(range), int(range));
+        return d;
+    }
+    template <InstructionType I>
+    static void prepare(KernelData &)
+    {}
+    template <InstructionType I>
+    static void run(KernelData &d)
+    {
+        constexpr InstructionType Inst = simd::getInstTypeOfWidth(I, WidthBits);
+        simd::crelu<Size, Divisor, NoReLU, BenchAlignment, Inst>(d.output.as<OutT>(),
+                                                                 d.input0.as<int32_t>());
+    }
+};
+
+template <int OutSize, int Divisor>
+struct Dot2Kernel
+{
+    static constexpr double Bytes = OutSize * 5;
+    static constexpr double Ops   = OutSize * 4;
+
+    static KernelData make(PRNG &prng)
+    {
+        KernelData d {AlignedBuffer(OutSize * 2), AlignedBuffer(OutSize * 2), AlignedBuffer(),
+                      AlignedBuffer(), AlignedBuffer(OutSize)};
+        fillRandom<int8_t>(prng, d.input0, 0, 127);
+        fillRandom<int8_t>(prng, d.input1, -128, 127);
+        return d;
+    }
+    template <InstructionType I>
+    static void prepare(KernelData &)
+    {}
+    template <InstructionType I>
+    static void run(KernelData &d)
+    {
+        simd::dot2<OutSize, Divisor, BenchAlignment, I>(d.output.as<int8_t>(),
+                                                        d.input0.as<int8_t>(),
+                                                        d.input1.as<int8_t>());
+    }
+};
+
+/// Linear layer with int32 accumulation. Unsigned int8 inputs are limited to u7 as
+/// produced by crelu(), int16 inputs/weights avoid -32768 to keep madd exact.
+template <int OutSize, int InSize, bool SignedInput, bool PreReLU, typename InT = int8_t>
+struct LinearKernel
+{
+    static constexpr double Bytes =
+        sizeof(InT) * (InSize + OutSize * InSize) + sizeof(int32_t) * 2 * OutSize;
+    static constexpr double Ops = 2.0 * OutSize * InSize;
+
+    static KernelData make(PRNG &prng)
+    {
+        KernelData d {AlignedBuffer(InSize * sizeof(InT)), AlignedBuffer(),
+                      AlignedBuffer(OutSize * InSize * sizeof(InT)),
+                      AlignedBuffer(OutSize * sizeof(int32_t)),
+                      AlignedBuffer(OutSize * sizeof(int32_t))};
+        if constexpr (std::is_same_v<InT, int8_t>) {
+            fillRandom<int8_t>(prng, d.input0, SignedInput || PreReLU ? -128 : 0, 127);
+            fillRandom<int8_t>(prng, d.weight, -128, 127);
+        }
+        else {
+            fillRandom<int16_t>(prng, d.input0, -32767, 32767);
+            fillRandom<int16_t>(prng, d.weight, -32767, 32767);
+        }
+        fillRandom<int32_t>(prng, d.bias, -(1 << 20), 1 << 20);
+        return d;
+    }
+    template <InstructionType I>
+    static void prepare(KernelData &d)
+    {
+        simd::preprocessLinear<OutSize, InSize, BenchAlignment, I, InT>(d.weight.as<InT>());
+    }
+    template <InstructionType I>
+    static void run(KernelData &d)
+    {
+        simd::linear<OutSize, InSize, SignedInput, true, PreReLU, false, BenchAlignment, I>(
+            d.output.as<int32_t>(),
+            d.input0.as<InT>(),
+            d.weight.as<InT>(),
+            d.bias.as<int32_t>());
+    }
+};
+
+/// Dynamic point-wise conv as used by the policy heads: a hyper linear layer
+/// generates int16 weights (preprocessed by preprocessDynamicWeightLinear) which
+/// are then applied to a int16 map feature with pre-relu.
+template <int DynOutSize, int DynInSize, int HyperInSize>
+struct DynamicPWConvKernel
+{
+    static constexpr int HyperOutSize = DynOutSize * (DynInSize + 1);
+
+    static constexpr double Bytes = HyperInSize + HyperOutSize * HyperInSize
+                                    + sizeof(int32_t) * HyperOutSize
+                                    + sizeof(int16_t) * DynInSize
+                                    + sizeof(int32_t) * DynOutSize;
+    static constexpr double Ops = 2.0 * (HyperOutSize * HyperInSize + DynOutSize * DynInSize);
+
+    static KernelData make(PRNG &prng)
+    {
+        KernelData d {AlignedBuffer(HyperInSize), AlignedBuffer(DynInSize * sizeof(int16_t)),
+                      AlignedBuffer(HyperOutSize * HyperInSize),
+                      AlignedBuffer(HyperOutSize * sizeof(int32_t)),
+                      AlignedBuffer(DynOutSize * sizeof(int32_t))};
+        fillRandom<int8_t>(prng, d.input0, 0, 127);
+        fillRandom<int16_t>(prng, d.input1, -32767, 32767);
+        fillRandom<int8_t>(prng, d.weight, -128, 127);
+        fillRandom<int32_t>(prng, d.bias, -(1 << 20), 1 << 20);
+        return d;
+    }
+    template <InstructionType I>
+    static void prepare(KernelData &d)
+    {
+        simd::preprocessDynamicWeightLinear<DynOutSize,
+                                            DynInSize,
+                                            int16_t,
+                                            HyperInSize,
+                                            0,
+                                            BenchAlignment,
+                                            I>(d.weight.as<int8_t>(), d.bias.as<int32_t>());
+        simd::preprocessLinear<HyperOutSize, HyperInSize, BenchAlignment, I>(
+            d.weight.as<int8_t>());
+    }
+    template <InstructionType I>
+    static void run(KernelData &d)
+    {
+        alignas(BenchAlignment) int32_t hyperi32[HyperOutSize];
+        alignas(BenchAlignment) int16_t dynWeighti16[DynOutSize * DynInSize];
+        simd::linear<HyperOutSize, HyperInSize, false, true, false, false, BenchAlignment, I>(
+            hyperi32,
+            d.input0.as<int8_t>(),
+            d.weight.as<int8_t>(),
+            d.bias.as<int32_t>());
+        simd::crelu<DynOutSize * DynInSize, 1, true, BenchAlignment, I>(dynWeighti16, hyperi32);
+        simd::linear<DynOutSize, DynInSize, false, true, true, false, BenchAlignment, I>(
+            d.output.as<int32_t>(),
+            d.input1.as<int16_t>(),
+            dynWeighti16,
+            hyperi32 + DynOutSize * DynInSize);
+    }
+};
+
+// -------------------------------------------------
+// Bench runner
+
+struct BenchOptions
+{
+    double      secondsPerKernel;
+    uint64_t    seed;
+    std::string filter;
+};
+
+struct BenchSummary
+{
+    size_t numKernels    = 0;
+    size_t numMismatches = 0;
+};
+
+/// Run one kernel on all compiled instruction types, check that every output is
+/// bit-exact to the SCALAR output, and print the throughput of each instantiation.
+template <typename Kernel>
+void benchKernel(const char *model, const char *name, const BenchOptions &opt, BenchSummary &sum)
+{
+    std::string fullName = std::string(model) + "/" + name;
+    if (!opt.filter.empty() && fullName.find(opt.filter) == std::string::npos)
+        return;
+    sum.numKernels++;
+
+    PRNG             prng(XXH64(fullName.data(), fullName.size(), opt.seed));
+    const KernelData origin = Kernel::make(prng);
+
+    KernelData scalarData = origin;
+    Kernel::template prepare<simd::SCALAR>(scalarData);
+    Kernel::template run<simd::SCALAR>(scalarData);
+
+    forEachInstType([&](auto instConstant) {
+        constexpr InstructionType I = decltype(instConstant)::value;
+        using Clock                 = std::chrono::steady_clock;
+
+        KernelData data = origin;
+        Kernel::template prepare<I>(data);
+        Kernel::template run<I>(data);
+        bool match = data.output == scalarData.output;
+        if (!match)
+            sum.numMismatches++;
+
+        // Find an iteration count that takes about the given time
+        uint64_t iters = 16;
+        double   seconds;
+        for (;;) {
+            auto start = Clock::now();
+            for (uint64_t i = 0; i < iters; i++) {
+                Kernel::template run<I>(data);
+                clobberMemory();
+            }
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (seconds >= opt.secondsPerKernel || iters >= (1ULL << 40))
+                break;
+            iters *= seconds > 0 ? std::clamp(opt.secondsPerKernel / seconds * 1.2, 2.0, 100.0)
+                                 : 100.0;
+        }
+
+        double nsPerCall = seconds * 1e9 / iters;
+        MESSAGEL(std::left << std::setw(44) << fullName << std::setw(10) << instTypeName(I)
+                           << std::right << std::fixed << std::setprecision(2) << std::setw(10)
+                           << nsPerCall << " ns" << std::setw(10) << Kernel::Bytes / nsPerCall
+                           << " GB/s" << std::setw(10) << Kernel::Ops / nsPerCall << " GOPS  "
+                           << (match ? "OK" : "MISMATCH"));
+    });
+}
+
+// -------------------------------------------------
+// Accumulator update bench
+
+struct Mix9svqAccModel
+{
+    using Weight      = mix9svq::Weight;
+    using Accumulator = mix9svq::Accumulator;
+
+    static auto evaluate(Accumulator &acc, const Weight &w, PolicyBuffer &policy)
+    {
+        acc.evaluatePolicy(w, policy);
+        return acc.evaluateValue(w);
+    }
+};
+
+struct Mix10AccModel
+{
+    using Weight      = mix10::Weight;
+    using Accumulator = mix10::Accumulator;
+
+    static auto evaluate(Accumulator &acc, const Weight &w, PolicyBuffer &policy)
+    {
+        acc.evaluatePolicyLarge(w, policy);
+        return acc.evaluateValueLarge(w);
+    }
+};
+
+/// Compare applying the pending moves of one evaluation one by one against a single
+/// fused update, as done by Evaluator::clearCache(). Each iteration applies the moves,
+/// evaluates value and policy, then rolls the moves back.
+template <typename Model>
+void benchAccumulator(const char *model, const BenchOptions &opt, BenchSummary &sum)
+{
+    using Weight         = typename Model::Weight;
+    using Accumulator    = typename Model::Accumulator;
+    using StonePlacement = typename Accumulator::StonePlacement;
+    using Clock          = std::chrono::steady_clock;
+
+    constexpr int BoardSize     = 15;
+    constexpr int NumBaseStones = 20;
+
+    const std::string prefix = std::string(model) + "/acc_update_";
+    std::vector<int>  pendingCounts;
+    for (int n : {1, 4, 16}) {
+        std::string name = prefix + std::to_string(n);
+        if (opt.filter.empty() || name.find(opt.filter) != std::string::npos)
+            pendingCounts.push_back(n);
+    }
+    if (pendingCounts.empty())
+        return;
+
+    // Random weights only need to produce deterministic outputs, so small positive bytes
+    // are used everywhere to avoid integer overflow and non-finite floats.
+    PRNG    prng(XXH64(prefix.data(), prefix.size(), opt.seed));
+    Weight *w = MemAlloc::alignedArrayAlloc<Weight, alignof(Weight)>(1);
+    if (!w)
+        throw std::bad_alloc();
+    uint8_t *wBytes = reinterpret_cast<uint8_t *>(w);
+    for (size_t i = 0; i < sizeof(Weight); i++)
+        wBytes[i] = prng() % 4;
+
+    std::vector<StonePlacement> stones;
+    for (int y = 0; y < BoardSize; y++)
+        for (int x = 0; x < BoardSize; x++)
+            stones.push_back({EMPTY, int8_t(x), int8_t(y)});
+    std::shuffle(stones.begin(), stones.end(), prng);
+    for (size_t i = 0; i < stones.size(); i++)
+        stones[i].color = i % 2 ? WHITE : BLACK;
+
+    auto makeAccumulator = [&]() {
+        auto acc = std::make_unique<Accumulator>(BoardSize);
+        acc->clear(*w);
+        for (int i = 0; i < NumBaseStones; i++)
+            acc->move(*w, stones[i].color, stones[i].x, stones[i].y);
+        return acc;
+    };
+    auto seqAcc   = makeAccumulator();
+    auto fusedAcc = makeAccumulator();
+
+    PolicyBuffer seqPolicy(BoardSize), fusedPolicy(BoardSize);
+    for (int y = 0; y < BoardSize; y++)
+        for (int x = 0; x < BoardSize; x++) {
+            seqPolicy.setComputeFlag(Pos {x, y});
+            fusedPolicy.setComputeFlag(Pos {x, y});
+        }
+    auto sameOutput = [&](const auto &seqValue, const auto &fusedValue) {
+        if (std::memcmp(&seqValue, &fusedValue, sizeof(seqValue)) != 0)
+            return false;
+        for (int i = 0; i < BoardSize * BoardSize; i++)
+            if (std::memcmp(&seqPolicy(i), &fusedPolicy(i), sizeof(float)) != 0)
+                return false;
+        return true;
+    };
+
+    for (int numPending : pendingCounts) {
+        const StonePlacement *pending = stones.data() + NumBaseStones;
+        sum.numKernels++;
+
+        auto runSequential = [&]() {
+            for (int i = 0; i < numPending; i++)
+                seqAcc->move(*w, pending[i].color, pending[i].x, pending[i].y);
+            auto value = Model::evaluate(*seqAcc, *w, seqPolicy);
+            for (int i = 0; i < numPending; i++)
+                seqAcc->undo(*w);
+            return value;
+        };
+        auto runFused = [&]() {
+            fusedAcc->move(*w, pending, numPending);
+            auto value = Model::evaluate(*fusedAcc, *w, fusedPolicy);
+            fusedAcc->undo(*w, numPending);
+            return value;
+        };
+
+        // Outputs must be bit-exact, also after partially undoing a fused version
+        bool match = sameOutput(runSequential(), runFused());
+        if (numPending > 1) {
+            for (int i = 0; i < numPending - 1; i++)
+                seqAcc->move(*w, pending[i].color, pending[i].x, pending[i].y);
+            fusedAcc->move(*w, pending, numPending);
+            fusedAcc->undo(*w);
+            auto seqValue   = Model::evaluate(*seqAcc, *w, seqPolicy);
+            auto fusedValue = Model::evaluate(*fusedAcc, *w, fusedPolicy);
+            match           = match && sameOutput(seqValue, fusedValue);
+            seqAcc->undo(*w, numPending - 1);
+            fusedAcc->undo(*w, numPending - 1);
+        }
+        if (!match)
+            sum.numMismatches++;
+
+        auto timeRun = [&](auto &&run) {
+            uint64_t iters = 16;
+            double   seconds;
+            for (;;) {
+                auto start = Clock::now();
+                for (uint64_t i = 0; i < iters; i++) {
+                    run();
+                    clobberMemory();
+                }
+                seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                if (seconds >= opt.secondsPerKernel || iters >= (1ULL << 40))
+                    break;
+                iters *= seconds > 0
+                             ? std::clamp(opt.secondsPerKernel / seconds * 1.2, 2.0, 100.0)
+                             : 100.0;
+            }
+            return seconds * 1e9 / iters;
+        };
+        double seqNs   = timeRun(runSequential);
+        double fusedNs = timeRun(runFused);
+
+        MESSAGEL(std::left << std::setw(44) << prefix + std::to_string(numPending)
+                           << std::right << std::fixed << std::setprecision(2) << std::setw(10)
+                           << seqNs << " ns (seq)" << std::setw(10) << fusedNs
+                           << " ns (fused)" << std::setw(8) << seqNs / fusedNs << "x  "
+                           << (match ? "OK" : "MISMATCH"));
+    }
+
+    MemAlloc::alignedFree(w);
+}
+
+}  // namespace
+
+void Command::simdbench(int argc, char *argv[])
+{
+    BenchOptions opt;
+
+    cxxopts::Options options("rapfi simdbench");
+    options.add_options()  //
+        ("t,time",
+         "Time (ms) to run each kernel instantiation",
+         cxxopts::value<double>()->default_value("100"))  //
+        ("s,seed",
+         "Random seed for kernel inputs",
+         cxxopts::value<uint64_t>()->default_value("42"))  //
+        ("f,filter",
+         "Only run kernels whose name contains this string",
+         cxxopts::value<std::string>()->default_value(""))  //
+        ("h,help", "Print simdbench usage");
+
+    try {
+        auto args = options.parse(argc, argv);
+
+        if (args.count("help")) {
+            std::cout << options.help() << std::endl;
+            std::exit(EXIT_SUCCESS);
+        }
+
+        opt.secondsPerKernel = args["time"].as<double>() / 1000.0;
+        opt.seed             = args["seed"].as<uint64_t>();
+        opt.filter           = args["filter"].as<std::string>();
+
+        if (opt.secondsPerKernel <= 0)
+            throw std::invalid_argument("time must be positive");
+    }
+    catch (const std::exception &e) {
+        ERRORL("simdbench argument: " << e.what());
+        std::exit(EXIT_FAILURE);
+    }
+
+    MESSAGEL("Native instruction type: " << instTypeName(simd::NativeInstType));
+    BenchSummary sum;
+
+    {
+        using namespace mix9svq;
+        MESSAGEL("==========mix9svq==========");
+        benchKernel<ZeroKernel<FeatureDim, int32_t>>("mix9svq", "zero<i32>", opt, sum);
+        benchKernel<CopyKernel<FeatDWConvDim, int16_t>>("mix9svq", "copy<i16>", opt, sum);
+        benchKernel<AddKernel<FeatureDim, int16_t>>("mix9svq", "add<i16>", opt, sum);
+        benchKernel<CReLUKernel<FeatureDim, 256, true, int8_t>>("mix9svq",
+                                                                "crelu_global",
+                                                                opt,
+                                                                sum);
+        benchKernel<CReLUKernel<FeatureDim, 32, true, int8_t>>("mix9svq",
+                                                               "crelu_group",
+                                                               opt,
+                                                               sum);
+        benchKernel<CReLUKernel<ValueDim * 2, 128, false, int8_t>>("mix9svq",
+                                                                   "crelu_star_up1",
+                                                                   opt,
+                                                                   sum);
+        benchKernel<CReLUKernel<ValueDim * 2, 128, true, int8_t>>("mix9svq",
+                                                                  "crelu_star_up2",
+                                                                  opt,
+                                                                  sum);
+        benchKernel<CReLUKernel<ValueDim, 128, false, int8_t>>("mix9svq",
+                                                               "crelu_value",
+                                                               opt,
+                                                               sum);
+        benchKernel<CReLUKernel<PolicyPWConvDim * PolicyDim, 1, true, int16_t>>("mix9svq",
+                                                                                "crelu_pwconv_w",
+                                                                                opt,
+                                                                                sum);
+        benchKernel<Dot2Kernel<ValueDim, 128>>("mix9svq", "dot2_star", opt, sum);
+        benchKernel<LinearKernel<ValueDim * 2, FeatureDim, false, false>>("mix9svq",
+                                                                          "linear_star_up",
+                                                                          opt,
+                                                                          sum);
+        benchKernel<LinearKernel<ValueDim * 2, ValueDim, false, false>>("mix9svq",
+                                                                        "linear_quad_up",
+                                                                        opt,
+                                                                        sum);
+        benchKernel<LinearKernel<ValueDim, ValueDim, true, false>>("mix9svq",
+                                                                   "linear_star_down",
+                                                                   opt,
+                                                                   sum);
+        benchKernel<LinearKernel<ValueDim, FeatureDim + ValueDim * 4, false, false>>("mix9svq",
+                                                                                     "linear_l1",
+                                                                                     opt,
+                                                                                     sum);
+        benchKernel<LinearKernel<ValueDim, ValueDim, false, false>>("mix9svq",
+                                                                    "linear_l2",
+                                                                    opt,
+                                                                    sum);
+        benchKernel<LinearKernel<4, ValueDim, false, false>>("mix9svq", "linear_l3", opt, sum);
+        benchKernel<LinearKernel<PolicyDim * 2, FeatureDim, false, false>>("mix9svq",
+                                                                           "linear_policy_l1",
+                                                                           opt,
+                                                                           sum);
+        benchKernel<LinearKernel<PolicyPWConvDim, PolicyDim, false, true, int16_t>>(
+            "mix9svq",
+            "linear_pwconv<i16>",
+            opt,
+            sum);
+        benchKernel<DynamicPWConvKernel<PolicyPWConvDim, PolicyDim, PolicyDim * 2>>(
+            "mix9svq",
+            "dynamic_pwconv",
+            opt,
+            sum);
+        benchAccumulator<Mix9svqAccModel>("mix9svq", opt, sum);
+    }
+
+    {
+        using namespace mix10;
+        MESSAGEL("===========mix10===========");
+        benchKernel<ZeroKernel<FeatureDim, int32_t>>("mix10", "zero<i32>", opt, sum);
+        benchKernel<CopyKernel<FeatDWConvDim, int16_t>>("mix10", "copy<i16>", opt, sum);
+        benchKernel<CopyKernel<ValueDim, int8_t>>("mix10", "copy<i8>", opt, sum);
+        benchKernel<AddKernel<FeatureDim, int16_t>>("mix10", "add<i16>", opt, sum);
+        benchKernel<CReLUKernel<FeatureDim, 256, true, int8_t>>("mix10",
+                                                                "crelu_global",
+                                                                opt,
+                                                                sum);
+        benchKernel<CReLUKernel<FeatureDim, 32, true, int8_t>>("mix10", "crelu_group", opt, sum);
+        benchKernel<CReLUKernel<ValueDim, 128, false, int8_t, 8 * ValueDim>>("mix10",
+                                                                             "crelu_value",
+                                                                             opt,
+                                                                             sum);
+        benchKernel<CReLUKernel<FeatureDim * 2, 128, true, int8_t, 8 * FeatureDim * 2>>(
+            "mix10",
+            "crelu_gate",
+            opt,
+            sum);
+        benchKernel<CReLUKernel<PolicySOutDim * PolicySInDim, 1, true, int16_t>>("mix10",
+                                                                                 "crelu_pwconv_s",
+                                                                                 opt,
+                                                                                 sum);
+        benchKernel<CReLUKernel<PolicyLMidDim * PolicyLInDim, 1, true, int16_t>>(
+            "mix10",
+            "crelu_pwconv_l1",
+            opt,
+            sum);
+        benchKernel<CReLUKernel<PolicyLOutDim * PolicyLMidDim, 1, true, int16_t>>(
+            "mix10",
+            "crelu_pwconv_l2",
+            opt,
+            sum);
+        benchKernel<CReLUKernel<PolicyLMidDim,
+                                128 * 128,
+                                false,
+                                int16_t,
+                                PolicyLMidDim * sizeof(int16_t) * 8>>("mix10",
+                                                                      "crelu_policy_mid",
+                                                                      opt,
+                                                                      sum);
+        benchKernel<Dot2Kernel<FeatureDim / 2, 128>>("mix10", "dot2_gate", opt, sum);
+        benchKernel<LinearKernel<ValueDim, FeatureDim, false, false>>("mix10",
+                                                                      "linear_small_l1",
+                                                                      opt,
+                                                                      sum);
+        benchKernel<LinearKernel<ValueDim, ValueDim, false, false>>("mix10",
+                                                                    "linear_small_l2",
+                                                                    opt,
+                                                                    sum);
+        benchKernel<LinearKernel<4, ValueDim, false, false>>("mix10", "linear_l3", opt, sum);
+        benchKernel<LinearKernel<FeatureDim * 2, ValueDim, false, false>>("mix10",
+                                                                          "linear_gate",
+                                                                          opt,
+                                                                          sum);
+        benchKernel<LinearKernel<ValueDim, FeatureDim, true, false>>("mix10",
+                                                                     "linear_group",
+                                                                     opt,
+                                                                     sum);
+        benchKernel<LinearKernel<ValueDim, ValueDim * 5, false, false>>("mix10",
+                                                                        "linear_l1",
+                                                                        opt,
+                                                                        sum);
+        benchKernel<LinearKernel<PolicySOutDim, PolicySInDim, false, true, int16_t>>(
+            "mix10",
+            "linear_pwconv_s<i16>",
+            opt,
+            sum);
+        benchKernel<LinearKernel<PolicyLMidDim, PolicyLInDim, false, true, int16_t>>(
+            "mix10",
+            "linear_pwconv_l1<i16>",
+            opt,
+            sum);
+        benchKernel<LinearKernel<PolicyLOutDim, PolicyLMidDim, false, false, int16_t>>(
+            "mix10",
+            "linear_pwconv_l2<i16>",
+            opt,
+            sum);
+        benchKernel<DynamicPWConvKernel<PolicySOutDim, PolicySInDim, ValueDim>>(
+            "mix10",
+            "dynamic_pwconv_s",
+            opt,
+            sum);
+        benchKernel<DynamicPWConvKernel<PolicyLMidDim, PolicyLInDim, ValueDim>>(
+            "mix10",
+            "dynamic_pwconv_l1",
+            opt,
+            sum);
+        benchKernel<DynamicPWConvKernel<PolicyLOutDim, PolicyLMidDim, ValueDim>>(
+            "mix10",
+            "dynamic_pwconv_l2",
+            opt,
+            sum);
+        benchAccumulator<Mix10AccModel>("mix10", opt, sum);
+    }
+
+    MESSAGEL("Kernels: " << sum.numKernels << ", mismatches: " << sum.numMismatches);
+    if (sum.numMismatches > 0) {
+        ERRORL("Found " << sum.numMismatches << " kernel outputs differing from the reference.");
+        std::exit(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,338 @@
+/*
+ *  Rapfi, a Gomoku/Renju playing engine supporting piskvork protocol.
+ *  Copyright (C) 2022  Rapfi developers
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../config.h"
+#include "../core/iohelper.h"
+#include "../core/utils.h"
+#include "../search/timecontrol.h"
+#include "command.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cxxopts.hpp>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using Search::TimeControl;
+using MoveRecord = TimeControl::MoveRecord;
+
+namespace {
+
+/// A time management parameter that is tuned by timetune.
+struct TimeParam
+{
+    const char *configKey;  // Key name in the [search.timectl] config table
+    float      *value;
+    float       minValue, maxValue;
+};
+
+/// Statistics of replaying all records in the time log with the current parameters.
+struct ReplayResult
+{
+    size_t numMoves;
+    size_t numMismatches;  // Moves where the replay stops before the final best move
+    size_t numSequences;
+    size_t numTimeLosses;  // Sequences that run out of match time in the replay
+    Time   recordedTime;
+    Time   replayedTime;
+
+    double mismatchRate() const { return double(numMismatches) / std::max<size_t>(numMoves, 1); }
+    double timeRatio() const { return double(replayedTime) / std::max<Time>(recordedTime, 1); }
+    double lossRate() const { return double(numTimeLosses) / std::max<size_t>(numSequences, 1); }
+};
+
+/// Weights of each term in the cost function to minimize.
+struct CostWeights
+{
+    double time;
+    double loss;
+};
+
+double replayCost(const ReplayResult &r, CostWeights w)
+{
+    return r.mismatchRate() + w.time * r.timeRatio() + w.loss * r.lossRate();
+}
+
+/// Replay one move record with the current time parameters.
+/// @param[in] record The recorded search of this move.
+/// @param[in] turnTime Turn time used in the replay.
+/// @param[in] matchTime Match time used in the replay.
+/// @param[in] timeLeft Match time left in the replay.
+/// @param[in,out] prevTimeReduction Time reduction carried over from the previous move.
+/// @param[out] bestMove The best move when the replayed search stops.
+/// @return Time used by the replayed search.
+Time replayMove(const MoveRecord &record,
+                Time              turnTime,
+                Time              matchTime,
+                Time              timeLeft,
+                float            &prevTimeReduction,
+                Pos              &bestMove)
+{
+    TimeControl tc;
+    tc.init(turnTime, matchTime, timeLeft, record.moveParams);
+
+    const auto &iterations    = record.iterations;
+    float       timeReduction = 1.0f;
+    Time        limit         = tc.maximum();
+    for (size_t i = 0; i < iterations.size(); i++) {
+        const auto &iter = iterations[i];
+
+        // The search is interrupted by the maximum time before this iteration completes
+        if (iter.elapsed >= tc.maximum()) {
+            bestMove          = i > 0 ? iterations[i - 1].bestMove : iter.bestMove;
+            prevTimeReduction = timeReduction;
+            return tc.maximum();
+        }
+
+        TimeControl::IterParams params = iter.params;
+        params.prevTimeReduction       = prevTimeReduction;
+        limit                          = tc.iterationTimeLimit(params, timeReduction);
+        bestMove                       = iter.bestMove;
+
+        // A proven result ends the search no matter how much time is left
+        if (iter.elapsed >= limit || std::abs(params.bestValue) >= VALUE_MATE_IN_MAX_PLY) {
+            prevTimeReduction = timeReduction;
+            return iter.elapsed;
+        }
+    }
+
+    // The replay wants to search deeper than the record. Assume the best move does
+    // not change and extrapolate iteration time with the growth of the last two.
+    Time   elapsed     = iterations.back().elapsed;
+    Time   prevElapsed = iterations.size() > 1 ? iterations[iterations.size() - 2].elapsed : 0;
+    double growth      = prevElapsed > 0 ? double(elapsed) / prevElapsed : 2.0;
+    growth             = std::clamp(growth, 1.2, 8.0);
+    prevTimeReduction  = timeReduction;
+    while (elapsed < limit) {
+        elapsed = std::max(Time(elapsed * growth), elapsed + 1);
+        if (elapsed >= tc.maximum())
+            return tc.maximum();
+    }
+    return elapsed;
+}
+
+/// Replay all move sequences with the current time parameters.
+ReplayResult replayAll(const std::vector<std::vector<MoveRecord>> &sequences,
+                       Time                                        turnTimeOverride,
+                       Time                                        matchTimeOverride)
+{
+    ReplayResult result {};
+    for (const auto &seq : sequences) {
+        result.numSequences++;
+
+        Time  matchTime         = matchTimeOverride >= 0 ? matchTimeOverride : seq[0].matchTime;
+        Time  timeLeft          = matchTimeOverride >= 0 ? matchTime : seq[0].matchTimeLeft;
+        float prevTimeReduction = 1.0f;
+        for (const MoveRecord &record : seq) {
+            Time turnTime = turnTimeOverride >= 0 ? turnTimeOverride : record.turnTime;
+            Pos  bestMove = Pos::NONE;
+            Time used     = replayMove(record,
+                                       turnTime,
+                                       matchTime,
+                                       std::max<Time>(timeLeft, 0),
+                                       prevTimeReduction,
+                                       bestMove);
+
+            result.numMoves++;
+            result.numMismatches += bestMove != record.iterations.back().bestMove;
+            result.recordedTime += record.used;
+            result.replayedTime += used;
+
+            timeLeft -= used;
+            if (matchTime > 0 && timeLeft < 0) {
+                result.numTimeLosses++;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+/// Read the time log into move sequences of each side in each game.
+std::vector<std::vector<MoveRecord>> readTimeLog(std::istream &in)
+{
+    std::map<std::pair<size_t, int>, std::vector<MoveRecord>> sequenceMap;
+    std::string                                                line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream ss(line);
+        size_t             game;
+        int                side;
+        MoveRecord         record;
+        if (!(ss >> game >> side >> record) || record.iterations.empty())
+            throw std::runtime_error("invalid time log line: " + line);
+        sequenceMap[{game, side}].push_back(std::move(record));
+    }
+
+    std::vector<std::vector<MoveRecord>> sequences;
+    for (auto &[key, seq] : sequenceMap)
+        sequences.push_back(std::move(seq));
+    return sequences;
+}
+
+void printResult(const char *title, const ReplayResult &r, CostWeights w)
+{
+    MESSAGEL(title << ": cost = " << replayCost(r, w) << ", mismatch = " << r.mismatchRate() * 100
+                   << "%, time ratio = " << r.timeRatio() << ", time loss = "
+                   << r.numTimeLosses << "/" << r.numSequences);
+}
+
+}  // namespace
+
+void Command::timetune(int argc, char *argv[])
+{
+    std::string timeLogPath;
+    Time        turnTimeOverride, matchTimeOverride;
+    size_t      numIterations;
+    double      stepSize;
+    CostWeights weights;
+    uint64_t    seed;
+
+    cxxopts::Options options("rapfi timetune");
+    options.add_options()  //
+        ("i,input",
+         "Time log file written by match or selfplay with --time-log",
+         cxxopts::value<std::string>())  //
+        ("turn-time",
+         "Replay with this turn time (ms) instead of the recorded one",
+         cxxopts::value<Time>())  //
+        ("match-time",
+         "Replay with this match time (ms) instead of the recorded one (0 for no limit)",
+         cxxopts::value<Time>())  //
+        ("iterations",
+         "Number of local search iterations",
+         cxxopts::value<size_t>()->default_value("2000"))  //
+        ("step-size",
+         "Standard deviation of the log-scale perturbation of a parameter",
+         cxxopts::value<double>()->default_value("0.1"))  //
+        ("time-weight",
+         "Cost weight of the replayed time relative to the recorded time",
+         cxxopts::value<double>()->default_value("0.2"))  //
+        ("loss-weight",
+         "Cost weight of the rate of losing on time",
+         cxxopts::value<double>()->default_value("10"))  //
+        ("seed",
+         "Seed of the random perturbation",
+         cxxopts::value<uint64_t>()->default_value("0"))  //
+        ("h,help", "Print timetune usage");
+
+    try {
+        auto args = options.parse(argc, argv);
+
+        if (args.count("help")) {
+            std::cout << options.help() << std::endl;
+            std::exit(EXIT_SUCCESS);
+        }
+
+        if (!args.count("input"))
+            throw std::invalid_argument("input time log must be specified");
+
+        timeLogPath       = args["input"].as<std::string>();
+        turnTimeOverride  = args.count("turn-time") ? args["turn-time"].as<Time>() : -1;
+        matchTimeOverride = args.count("match-time") ? args["match-time"].as<Time>() : -1;
+        numIterations     = args["iterations"].as<size_t>();
+        stepSize          = std::max(args["step-size"].as<double>(), 0.0);
+        weights.time      = std::max(args["time-weight"].as<double>(), 0.0);
+        weights.loss      = std::max(args["loss-weight"].as<double>(), 0.0);
+        seed              = args["seed"].as<uint64_t>();
+    }
+    catch (const std::exception &e) {
+        ERRORL("timetune argument: " << e.what());
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::vector<std::vector<MoveRecord>> sequences;
+    try {
+        std::ifstream timeLogFile(timeLogPath);
+        if (!timeLogFile.is_open())
+            throw std::runtime_error("unable to open time log file " + timeLogPath);
+        sequences = readTimeLog(timeLogFile);
+    }
+    catch (const std::exception &e) {
+        ERRORL("timetune: " << e.what());
+        std::exit(EXIT_FAILURE);
+    }
+
+    size_t numMoves = 0;
+    for (const auto &seq : sequences)
+        numMoves += seq.size();
+    MESSAGEL("Loaded " << numMoves << " moves of " << sequences.size() << " sequences from "
+                       << timeLogPath);
+    if (numMoves == 0) {
+        ERRORL("timetune: no move record in time log");
+        return;
+    }
+
+    TimeParam params[] = {
+        {"match_space", &Config::MatchSpace, 1.0f, 100.0f},
+        {"match_space_min", &Config::MatchSpaceMin, 1.0f, 100.0f},
+        {"average_branch_factor", &Config::AverageBranchFactor, 0.5f, 10.0f},
+        {"advanced_stop_ratio", &Config::AdvancedStopRatio, 0.05f, 1.0f},
+        {"time_divisor_scale", &Config::TimeDivisorScale, 0.0f, 1.0f},
+        {"time_divisor_bias", &Config::TimeDivisorBias, 1.0f, 5.0f},
+        {"time_divisor_depth_pow", &Config::TimeDivisorDepthPow, 0.0f, 3.0f},
+        {"falling_factor_scale", &Config::FallingFactorScale, 0.0f, 0.1f},
+        {"falling_factor_bias", &Config::FallingFactorBias, 0.5f, 1.5f},
+        {"bestmove_stable_reduction_scale", &Config::BestmoveStableReductionScale, 0.0f, 0.5f},
+        {"bestmove_stable_prev_reduction_pow", &Config::BestmoveStablePrevReductionPow, 0.0f, 2.0f},
+    };
+
+    // Random multiplicative local search: perturb one parameter at a time in log scale,
+    // and keep the change if it lowers the replay cost
+    ReplayResult initialResult = replayAll(sequences, turnTimeOverride, matchTimeOverride);
+    ReplayResult bestResult    = initialResult;
+    double       bestCost      = replayCost(bestResult, weights);
+
+    PRNG                                  prng(seed);
+    std::uniform_int_distribution<size_t> paramDis(0, std::size(params) - 1);
+    std::normal_distribution<double>      stepDis(0.0, stepSize);
+    for (size_t iter = 0; iter < numIterations; iter++) {
+        TimeParam &param    = params[paramDis(prng)];
+        float      oldValue = *param.value;
+        float      newValue = float(oldValue * std::exp(stepDis(prng)));
+        // Parameters at zero can only move away from it additively
+        if (oldValue == 0.0f)
+            newValue = float(std::abs(stepDis(prng)) * (param.maxValue - param.minValue) * 0.1);
+        *param.value = std::clamp(newValue, param.minValue, param.maxValue);
+
+        ReplayResult result = replayAll(sequences, turnTimeOverride, matchTimeOverride);
+        double       cost   = replayCost(result, weights);
+        if (cost < bestCost) {
+            bestCost   = cost;
+            bestResult = result;
+        }
+        else
+            *param.value = oldValue;
+    }
+
+    printResult("Initial", initialResult, weights);
+    printResult("Tuned", bestResult, weights);
+
+    std::cout << "[search.timectl]\n";
+    for (const TimeParam &param : params)
+        std::cout << param.configKey << " = " << std::setprecision(6) << *param.value << '\n';
+    std::cout << std::flush;
+}
@@ -114,6 +114,10 @@ int NumIterationAfterMate = 6;
 int NumIterationAfterSingularRoot = 4;
 /// Max depth to search.
 int MaxSearchDepth = 99;
+/// Whether search threads on the same NUMA node share one main history table.
+bool SharedHistory = false;
+/// Nodes below this depth probe the node-local partition of a NUMA partitioned TT.
+float TTNodeLocalDepth = 4.0f;
 /// Expand node (evaluating policy) when first evaluate a node (evaluating value).
 bool ExpandWhenFirstEvaluate = false;
 /// The maximum number of visits per playout in MCTS search.
@@ -203,6 +207,8 @@ int DatabaseQueryPly = 3;
 int DatabaseQueryPVIterPerPlyIncrement = 1;
 /// How many iteration needed to increase one database query ply
 int DatabaseQueryNonPVIterPerPlyIncrement = 2;
+/// Whether to prefetch records of the PV and TT move children in the query plies
+bool DatabasePrefetch = false;
 
 /// PV node before this ply is required to write the database
 int DatabasePVWritePly = 1;
@@ -344,6 +350,64 @@ void Config::readGeneral(const cpptoml::table &t)
         }
     }
 
+    // Read Large Page Mode
+    if (t.get_as<std::string>("large_page")) {
+        std::string             largePageStr = *t.get_as<std::string>("large_page");
+        MemAlloc::LargePageType limit        = MemAlloc::LargePageType::LARGE_PAGE;
+        if (largePageStr == "1gb")
+            limit = MemAlloc::LargePageType::HUGETLB_1GB;
+        else if (largePageStr == "2mb")
+            limit = MemAlloc::LargePageType::HUGETLB_2MB;
+        else if (largePageStr == "transparent")
+            limit = MemAlloc::LargePageType::TRANSPARENT;
+        else if (largePageStr == "none")
+            limit = MemAlloc::LargePageType::NORMAL;
+        else if (largePageStr != "auto")
+            MESSAGEL("Warning: unknown large page mode [" << largePageStr << "], reset to [auto].");
+
+        // The global transposition table is allocated before any config is loaded
+        if (limit != MemAlloc::largePageLimit()) {
+            MemAlloc::setLargePageLimit(limit);
+            Search::TT.reallocate();
+        }
+    }
+
+    // Read TT Numa Policy
+    if (t.get_as<std::string>("tt_numa_policy")) {
+        std::string                   policyStr = *t.get_as<std::string>("tt_numa_policy");
+        Search::HashTable::NumaPolicy policy    = Search::HashTable::NumaPolicy::DEFAULT;
+        if (policyStr == "interleave")
+            policy = Search::HashTable::NumaPolicy::INTERLEAVE;
+        else if (policyStr == "partition")
+            policy = Search::HashTable::NumaPolicy::PARTITION;
+        else if (policyStr != "default")
+            MESSAGEL("Warning: unknown tt numa policy [" << policyStr << "], reset to [default].");
+        Search::TT.setNumaPolicy(policy);
+    }
+
+    // Read Thread Bind Policy
+    if (t.get_as<std::string>("thread_bind_policy")) {
+        std::string      policyStr = *t.get_as<std::string>("thread_bind_policy");
+        Numa::BindPolicy policy    = Numa::BindPolicy::NUMA;
+        if (policyStr == "none")
+            policy = Numa::BindPolicy::NONE;
+        else if (policyStr == "compact")
+            policy = Numa::BindPolicy::COMPACT;
+        else if (policyStr == "scatter")
+            policy = Numa::BindPolicy::SCATTER;
+        else if (policyStr == "l3")
+            policy = Numa::BindPolicy::L3;
+        else if (policyStr != "numa")
+            MESSAGEL("Warning: unknown thread bind policy [" << policyStr << "], reset to [numa].");
+
+        // Recreate existing threads so that they are bound with the new policy
+        if (policy != Numa::bindPolicy()) {
+            Numa::setBindPolicy(policy);
+            if (!Search::Threads.empty())
+                Search::Threads.setNumThreads(Search::Threads.size());
+        }
+    }
+
     // Read Coord Conversion Mode
     if (t.get_as<std::string>("coord_conversion_mode")) {
         std::string coordModeStr = *t.get_as<std::string>("coord_conversion_mode");
@@ -414,7 +478,9 @@ void Config::readSearch(const cpptoml::table &t)
         t.get_as<int>("num_iteration_after_mate").value_or(NumIterationAfterMate);
     NumIterationAfterSingularRoot =
         t.get_as<int>("num_iteration_after_singular_root").value_or(NumIterationAfterSingularRoot);
-    MaxSearchDepth = t.get_as<int>("max_search_depth").value_or(MaxSearchDepth);
+    MaxSearchDepth   = t.get_as<int>("max_search_depth").value_or(MaxSearchDepth);
+    SharedHistory    = t.get_as<bool>("shared_history").value_or(SharedHistory);
+    TTNodeLocalDepth = t.get_as<double>("tt_node_local_depth").value_or(TTNodeLocalDepth);
 
     // Parameters for MCTS search
     ExpandWhenFirstEvaluate =
@@ -680,8 +746,12 @@ void Config::readEvaluator(const cpptoml::table &t)
                 path                  weightPath,
                 std::pair<path, path> blackAndWhiteWeightPath,
                 const cpptoml::table &weightCfg) {
+                // Search threads are only bound to numa nodes above the bind threshold
+                bool numaBound = Numa::needBindThreads(Search::Threads.size());
                 return std::make_unique<Evaluation::onnx::OnnxEvaluator>(boardSize,
                                                                          rule,
+                                                                         numaId,
+                                                                         numaBound,
                                                                          weightPath,
                                                                          deviceName);
             },
@@ -770,6 +840,7 @@ void Config::readDatabase(const cpptoml::table &t)
         DatabaseQueryNonPVIterPerPlyIncrement =
             s->get_as<int>("nonpv_iter_per_ply_increment")
                 .value_or(DatabaseQueryNonPVIterPerPlyIncrement);
+        DatabasePrefetch = s->get_as<bool>("prefetch").value_or(DatabasePrefetch);
 
         DatabasePVWritePly = s->get_as<int>("pv_write_ply").value_or(DatabasePVWritePly);
         DatabasePVWriteMinDepth =
@@ -114,11 +114,13 @@ extern size_t              DefaultTTSizeKB;
 
 // -------------------------------------------------
 // Search options
-extern bool AspirationWindow;
-extern bool FilterSymmetryRootMoves;
-extern int  NumIterationAfterMate;
-extern int  NumIterationAfterSingularRoot;
-extern int  MaxSearchDepth;
+extern bool  AspirationWindow;
+extern bool  FilterSymmetryRootMoves;
+extern int   NumIterationAfterMate;
+extern int   NumIterationAfterSingularRoot;
+extern int   MaxSearchDepth;
+extern bool  SharedHistory;
+extern float TTNodeLocalDepth;
 
 extern bool  ExpandWhenFirstEvaluate;
 extern int   MaxNumVisitsPerPlayout;
@@ -168,6 +170,7 @@ extern bool                      DatabaseMandatoryParentWrite;
 extern int                       DatabaseQueryPly;
 extern int                       DatabaseQueryPVIterPerPlyIncrement;
 extern int                       DatabaseQueryNonPVIterPerPlyIncrement;
+extern bool                      DatabasePrefetch;
 extern int                       DatabasePVWritePly;
 extern int                       DatabasePVWriteMinDepth;
 extern int                       DatabaseNonPVWritePly;
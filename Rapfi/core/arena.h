@@ -0,0 +1,143 @@
+/*
+ *  Rapfi, a Gomoku/Renju playing engine supporting piskvork protocol.
+ *  Copyright (C) 2022  Rapfi developers
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/// MonotonicArena is a bump allocator for short-lived allocations. Memory is never
+/// returned by individual deallocations, but all at once by reset(). After reset(),
+/// the largest block is kept for reuse, so an arena that is reset between similar
+/// workloads stops touching the heap after the first one.
+class MonotonicArena
+{
+public:
+    explicit MonotonicArena(size_t initialBlockSize = 16 << 10)
+        : nextBlockSize(std::max<size_t>(initialBlockSize, sizeof(Block)))
+    {}
+    ~MonotonicArena() { releaseBlocks(nullptr); }
+    MonotonicArena(const MonotonicArena &)            = delete;
+    MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+    /// Allocate size bytes aligned to alignment (power of two) from the arena.
+    void *allocate(size_t size, size_t alignment)
+    {
+        assert(alignment && (alignment & (alignment - 1)) == 0);
+        uintptr_t ptr = (cur + alignment - 1) & ~uintptr_t(alignment - 1);
+        if (!head || ptr + size > end) {
+            newBlock(size + alignment);
+            ptr = (cur + alignment - 1) & ~uintptr_t(alignment - 1);
+        }
+
+        cur = ptr + size;
+        return reinterpret_cast<void *>(ptr);
+    }
+
+    /// Release all allocations at once, keeping only the largest block for reuse.
+    void reset()
+    {
+        if (!head)
+            return;
+
+        // Blocks grow geometrically, so the head block is the largest one
+        releaseBlocks(head);
+        head->next = nullptr;
+        cur        = reinterpret_cast<uintptr_t>(head + 1);
+        end        = reinterpret_cast<uintptr_t>(head) + head->size;
+    }
+
+private:
+    struct alignas(std::max_align_t) Block
+    {
+        Block *next;
+        size_t size;
+    };
+
+    Block    *head = nullptr;
+    uintptr_t cur  = 0;
+    uintptr_t end  = 0;
+    size_t    nextBlockSize;
+
+    void newBlock(size_t minSize)
+    {
+        size_t blockSize = std::max(nextBlockSize, minSize + sizeof(Block));
+        Block *block     = static_cast<Block *>(::operator new(blockSize));
+        block->next      = head;
+        block->size      = blockSize;
+        head             = block;
+        cur              = reinterpret_cast<uintptr_t>(block + 1);
+        end              = reinterpret_cast<uintptr_t>(block) + blockSize;
+        nextBlockSize    = blockSize * 2;
+    }
+
+    /// Free all blocks after the given block (or all blocks if it is nullptr).
+    void releaseBlocks(Block *keep)
+    {
+        Block *block = keep ? keep->next : head;
+        while (block) {
+            Block *next = block->next;
+            ::operator delete(block);
+            block = next;
+        }
+        if (!keep)
+            head = nullptr;
+    }
+};
+
+/// ArenaAllocator is a standard allocator that allocates from a MonotonicArena.
+/// Containers using it must not outlive the next reset() of the arena.
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator(MonotonicArena &arena) noexcept : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena(other.arena)
+    {}
+
+    T   *allocate(size_t n) { return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T *, size_t) noexcept {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const noexcept
+    {
+        return arena == other.arena;
+    }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const noexcept
+    {
+        return arena != other.arena;
+    }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    MonotonicArena *arena;
+};
+
+/// ArenaVector is a std::vector whose storage is allocated from a MonotonicArena.
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
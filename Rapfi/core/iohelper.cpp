@@ -20,15 +20,39 @@
 
 #include "../config.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstring>
+#include <exception>
+#include <fstream>
 #include <functional>
 #include <lz4Stream.hpp>
 #include <memory>
 #include <mutex>
 #include <sstream>
+#include <stdexcept>
+#ifdef MULTI_THREADING
+    #include <thread>
+#endif
 #ifdef COMMAND_MODULES
     #define WITH_ZIP
     #include <zip.h>
+
+// Iterative extraction API of miniz, which is compiled into the zip library. Its header
+// also contains the implementation, so only the functions we need are declared here.
+// Note that struct zip_t begins with its mz_zip_archive, so a zip_t pointer can be used
+// as the archive pointer.
+extern "C" {
+struct mz_zip_archive;
+struct mz_zip_reader_extract_iter_state;
+mz_zip_reader_extract_iter_state *
+mz_zip_reader_extract_iter_new(mz_zip_archive *pZip, unsigned file_index, unsigned flags);
+size_t mz_zip_reader_extract_iter_read(mz_zip_reader_extract_iter_state *pState,
+                                       void                             *pvBuf,
+                                       size_t                            buf_size);
+int    mz_zip_reader_extract_iter_free(mz_zip_reader_extract_iter_state *pState);
+}
 #endif
 
 constexpr int PASS_COORD_X = -1;
@@ -206,6 +230,446 @@ std::ostream &operator<<(std::ostream &out, MovesText movesRef)
     return out;
 }
 
+// -------------------------------------------------
+// Parallel LZ4 streams
+
+namespace {
+
+constexpr uint32_t LZ4FrameMagic          = 0x184D2204;
+constexpr uint32_t LZ4SkippableMagicMask  = 0xFFFFFFF0;
+constexpr uint32_t LZ4SkippableMagic      = 0x184D2A50;
+constexpr uint8_t  LZ4FlagBlockIndep      = 1 << 5;
+constexpr uint8_t  LZ4FlagBlockChecksum   = 1 << 4;
+constexpr uint8_t  LZ4FlagContentSize     = 1 << 3;
+constexpr uint8_t  LZ4FlagContentChecksum = 1 << 2;
+constexpr uint8_t  LZ4FlagDictID          = 1 << 0;
+constexpr size_t   LZ4ParallelChunkSize   = 4 << 20;
+
+int numCompressorThreads(int numThreads)
+{
+#ifdef MULTI_THREADING
+    if (numThreads <= 0)
+        numThreads = std::clamp<int>(std::thread::hardware_concurrency(), 1, 16);
+    return numThreads;
+#else
+    return 1;
+#endif
+}
+
+/// Run task(i) for all i in [0, n) with at most numThreads threads (including the caller).
+/// The first exception thrown by any task is rethrown after all threads have finished.
+template <typename Task>
+void parallelFor(size_t n, int numThreads, Task &&task)
+{
+    size_t                          numWorkers = std::min<size_t>(n, std::max(numThreads, 1));
+    std::vector<std::exception_ptr> errors(numWorkers);
+    auto                            work = [&](size_t worker) {
+        try {
+            for (size_t i = worker; i < n; i += numWorkers)
+                task(i);
+        }
+        catch (...) {
+            errors[worker] = std::current_exception();
+        }
+    };
+
+#ifdef MULTI_THREADING
+    std::vector<std::thread> threads;
+    for (size_t worker = 1; worker < numWorkers; worker++)
+        threads.emplace_back(work, worker);
+    if (numWorkers)
+        work(0);
+    for (std::thread &th : threads)
+        th.join();
+#else
+    for (size_t worker = 0; worker < numWorkers; worker++)
+        work(worker);
+#endif
+
+    for (std::exception_ptr &e : errors)
+        if (e)
+            std::rethrow_exception(e);
+}
+
+void checkLZ4Error(size_t ret, const char *what)
+{
+    if (LZ4F_isError(ret))
+        throw std::runtime_error(std::string(what) + LZ4F_getErrorName(ret));
+}
+
+/// Output buffer that splits the data into fixed size chunks and compresses each chunk
+/// into an independent LZ4 frame. A batch of chunks is compressed in parallel before
+/// being written to the sink in order.
+class LZ4ParallelOutputBuffer : public std::streambuf
+{
+public:
+    LZ4ParallelOutputBuffer(std::ostream &sink, int numThreads)
+        : sink(sink)
+        , numThreads(numThreads)
+        , chunks(numThreads)
+        , frames(numThreads)
+    {
+        sink.exceptions(std::ostream::badbit);
+        chunks[0].resize(LZ4ParallelChunkSize);
+        setp(chunks[0].data(), chunks[0].data() + chunks[0].size());
+    }
+    ~LZ4ParallelOutputBuffer() { close(); }
+
+    void close()
+    {
+        if (closed)
+            return;
+        sync();
+        closed = true;
+    }
+
+private:
+    int_type overflow(int_type ch) override
+    {
+        if (closed)
+            throw std::runtime_error("LZ4 parallel stream used after close");
+        if (pptr() == epptr())
+            nextChunk(false);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        if (!closed && pptr() != pbase())
+            nextChunk(true);
+        return 0;
+    }
+
+    /// Finish the current chunk, and compress all finished chunks if the batch is full
+    /// or a flush is requested.
+    void nextChunk(bool flush)
+    {
+        chunkSizes.push_back(size_t(pptr() - pbase()));
+
+        if (flush || chunkSizes.size() == chunks.size()) {
+            compressBatch();
+            chunkSizes.clear();
+        }
+
+        std::vector<char> &chunk = chunks[chunkSizes.size()];
+        chunk.resize(LZ4ParallelChunkSize);
+        setp(chunk.data(), chunk.data() + chunk.size());
+    }
+
+    void compressBatch()
+    {
+        parallelFor(chunkSizes.size(), numThreads, [&](size_t i) {
+            LZ4F_preferences_t pref    = LZ4F_INIT_PREFERENCES;
+            pref.frameInfo.blockSizeID = LZ4F_max4MB;
+            pref.frameInfo.blockMode   = LZ4F_blockIndependent;
+            pref.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+            pref.frameInfo.contentSize         = chunkSizes[i];
+            pref.compressionLevel              = 3;
+
+            frames[i].resize(LZ4F_compressFrameBound(chunkSizes[i], &pref));
+            size_t ret = LZ4F_compressFrame(frames[i].data(),
+                                            frames[i].size(),
+                                            chunks[i].data(),
+                                            chunkSizes[i],
+                                            &pref);
+            checkLZ4Error(ret, "LZ4 compression failed: ");
+            frames[i].resize(ret);
+        });
+
+        for (size_t i = 0; i < chunkSizes.size(); i++)
+            sink.write(frames[i].data(), frames[i].size());
+    }
+
+    std::ostream                  &sink;
+    int                            numThreads;
+    std::vector<std::vector<char>> chunks;
+    std::vector<std::vector<char>> frames;
+    std::vector<size_t>            chunkSizes;
+    bool                           closed = false;
+};
+
+/// Input buffer that reads a batch of LZ4 frames and decompresses them in parallel.
+/// Frames are delimited by walking their block headers, so no index is needed.
+class LZ4ParallelInputBuffer : public std::streambuf
+{
+public:
+    LZ4ParallelInputBuffer(std::istream &source, int numThreads)
+        : source(source)
+        , numThreads(numThreads)
+        , frames(numThreads)
+        , contents(numThreads)
+    {
+        source.exceptions(std::istream::badbit);
+        setg(nullptr, nullptr, nullptr);
+    }
+
+private:
+    int_type underflow() override
+    {
+        while (gptr() == egptr()) {
+            if (++current >= numContents) {
+                if (!decompressBatch())
+                    return traits_type::eof();
+                current = 0;
+            }
+            char *begin = contents[current].data();
+            setg(begin, begin, begin + contents[current].size());
+        }
+        return traits_type::to_int_type(*gptr());
+    }
+
+    /// Read up to numThreads frames and decompress them in parallel.
+    /// @return False if there is no frame left in the source stream.
+    bool decompressBatch()
+    {
+        numContents = 0;
+        while (numContents < frames.size() && readFrame(frames[numContents]))
+            numContents++;
+
+        parallelFor(numContents, numThreads, [&](size_t i) {
+            decompressFrame(frames[i], contents[i]);
+        });
+        return numContents > 0;
+    }
+
+    /// Read the next LZ4 frame (skipping skippable frames) into the buffer.
+    /// @return False if the end of source stream is reached.
+    bool readFrame(std::vector<char> &frame)
+    {
+        uint32_t magic;
+        while (true) {
+            if (!readBytes(reinterpret_cast<char *>(&magic), sizeof(magic)))
+                return false;
+            if ((magic & LZ4SkippableMagicMask) != LZ4SkippableMagic)
+                break;
+
+            uint32_t skipSize;
+            if (!readBytes(reinterpret_cast<char *>(&skipSize), sizeof(skipSize)))
+                throw std::runtime_error("LZ4 decompression failed: truncated skippable frame");
+            source.ignore(skipSize);
+        }
+        if (magic != LZ4FrameMagic)
+            throw std::runtime_error("LZ4 decompression failed: unknown frame magic");
+
+        frame.resize(sizeof(magic) + 2);
+        std::memcpy(frame.data(), &magic, sizeof(magic));
+        if (!readBytes(frame.data() + sizeof(magic), 2))
+            throw std::runtime_error("LZ4 decompression failed: truncated frame header");
+
+        uint8_t flag         = uint8_t(frame[4]);
+        size_t  headerRemain = 1 + (flag & LZ4FlagContentSize ? 8 : 0)
+                              + (flag & LZ4FlagDictID ? 4 : 0);
+        appendBytes(frame, headerRemain);
+
+        // Walk through all blocks until the end mark
+        while (true) {
+            uint32_t blockSize;
+            appendBytes(frame, sizeof(blockSize));
+            std::memcpy(&blockSize, frame.data() + frame.size() - sizeof(blockSize), 4);
+            if (blockSize == 0)
+                break;
+            appendBytes(frame,
+                        (blockSize & 0x7FFFFFFF) + (flag & LZ4FlagBlockChecksum ? 4 : 0));
+        }
+        if (flag & LZ4FlagContentChecksum)
+            appendBytes(frame, 4);
+
+        return true;
+    }
+
+    static void decompressFrame(const std::vector<char> &frame, std::vector<char> &content)
+    {
+        uint64_t contentSize = 0;
+        if (uint8_t(frame[4]) & LZ4FlagContentSize)
+            std::memcpy(&contentSize, frame.data() + 6, sizeof(contentSize));
+        content.resize(contentSize ? contentSize : LZ4ParallelChunkSize);
+
+        LZ4F_dctx *dctx;
+        checkLZ4Error(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION),
+                      "Failed to create LZ4 decompression context: ");
+        std::unique_ptr<LZ4F_dctx, decltype(&LZ4F_freeDecompressionContext)> dctxGuard(
+            dctx,
+            LZ4F_freeDecompressionContext);
+
+        size_t srcOffset = 0, dstOffset = 0, ret = 1;
+        while (ret != 0) {
+            // Grow the output buffer for frames without a content size
+            if (dstOffset == content.size())
+                content.resize(content.size() * 2);
+            if (srcOffset == frame.size())
+                throw std::runtime_error("LZ4 decompression failed: truncated frame");
+
+            size_t srcSize = frame.size() - srcOffset;
+            size_t dstSize = content.size() - dstOffset;
+            ret            = LZ4F_decompress(dctx,
+                                  content.data() + dstOffset,
+                                  &dstSize,
+                                  frame.data() + srcOffset,
+                                  &srcSize,
+                                  nullptr);
+            checkLZ4Error(ret, "LZ4 decompression failed: ");
+            srcOffset += srcSize;
+            dstOffset += dstSize;
+        }
+        content.resize(dstOffset);
+    }
+
+    bool readBytes(char *dst, size_t size)
+    {
+        source.read(dst, size);
+        if (size_t(source.gcount()) == size)
+            return true;
+        if (source.gcount() == 0)
+            return false;
+        throw std::runtime_error("LZ4 decompression failed: truncated frame");
+    }
+
+    void appendBytes(std::vector<char> &frame, size_t size)
+    {
+        size_t oldSize = frame.size();
+        frame.resize(oldSize + size);
+        if (!readBytes(frame.data() + oldSize, size))
+            throw std::runtime_error("LZ4 decompression failed: truncated frame");
+    }
+
+    std::istream                  &source;
+    int                            numThreads;
+    std::vector<std::vector<char>> frames;
+    std::vector<std::vector<char>> contents;
+    size_t                         numContents = 0;
+    size_t                         current     = 0;
+};
+
+/// Holds the stream buffer of a BufferedStream. As a base declared before the stream,
+/// the buffer is constructed before and destroyed after the stream that uses it.
+template <typename Buffer>
+struct StreamBufferHolder
+{
+    template <typename... Args>
+    StreamBufferHolder(Args &&...args) : buffer(std::forward<Args>(args)...)
+    {}
+
+    Buffer buffer;
+};
+
+/// Stream that owns its stream buffer, which is destroyed after the stream.
+template <typename Buffer, typename Stream>
+class BufferedStream
+    : private StreamBufferHolder<Buffer>
+    , public Stream
+{
+public:
+    template <typename... Args>
+    BufferedStream(Args &&...args)
+        : StreamBufferHolder<Buffer>(std::forward<Args>(args)...)
+        , Stream(&this->buffer)
+    {}
+};
+
+/// Check if a seekable input stream starts with an LZ4 frame that has independent blocks
+/// and a content size, which is what LZ4_PARALLEL writes. The stream position is restored.
+bool isParallelLZ4Stream(std::istream &is)
+{
+    std::streampos start = is.tellg();
+    if (start == std::streampos(-1))
+        return false;
+
+    char header[5] = {};
+    is.read(header, sizeof(header));
+    bool readOK = size_t(is.gcount()) == sizeof(header);
+    is.clear();
+    is.seekg(start);
+
+    uint32_t magic;
+    std::memcpy(&magic, header, sizeof(magic));
+    uint8_t flag = uint8_t(header[4]);
+    return readOK && magic == LZ4FrameMagic && (flag & LZ4FlagBlockIndep)
+           && (flag & LZ4FlagContentSize);
+}
+
+#ifdef WITH_ZIP
+/// Input buffer that inflates a zip entry chunk by chunk while it is being read.
+/// The entry is finished as soon as all of its data has been inflated, which checks its
+/// size and CRC. A corrupted or truncated entry throws, so the stream gets its badbit set.
+class ZipEntryInputBuffer : public std::streambuf
+{
+public:
+    ZipEntryInputBuffer(mz_zip_reader_extract_iter_state *iter,
+                        std::string                       entryName,
+                        uint64_t                          entrySize)
+        : iter(iter)
+        , entryName(std::move(entryName))
+        , entrySize(entrySize)
+        , numInflated(0)
+    {}
+    ~ZipEntryInputBuffer()
+    {
+        if (iter)
+            mz_zip_reader_extract_iter_free(iter);
+    }
+
+private:
+    int_type underflow() override
+    {
+        size_t size = inflate(buffer.data(), buffer.size());
+        if (size == 0)
+            return traits_type::eof();
+        setg(buffer.data(), buffer.data(), buffer.data() + size);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::streamsize xsgetn(char *s, std::streamsize n) override
+    {
+        // Consume the buffered bytes first, then inflate the rest directly into s
+        std::streamsize copied = std::min<std::streamsize>(n, egptr() - gptr());
+        std::memcpy(s, gptr(), copied);
+        gbump(int(copied));
+        while (copied < n) {
+            size_t size = inflate(s + copied, n - copied);
+            if (size == 0)
+                break;
+            copied += size;
+        }
+        return copied;
+    }
+
+    /// Inflate at most size bytes of the entry into dst.
+    /// @return Number of bytes inflated, or 0 at the end of the entry.
+    size_t inflate(char *dst, size_t size)
+    {
+        if (!iter)
+            return 0;
+
+        size_t inflated = mz_zip_reader_extract_iter_read(iter, dst, size);
+        numInflated += inflated;
+        if (inflated == 0 || numInflated >= entrySize) {
+            // Freeing the iterator verifies the inflated size and the CRC of the entry
+            bool finished = mz_zip_reader_extract_iter_free(iter);
+            iter          = nullptr;
+            if (!finished || numInflated != entrySize) {
+                ERRORL("Zip entry " << entryName << " is corrupted or truncated (inflated "
+                                    << numInflated << " of " << entrySize << " bytes)");
+                throw std::runtime_error("Zip decompression failed: corrupted entry "
+                                         + entryName);
+            }
+        }
+        return inflated;
+    }
+
+    mz_zip_reader_extract_iter_state *iter;
+    std::string                       entryName;
+    uint64_t                          entrySize;
+    uint64_t                          numInflated;
+    std::array<char, 65536>           buffer;
+};
+#endif
+
+}  // namespace
+
 // -------------------------------------------------
 
 class Compressor::CompressorData
@@ -236,19 +700,24 @@ class Compressor::CompressorData
     };
 
     Type                               type        = Type::NO_COMPRESS;
+    int                                numThreads  = 1;
     std::ostream                      *ostreamSink = nullptr;
     std::istream                      *istreamSink = nullptr;
     std::vector<CStream<std::ostream>> openedOutputStreams;
     std::vector<CStream<std::istream>> openedInputStreams;
+    std::unique_ptr<std::ifstream>     file;
 #ifdef WITH_ZIP
     std::string buffer;
-    zip_t      *zip = nullptr;
+    zip_t      *zip         = nullptr;
+    bool        zipFromFile = false;
 #endif
 };
 
-Compressor::Compressor(std::ostream &ostream, Type type) : data(new CompressorData)
+Compressor::Compressor(std::ostream &ostream, Type type, int numThreads)
+    : data(new CompressorData)
 {
     data->type        = type;
+    data->numThreads  = numCompressorThreads(numThreads);
     data->ostreamSink = &ostream;
 
 #ifdef WITH_ZIP
@@ -258,9 +727,11 @@ Compressor::Compressor(std::ostream &ostream, Type type) : data(new CompressorDa
 #endif
 }
 
-Compressor::Compressor(std::istream &istream, Type type) : data(new CompressorData)
+Compressor::Compressor(std::istream &istream, Type type, int numThreads)
+    : data(new CompressorData)
 {
     data->type        = type;
+    data->numThreads  = numCompressorThreads(numThreads);
     data->istreamSink = &istream;
 
 #ifdef WITH_ZIP
@@ -271,10 +742,33 @@ Compressor::Compressor(std::istream &istream, Type type) : data(new CompressorDa
 #endif
 }
 
+Compressor::Compressor(const std::filesystem::path &filePath, Type type, int numThreads)
+    : data(new CompressorData)
+{
+    data->type       = type;
+    data->numThreads = numCompressorThreads(numThreads);
+
+#ifdef WITH_ZIP
+    if (type == Type::ZIP_DEFAULT) {
+        data->zip         = zip_open(filePath.string().c_str(), 0, 'r');
+        data->zipFromFile = true;
+        return;
+    }
+#endif
+
+    data->file = std::make_unique<std::ifstream>(filePath, std::ios::binary);
+    if (data->file->is_open())
+        data->istreamSink = data->file.get();
+}
+
 Compressor::~Compressor()
 {
 #ifdef WITH_ZIP
     if (data->type == Type::ZIP_DEFAULT) {
+        // Opened entries must be finished before the archive is closed
+        data->openedOutputStreams.clear();
+        data->openedInputStreams.clear();
+
         if (data->ostreamSink) {
             char  *outbuf     = nullptr;
             size_t outbufSize = 0;
@@ -283,7 +777,10 @@ Compressor::~Compressor()
             free(outbuf);
         }
 
-        zip_stream_close(data->zip);
+        if (data->zipFromFile)
+            zip_close(data->zip);
+        else
+            zip_stream_close(data->zip);
     }
 #endif
 
@@ -318,6 +815,14 @@ std::ostream *Compressor::openOutputStream(std::string entryName)
             std::make_unique<lz4_stream::ostream>(*data->ostreamSink, LZ4Perf),
             entryName);
     } break;
+    case Type::LZ4_PARALLEL:
+        assert(entryName == "");
+        data->openedOutputStreams.emplace_back(
+            std::make_unique<BufferedStream<LZ4ParallelOutputBuffer, std::ostream>>(
+                *data->ostreamSink,
+                data->numThreads),
+            entryName);
+        break;
     case Type::ZIP_DEFAULT:
 #ifdef WITH_ZIP
         data->openedOutputStreams.emplace_back(
@@ -342,7 +847,7 @@ std::ostream *Compressor::openOutputStream(std::string entryName)
 
 std::istream *Compressor::openInputStream(std::string entryName)
 {
-    assert(data->istreamSink && "can not open input stream for output sink");
+    assert(!data->ostreamSink && "can not open input stream for output sink");
 
     // First find if this entry has been opened
     for (auto &s : data->openedInputStreams) {
@@ -351,28 +856,41 @@ std::istream *Compressor::openInputStream(std::string entryName)
     }
 
     switch (data->type) {
-    case Type::LZ4_DEFAULT: {
+    case Type::LZ4_DEFAULT:
+    case Type::LZ4_PARALLEL: {
         assert(entryName == "");
-        data->openedInputStreams.emplace_back(
-            std::make_unique<lz4_stream::istream>(*data->istreamSink),
-            entryName);
+        if (!data->istreamSink)
+            return nullptr;
+        if (isParallelLZ4Stream(*data->istreamSink))
+            data->openedInputStreams.emplace_back(
+                std::make_unique<BufferedStream<LZ4ParallelInputBuffer, std::istream>>(
+                    *data->istreamSink,
+                    data->numThreads),
+                entryName);
+        else
+            data->openedInputStreams.emplace_back(
+                std::make_unique<lz4_stream::istream>(*data->istreamSink),
+                entryName);
     } break;
     case Type::ZIP_DEFAULT:
 #ifdef WITH_ZIP
     {
-        assert(data->zip);
-        auto   ss         = std::make_unique<std::stringstream>();
-        char  *outbuf     = nullptr;
-        size_t outbufSize = 0;
-        if (zip_entry_open(data->zip, entryName.c_str()) < 0)
-            return nullptr;
-        if (zip_entry_read(data->zip, (void **)(&outbuf), &outbufSize) < 0)
+        if (!data->zip || zip_entry_open(data->zip, entryName.c_str()) < 0)
             return nullptr;
+        int      entryIndex = zip_entry_index(data->zip);
+        uint64_t entrySize  = zip_entry_size(data->zip);
         zip_entry_close(data->zip);
-        ss->write(outbuf, outbufSize);
-        free(outbuf);
 
-        data->openedInputStreams.emplace_back(std::move(ss), entryName);
+        auto archive = reinterpret_cast<mz_zip_archive *>(data->zip);
+        auto iter    = mz_zip_reader_extract_iter_new(archive, unsigned(entryIndex), 0);
+        if (!iter)
+            return nullptr;
+
+        data->openedInputStreams.emplace_back(
+            std::make_unique<BufferedStream<ZipEntryInputBuffer, std::istream>>(iter,
+                                                                                entryName,
+                                                                                entrySize),
+            entryName);
     } break;
 #else
         throw "Zip is not enabled in this build";
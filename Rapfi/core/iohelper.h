@@ -22,6 +22,7 @@
 #include "time.h"
 #include "types.h"
 
+#include <filesystem>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -116,12 +117,24 @@ std::ostream &operator<<(std::ostream &out, MovesText movesRef);
 class Compressor
 {
 public:
-    enum class Type { NO_COMPRESS, LZ4_DEFAULT, ZIP_DEFAULT };
+    /// Compression algorithm type.
+    /// LZ4_PARALLEL writes a sequence of independent LZ4 frames (one per 4MB chunk) that
+    /// are compressed by multiple threads. The output is still a valid LZ4 frame stream,
+    /// so it can be read with LZ4_DEFAULT, which detects this layout on seekable input
+    /// streams and decompresses the frames with multiple threads as well.
+    enum class Type { NO_COMPRESS, LZ4_DEFAULT, ZIP_DEFAULT, LZ4_PARALLEL };
 
     /// Create a compressor with the given algorithm type.
-    Compressor(std::ostream &ostream, Type type);
+    /// @param numThreads Number of threads used by LZ4_PARALLEL, 0 for all hardware threads.
+    Compressor(std::ostream &ostream, Type type, int numThreads = 0);
     /// Create a decompressor with the given algorithm type.
-    Compressor(std::istream &istream, Type type);
+    /// @param numThreads Number of threads used to decompress independent LZ4 frames,
+    ///     0 for all hardware threads.
+    Compressor(std::istream &istream, Type type, int numThreads = 0);
+    /// Create a decompressor that reads directly from a file. For ZIP type, the archive
+    /// is opened from the file instead of being loaded into memory, and entries are
+    /// inflated on demand as their streams are read.
+    Compressor(const std::filesystem::path &filePath, Type type, int numThreads = 0);
     ~Compressor();
 
     /// Open an output stream by entry name.
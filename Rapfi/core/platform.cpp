@@ -20,8 +20,11 @@
 
 #include "iohelper.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <map>
+#include <mutex>
 #include <vector>
 
 #ifdef _WIN32
@@ -35,6 +38,7 @@
     #endif
 
     #include <windows.h>
+    #include <psapi.h>
 // The needed Windows API for processor groups could be missed from old Windows
 // versions, so instead of calling them directly (forcing the linker to resolve
 // the calls at compile time), try to load them at runtime. To do this we need
@@ -50,13 +54,17 @@ typedef bool (*fun6_t)(HANDLE, PGROUP_AFFINITY, USHORT);
 #endif
 
 #if defined(__linux__) && !defined(__ANDROID__)
-    #include <algorithm>
+    #include <array>
     #include <fstream>
+    #include <linux/mempolicy.h>
     #include <optional>
     #include <sched.h>
     #include <set>
     #include <sstream>
     #include <string>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <tuple>
     #include <unistd.h>
 #endif
 
@@ -70,6 +78,42 @@ typedef bool (*fun6_t)(HANDLE, PGROUP_AFFINITY, USHORT);
 
 namespace Numa {
 
+namespace {
+
+std::atomic<BindPolicy> currentBindPolicy = BindPolicy::NUMA;
+
+}  // namespace
+
+const char *bindPolicyName(BindPolicy policy)
+{
+    switch (policy) {
+    case BindPolicy::NONE: return "none";
+    case BindPolicy::COMPACT: return "compact";
+    case BindPolicy::SCATTER: return "scatter";
+    case BindPolicy::L3: return "l3";
+    default: return "numa";
+    }
+}
+
+void setBindPolicy(BindPolicy policy)
+{
+    currentBindPolicy = policy;
+}
+
+BindPolicy bindPolicy()
+{
+    return currentBindPolicy;
+}
+
+bool needBindThreads(size_t numThreads)
+{
+    switch (bindPolicy()) {
+    case BindPolicy::NONE: return false;
+    case BindPolicy::NUMA: return numThreads > BindGroupThreshold;
+    default: return true;
+    }
+}
+
 #if defined(_WIN64)
 
 /// getThreadIdToNodeMapping() build once-per-process vector that maps every
@@ -145,11 +189,15 @@ std::vector<int> getThreadIdToNodeMapping()
 
 /// bindThisThread() set the group affinity of the current thread, and returns the
 /// numa node id for the thread. It uses the best_node() function to determine
-/// the best node id for the thread with index idx.
+/// the best node id for the thread with index idx. All policies except NONE
+/// bind to numa nodes, as the cpu topology is not queried on Windows.
 
 // ----------------------------------------------------------------------------
-NumaNodeId bindThisThread(std::size_t idx)
+NumaNodeId bindThisThread(std::size_t idx, BindPolicy policy)
 {
+    if (policy == BindPolicy::NONE)
+        return DefaultNumaNodeId;
+
     static const std::vector<int> groups = getThreadIdToNodeMapping();
     const int                     node   = idx < groups.size() ? groups[idx] : -1;
     if (node < 0)
@@ -191,6 +239,25 @@ NumaNodeId bindThisThread(std::size_t idx)
     return DefaultNumaNodeId;  // nothing worked → scheduler decides
 }
 
+/// Processor indices of a node are not exposed on Windows, as they are only
+/// meaningful together with the processor group of the node.
+std::vector<int> getNodeCpus(NumaNodeId)
+{
+    return {};
+}
+
+size_t getNumNodes()
+{
+    static const std::vector<int> groups = getThreadIdToNodeMapping();
+    return groups.empty() ? 1 : *std::max_element(groups.begin(), groups.end()) + 1;
+}
+
+/// Memory policy of an address range is not supported on Windows.
+bool interleaveMemory(void *, size_t)
+{
+    return false;
+}
+
 #elif defined(__linux__) && !defined(__ANDROID__)
 
 /// read_index_list_from_file() read a file, strip whitespace, turn "0,2-3" into {0,2,3}
@@ -291,25 +358,193 @@ static NumaTable build_numa_table(bool respectAffinity)
     return tbl;
 }
 
-// bindThisThread(idx) pins calling thread to node in round-robin order
-NumaNodeId bindThisThread(std::size_t idx)
+/// numa_table() returns the process-wide numa table, which is built only once.
+static const NumaTable &numa_table()
 {
     static const NumaTable numaTable = build_numa_table(true);
+    return numaTable;
+}
+
+/// read_int_from_file() reads a single integer from a sysfs file.
+static std::optional<int> read_int_from_file(std::string path)
+{
+    std::ifstream in(path);
+    int           value;
+    if (!(in >> value))
+        return std::nullopt;
+    return value;
+}
+
+/// CpuTopology is the position of a logical processor in the cpu topology.
+struct CpuTopology
+{
+    CpuIndex   cpu;
+    NumaNodeId node;      // index of the node in the numa table
+    CpuIndex   core;      // first logical processor of the physical core
+    int        smtRank;   // index of this logical processor among its SMT siblings
+    CpuIndex   l3;        // first logical processor of the L3 cache domain
+    int        capacity;  // relative performance of the core, or 0 if unknown
+};
+
+/// build_cpu_topology() reads the topology of all cpus in the numa table from
+/// /sys/devices/system/cpu/cpu<N>/{topology,cache,cpu_capacity,cpufreq}. When some
+/// information is missing, each cpu is regarded as its own core and each numa node
+/// as one L3 domain.
+static std::vector<CpuTopology> build_cpu_topology(const NumaTable &numaTable)
+{
+    std::vector<CpuTopology> topology;
+
+    for (size_t node = 0; node < numaTable.size(); node++) {
+        for (CpuIndex c : numaTable[node]) {
+            std::string cpuPath = "/sys/devices/system/cpu/cpu" + std::to_string(c);
+            CpuTopology t {c, static_cast<NumaNodeId>(node), c, 0, numaTable[node].front(), 0};
+
+            // Newer kernels name the sibling list core_cpus_list
+            auto siblings = read_index_list_from_file(cpuPath + "/topology/core_cpus_list");
+            if (!siblings)
+                siblings = read_index_list_from_file(cpuPath + "/topology/thread_siblings_list");
+            if (siblings && !siblings->empty()) {
+                std::sort(siblings->begin(), siblings->end());
+                t.core    = siblings->front();
+                t.smtRank = static_cast<int>(std::find(siblings->begin(), siblings->end(), c)
+                                             - siblings->begin());
+            }
+
+            for (int index = 0;; index++) {
+                std::string cachePath = cpuPath + "/cache/index" + std::to_string(index);
+                auto        level     = read_int_from_file(cachePath + "/level");
+                if (!level)
+                    break;
+                if (*level != 3)
+                    continue;
+
+                auto sharedCpus = read_index_list_from_file(cachePath + "/shared_cpu_list");
+                if (sharedCpus && !sharedCpus->empty())
+                    t.l3 = *std::min_element(sharedCpus->begin(), sharedCpus->end());
+                break;
+            }
+
+            // Prefer the scheduler capacity of heterogeneous systems over max frequency
+            auto capacity = read_int_from_file(cpuPath + "/cpu_capacity");
+            if (!capacity)
+                capacity = read_int_from_file(cpuPath + "/cpufreq/cpuinfo_max_freq");
+            t.capacity = capacity.value_or(0);
+
+            topology.push_back(t);
+        }
+    }
 
-    if (numaTable.empty())
+    return topology;
+}
+
+/// PlacementSlot is a cpu set that a thread is bound to, and the node of the cpu set.
+struct PlacementSlot
+{
+    NumaNodeId            node;
+    std::vector<CpuIndex> cpus;
+};
+
+/// build_placement_table() returns the cpu sets that thread idx is bound to in the
+/// order of (idx % number of slots) under the bind policy.
+static std::vector<PlacementSlot> build_placement_table(BindPolicy policy)
+{
+    const NumaTable           &numaTable = numa_table();
+    std::vector<PlacementSlot> slots;
+
+    if (policy == BindPolicy::NONE || numaTable.empty())
+        return slots;
+
+    if (policy == BindPolicy::NUMA) {
+        for (size_t node = 0; node < numaTable.size(); node++)
+            slots.push_back({static_cast<NumaNodeId>(node), numaTable[node]});
+        return slots;
+    }
+
+    std::vector<CpuTopology> topology = build_cpu_topology(numaTable);
+    auto topologyKey = [](const CpuTopology &t) { return std::tie(t.node, t.l3, t.core, t.cpu); };
+
+    switch (policy) {
+    case BindPolicy::COMPACT:
+        std::sort(topology.begin(), topology.end(), [&](const auto &a, const auto &b) {
+            return topologyKey(a) < topologyKey(b);
+        });
+        for (const CpuTopology &t : topology)
+            slots.push_back({t.node, {t.cpu}});
+        break;
+
+    case BindPolicy::SCATTER: {
+        // Number the cores in each L3 domain, so that consecutive threads are spread
+        // over different L3 domains (and numa nodes) before sharing one
+        std::map<CpuIndex, std::set<std::pair<int, CpuIndex>>> domainCores;
+        for (const CpuTopology &t : topology)
+            domainCores[t.l3].insert({-t.capacity, t.core});
+
+        auto coreRank = [&](const CpuTopology &t) {
+            const auto &cores = domainCores[t.l3];
+            return std::distance(cores.begin(), cores.find({-t.capacity, t.core}));
+        };
+        auto scatterKey = [&](const CpuTopology &t) {
+            return std::make_tuple(t.smtRank, -t.capacity, coreRank(t), t.l3, t.cpu);
+        };
+
+        std::sort(topology.begin(), topology.end(), [&](const auto &a, const auto &b) {
+            return scatterKey(a) < scatterKey(b);
+        });
+        for (const CpuTopology &t : topology)
+            slots.push_back({t.node, {t.cpu}});
+        break;
+    }
+
+    case BindPolicy::L3: {
+        std::map<std::pair<NumaNodeId, CpuIndex>, std::vector<CpuIndex>> domains;
+        for (const CpuTopology &t : topology)
+            domains[{t.node, t.l3}].push_back(t.cpu);
+        for (auto &[key, cpus] : domains) {
+            std::sort(cpus.begin(), cpus.end());
+            slots.push_back({key.first, std::move(cpus)});
+        }
+        break;
+    }
+
+    default: break;
+    }
+
+    return slots;
+}
+
+/// placement_table() returns the process-wide placement table of the bind policy,
+/// which is built only once for each policy.
+static const std::vector<PlacementSlot> &placement_table(BindPolicy policy)
+{
+    static const auto placementTables = []() {
+        std::array<std::vector<PlacementSlot>, size_t(BindPolicy::BIND_POLICY_NB)> tables;
+        for (size_t i = 0; i < tables.size(); i++)
+            tables[i] = build_placement_table(static_cast<BindPolicy>(i));
+        return tables;
+    }();
+    return placementTables[size_t(policy)];
+}
+
+// bindThisThread(idx) pins calling thread to the (idx % slots)-th slot of the policy
+NumaNodeId bindThisThread(std::size_t idx, BindPolicy policy)
+{
+    const auto &slots = placement_table(policy);
+
+    if (slots.empty())
         return DefaultNumaNodeId;
 
-    const NumaNodeId node = static_cast<NumaNodeId>(idx % numaTable.size());
-    const auto      &cpus = numaTable[node];
+    const PlacementSlot &slot = slots[idx % slots.size()];
+    const auto          &cpus = slot.cpus;
     if (cpus.empty())
         return DefaultNumaNodeId;
 
     // build CPU mask
-    cpu_set_t *mask = CPU_ALLOC(cpus.back() + 1);
+    CpuIndex   maxCpu = *std::max_element(cpus.begin(), cpus.end());
+    cpu_set_t *mask   = CPU_ALLOC(maxCpu + 1);
     if (!mask)
         return DefaultNumaNodeId;
 
-    const std::size_t masksz = CPU_ALLOC_SIZE(cpus.back() + 1);
+    const std::size_t masksz = CPU_ALLOC_SIZE(maxCpu + 1);
     CPU_ZERO_S(masksz, mask);
     for (CpuIndex c : cpus)
         CPU_SET_S(c, masksz, mask);
@@ -321,17 +556,68 @@ NumaNodeId bindThisThread(std::size_t idx)
         return DefaultNumaNodeId;
 
     sched_yield();  // let the scheduler honour the new mask
-    return node;
+    return slot.node;
+}
+
+// getNodeCpus(node) returns the cpus of node in the same table used for binding
+std::vector<int> getNodeCpus(NumaNodeId node)
+{
+    const NumaTable &numaTable = numa_table();
+
+    if (node < 0 || static_cast<std::size_t>(node) >= numaTable.size())
+        return {};
+
+    return numaTable[node];
+}
+
+size_t getNumNodes()
+{
+    return std::max<size_t>(numa_table().size(), 1);
+}
+
+bool interleaveMemory(void *ptr, size_t size)
+{
+    auto nodeIndices = read_index_list_from_file("/sys/devices/system/node/has_memory");
+    if (!nodeIndices || nodeIndices->empty())
+        return false;
+
+    // Build the node mask. The kernel reads (maxnode - 1) bits from the mask.
+    constexpr size_t BitsPerWord = 8 * sizeof(unsigned long);
+    int              maxNode     = *std::max_element(nodeIndices->begin(), nodeIndices->end());
+    std::vector<unsigned long> nodeMask(maxNode / BitsPerWord + 1, 0);
+    for (int n : *nodeIndices)
+        nodeMask[n / BitsPerWord] |= 1UL << (n % BitsPerWord);
+
+    unsigned long maxNodeBits = nodeMask.size() * BitsPerWord + 1;
+    return syscall(SYS_mbind, ptr, size, MPOL_INTERLEAVE, nodeMask.data(), maxNodeBits, 0) == 0;
 }
 
 #else
 
 /// Do no-op and return the default numa node id for unsupported platforms.
-NumaNodeId bindThisThread(size_t)
+NumaNodeId bindThisThread(size_t, BindPolicy)
 {
     return DefaultNumaNodeId;
 }
 
+/// Cpu set of numa nodes is unknown for unsupported platforms.
+std::vector<int> getNodeCpus(NumaNodeId)
+{
+    return {};
+}
+
+/// Unsupported platforms are regarded as having only one numa node.
+size_t getNumNodes()
+{
+    return 1;
+}
+
+/// Memory policy of an address range is not supported on unsupported platforms.
+bool interleaveMemory(void *, size_t)
+{
+    return false;
+}
+
 #endif
 
 }  // namespace Numa
@@ -424,52 +710,305 @@ void *alignedLargePageAllocWindows(size_t size)
 #endif
 }
 
+namespace {
+
+#if defined(__linux__) && defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    #define HUGETLB_ALLOC
+
+/// Map anonymous memory backed by explicit huge pages of the given size (in log2) from
+/// hugetlbfs. This needs huge pages reserved in advance by the system administrator
+/// (vm.nr_hugepages or hugepages= boot parameter), otherwise nullptr is returned.
+void *hugeTlbAlloc(size_t size, int pageSizeLog2)
+{
+    int   flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (pageSizeLog2 << MAP_HUGE_SHIFT);
+    void *mem   = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return mem == MAP_FAILED ? nullptr : mem;
+}
+#endif
+
+/// Information of a live large page allocation, needed to free it properly.
+struct LargePageAllocation
+{
+    size_t        size;
+    LargePageType type;
+    MemoryTag     tag;
+};
+
+/// Tracked bytes of each memory tag. Zero-initialized before any dynamic initialization.
+std::atomic<size_t> trackedBytes[size_t(MemoryTag::MEMORY_TAG_NB)];
+
+/// Memory counter registered by addMemoryCounter().
+struct MemoryCounter
+{
+    MemoryTag               tag;
+    const void             *owner;
+    std::function<size_t()> counter;
+};
+
+std::mutex memoryCounterMutex;
+
+/// All registered memory counters. This is a function local static, as counters
+/// might be registered during static initialization of other translation units.
+std::vector<MemoryCounter> &memoryCounters()
+{
+    static std::vector<MemoryCounter> counters;
+    return counters;
+}
+
+/// Tag of large page allocations on this thread, set by MemoryTagScope.
+thread_local MemoryTag currentMemoryTag = MemoryTag::OTHER;
+
+std::mutex    largePageMutex;
+LargePageType currentLargePageLimit = LargePageType::LARGE_PAGE;
+
+/// All live large page allocations. This is a function local static, as allocations
+/// might happen during static initialization of other translation units.
+std::map<const void *, LargePageAllocation> &largePageAllocations()
+{
+    static std::map<const void *, LargePageAllocation> allocations;
+    return allocations;
+}
+
+}  // namespace
+
+const char *largePageTypeName(LargePageType type)
+{
+    switch (type) {
+    case LargePageType::TRANSPARENT: return "transparent huge pages";
+    case LargePageType::HUGETLB_2MB: return "2MB huge pages";
+    case LargePageType::HUGETLB_1GB: return "1GB huge pages";
+    case LargePageType::LARGE_PAGE: return "large pages";
+    default: return "normal pages";
+    }
+}
+
+void setLargePageLimit(LargePageType limit)
+{
+    std::lock_guard<std::mutex> lock(largePageMutex);
+    currentLargePageLimit = limit;
+}
+
+LargePageType largePageLimit()
+{
+    std::lock_guard<std::mutex> lock(largePageMutex);
+    return currentLargePageLimit;
+}
+
 void *alignedLargePageAlloc(size_t size)
 {
+    LargePageType limit = largePageLimit();
+
+    void         *mem  = nullptr;
+    LargePageType type = LargePageType::NORMAL;
+
 #ifdef _WIN32
-    // Try to allocate large pages
-    void *mem = alignedLargePageAllocWindows(size);
+    // Try to allocate large pages if any kind of explicit huge page is allowed
+    if (limit >= LargePageType::HUGETLB_2MB)
+        mem = alignedLargePageAllocWindows(size);
 
     // Fall back to regular, page aligned, allocation if necessary
     if (!mem)
         mem = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
     else {
+        type              = LargePageType::LARGE_PAGE;
         static bool _init = []() {
             MESSAGEL("Large page memory allocation enabled.");
             return true;
         }();
     }
-
-    return mem;
 #else
+    constexpr size_t PageSize2MB = size_t(1) << 21;
+    constexpr size_t PageSize1GB = size_t(1) << 30;
+
+    auto roundUp = [](size_t size, size_t alignment) {
+        return ((size + alignment - 1) / alignment) * alignment;
+    };
+
+    #ifdef HUGETLB_ALLOC
+    // Explicit huge pages are only tried for allocations of at least one page, so
+    // that rounding up never wastes more than half of the reserved huge pages.
+    if (limit >= LargePageType::HUGETLB_1GB && size >= PageSize1GB) {
+        size_t allocSize = roundUp(size, PageSize1GB);
+        if ((mem = hugeTlbAlloc(allocSize, 30))) {
+            size = allocSize;
+            type = LargePageType::HUGETLB_1GB;
+        }
+    }
+    if (!mem && limit >= LargePageType::HUGETLB_2MB && size >= PageSize2MB) {
+        size_t allocSize = roundUp(size, PageSize2MB);
+        if ((mem = hugeTlbAlloc(allocSize, 21))) {
+            size = allocSize;
+            type = LargePageType::HUGETLB_2MB;
+        }
+    }
+    #endif
+
+    if (!mem) {
     #if defined(__linux__)
-    constexpr size_t alignment = 2 * 1024 * 1024;  // assumed 2MB page size
+        // Align to the assumed 2MB transparent huge page size, so that the whole
+        // allocation can be covered by huge pages
+        size_t alignment = limit >= LargePageType::TRANSPARENT ? PageSize2MB : 4096;
     #else
-    constexpr size_t alignment = 4096;  // assumed small page size
+        size_t alignment = 4096;  // assumed small page size
     #endif
+        size = roundUp(size, alignment);
+        mem  = alignedAlloc(alignment, size);
 
-    // round up to multiples of alignment
-    size      = ((size + alignment - 1) / alignment) * alignment;
-    void *mem = alignedAlloc(alignment, size);
     #if defined(MADV_HUGEPAGE)
-    madvise(mem, size, MADV_HUGEPAGE);
+        if (mem && limit >= LargePageType::TRANSPARENT && !madvise(mem, size, MADV_HUGEPAGE))
+            type = LargePageType::TRANSPARENT;
     #endif
+    }
+#endif
 
+    if (mem) {
+        std::lock_guard<std::mutex> lock(largePageMutex);
+        largePageAllocations()[mem] = {size, type, currentMemoryTag};
+        trackAlloc(currentMemoryTag, size);
+    }
     return mem;
-#endif
 }
 
 void alignedLargePageFree(void *ptr)
 {
+    if (!ptr)
+        return;
+
+    LargePageAllocation allocation {0, LargePageType::NORMAL, MemoryTag::OTHER};
+    {
+        std::lock_guard<std::mutex> lock(largePageMutex);
+        auto                        it = largePageAllocations().find(ptr);
+        if (it != largePageAllocations().end()) {
+            allocation = it->second;
+            largePageAllocations().erase(it);
+        }
+    }
+    trackFree(allocation.tag, allocation.size);
+
 #ifdef _WIN32
-    if (ptr && !VirtualFree(ptr, 0, MEM_RELEASE)) {
+    if (!VirtualFree(ptr, 0, MEM_RELEASE)) {
         DWORD err = GetLastError();
         ERRORL("Failed to free large page memory. Error code: 0x" << std::hex << err << std::dec);
         std::exit(EXIT_FAILURE);
     }
 #else
+    #ifdef HUGETLB_ALLOC
+    if (allocation.type == LargePageType::HUGETLB_1GB
+        || allocation.type == LargePageType::HUGETLB_2MB) {
+        munmap(ptr, allocation.size);
+        return;
+    }
+    #endif
     alignedFree(ptr);
 #endif
 }
 
+LargePageType largePageType(const void *ptr)
+{
+    std::lock_guard<std::mutex> lock(largePageMutex);
+    auto                        it = largePageAllocations().find(ptr);
+    return it != largePageAllocations().end() ? it->second.type : LargePageType::NORMAL;
+}
+
+const char *memoryTagName(MemoryTag tag)
+{
+    switch (tag) {
+    case MemoryTag::HASH_TABLE: return "hash table";
+    case MemoryTag::MCTS_TREE: return "mcts tree";
+    case MemoryTag::BOARD: return "boards";
+    case MemoryTag::ACCUMULATOR: return "accumulators";
+    case MemoryTag::WEIGHT: return "weights";
+    case MemoryTag::DATABASE: return "database cache";
+    default: return "other";
+    }
+}
+
+void trackAlloc(MemoryTag tag, size_t size)
+{
+    trackedBytes[size_t(tag)].fetch_add(size, std::memory_order_relaxed);
+}
+
+void trackFree(MemoryTag tag, size_t size)
+{
+    trackedBytes[size_t(tag)].fetch_sub(size, std::memory_order_relaxed);
+}
+
+void addMemoryCounter(MemoryTag tag, const void *owner, std::function<size_t()> counter)
+{
+    std::lock_guard<std::mutex> lock(memoryCounterMutex);
+    memoryCounters().push_back({tag, owner, std::move(counter)});
+}
+
+void removeMemoryCounter(const void *owner)
+{
+    std::lock_guard<std::mutex> lock(memoryCounterMutex);
+    auto                       &counters = memoryCounters();
+    counters.erase(std::remove_if(counters.begin(),
+                                  counters.end(),
+                                  [=](const MemoryCounter &c) { return c.owner == owner; }),
+                   counters.end());
+}
+
+size_t trackedMemory(MemoryTag tag)
+{
+    size_t bytes = trackedBytes[size_t(tag)].load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(memoryCounterMutex);
+    for (const MemoryCounter &c : memoryCounters())
+        if (c.tag == tag)
+            bytes += c.counter();
+    return bytes;
+}
+
+size_t trackedMemoryTotal()
+{
+    size_t total = 0;
+    for (size_t i = 0; i < size_t(MemoryTag::MEMORY_TAG_NB); i++)
+        total += trackedMemory(MemoryTag(i));
+    return total;
+}
+
+size_t residentMemory()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+    return 0;
+#elif defined(__linux__) && !defined(__ANDROID__)
+    // The second field of statm is the number of resident pages
+    std::ifstream statm("/proc/self/statm");
+    size_t        totalPages = 0, residentPages = 0;
+    if (statm >> totalPages >> residentPages)
+        return residentPages * size_t(sysconf(_SC_PAGESIZE));
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+void printMemoryUsage()
+{
+    size_t total    = trackedMemoryTotal();
+    size_t resident = residentMemory();
+    MESSAGEL("Memory usage (KB):");
+    for (size_t i = 0; i < size_t(MemoryTag::MEMORY_TAG_NB); i++)
+        MESSAGEL("  " << memoryTagName(MemoryTag(i)) << ": " << trackedMemory(MemoryTag(i)) / 1024);
+    MESSAGEL("  total tracked: " << total / 1024);
+    if (resident) {
+        MESSAGEL("  resident: " << resident / 1024);
+        MESSAGEL("  untracked: " << (resident > total ? resident - total : 0) / 1024);
+    }
+}
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag) : prevTag(currentMemoryTag)
+{
+    currentMemoryTag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+    currentMemoryTag = prevTag;
+}
+
 }  // namespace MemAlloc
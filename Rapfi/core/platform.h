@@ -37,8 +37,10 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 // Define some macros for platform specific optimization hint
 #if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
@@ -276,13 +278,55 @@ constexpr NumaNodeId DefaultNumaNodeId = 0;
 /// use NUMA-aware logic.
 constexpr int BindGroupThreshold = 8;
 
+/// BindPolicy controls how search threads are placed on logical processors.
+enum class BindPolicy {
+    NONE,     // Never bind threads, leave the placement to the OS scheduler
+    NUMA,     // Bind threads to numa nodes in round-robin order when there are more
+              // than BindGroupThreshold threads (default)
+    COMPACT,  // Pin threads to logical processors in topology order, filling all SMT
+              // siblings of a core and all cores of a cache domain before the next
+    SCATTER,  // Pin threads to one logical processor of each physical core first, with
+              // higher capacity cores and different L3 domains preferred, then to the
+              // remaining SMT siblings
+    L3,       // Bind threads to L3 cache domains in round-robin order
+    BIND_POLICY_NB
+};
+
+/// Returns the config name of the bind policy.
+const char *bindPolicyName(BindPolicy policy);
+
+/// Set the policy used by bindThisThread() for search threads.
+void setBindPolicy(BindPolicy policy);
+/// Returns the policy used by bindThisThread() for search threads.
+BindPolicy bindPolicy();
+
+/// Returns whether search threads should be bound under the current bind policy
+/// when there are numThreads threads in total.
+bool needBindThreads(size_t numThreads);
+
 /// Under Windows it is not possible for a process to run on more than one
 /// logical processor group. This usually means to be limited to use max 64
 /// cores. To overcome this, some special platform specific API should be
 /// called to set group affinity for each thread. Original code from Texel by
 /// Peter Österlund. We also let this function return the numa node ID for
 /// the thread, to allow NUMA-aware logics in the thread.
-NumaNodeId bindThisThread(size_t idx);
+/// Placement policies other than NUMA need the cpu topology from sysfs, thus
+/// are only supported on Linux, and fall back to NUMA on other platforms.
+NumaNodeId bindThisThread(size_t idx, BindPolicy policy = bindPolicy());
+
+/// Returns the (0-based) logical processor indices of the numa node, which uses the
+/// same node numbering as bindThisThread(). An empty list is returned if the cpu
+/// set of the node is unknown on this platform.
+std::vector<int> getNodeCpus(NumaNodeId node);
+
+/// Returns the number of numa nodes that bindThisThread() distributes threads to.
+/// Node IDs returned by bindThisThread() are always less than this number.
+size_t getNumNodes();
+
+/// Set the memory policy of an address range to interleave its pages across all numa
+/// nodes with memory. This must be called before the pages are first touched.
+/// @return Whether the policy is applied. Only supported on Linux.
+bool interleaveMemory(void *ptr, size_t size);
 
 }  // namespace Numa
 
@@ -303,6 +347,25 @@ T *alignedArrayAlloc(size_t arraySize)
     return reinterpret_cast<T *>(alignedAlloc(Alignment, sizeof(T) * arraySize));
 }
 
+/// LargePageType represents the kind of pages backing a large page allocation,
+/// in the order of preference.
+enum class LargePageType {
+    NORMAL,       // Regular small pages
+    TRANSPARENT,  // Regular pages advised to be merged into transparent huge pages
+    HUGETLB_2MB,  // Explicit 2MB huge pages from hugetlbfs (Linux)
+    HUGETLB_1GB,  // Explicit 1GB huge pages from hugetlbfs (Linux)
+    LARGE_PAGE,   // Large pages with SeLockMemoryPrivilege (Windows)
+};
+
+/// Returns the name of the large page type.
+const char *largePageTypeName(LargePageType type);
+
+/// Set the most preferred page type tried by alignedLargePageAlloc(). Allocations
+/// try page types from the limit down to NORMAL, and use the first one that succeeds.
+void setLargePageLimit(LargePageType limit);
+/// Returns the most preferred page type tried by alignedLargePageAlloc().
+LargePageType largePageLimit();
+
 /// Allocate large page memory, with min alignment 4KiB. Memory allocated
 /// using this function should be freed with alignedLargePageFree().
 void *alignedLargePageAlloc(size_t size);
@@ -310,6 +373,62 @@ void *alignedLargePageAlloc(size_t size);
 /// Free memory allocated by alignedLargePageAlloc().
 void alignedLargePageFree(void *ptr);
 
+/// Returns the page type of memory allocated by alignedLargePageAlloc().
+LargePageType largePageType(const void *ptr);
+
+// -------------------------------------------------
+// Memory accounting
+
+/// MemoryTag is the subsystem that a tracked allocation is accounted to.
+enum class MemoryTag {
+    OTHER,
+    HASH_TABLE,
+    MCTS_TREE,
+    BOARD,
+    ACCUMULATOR,
+    WEIGHT,
+    DATABASE,
+    MEMORY_TAG_NB
+};
+
+/// Returns the name of the memory tag.
+const char *memoryTagName(MemoryTag tag);
+
+/// Account size bytes of allocated memory to the subsystem. This is thread-safe.
+void trackAlloc(MemoryTag tag, size_t size);
+/// Remove size bytes of freed memory from the subsystem. This is thread-safe.
+void trackFree(MemoryTag tag, size_t size);
+/// Register a counter that reports the bytes its owner accounts to the subsystem. This lets
+/// hot allocation paths keep their own (e.g. sharded) counters, which are only summed when
+/// the tracked memory is read. The counter must be thread-safe.
+void addMemoryCounter(MemoryTag tag, const void *owner, std::function<size_t()> counter);
+/// Unregister all counters of the owner. After this returns, none of them is being called.
+void removeMemoryCounter(const void *owner);
+/// Returns the number of bytes currently accounted to the subsystem.
+size_t trackedMemory(MemoryTag tag);
+/// Returns the number of bytes currently accounted to all subsystems.
+size_t trackedMemoryTotal();
+
+/// Returns the resident set size of this process in bytes, or 0 if it is unknown.
+size_t residentMemory();
+
+/// Print the tracked memory of each subsystem and the resident memory of this process.
+void printMemoryUsage();
+
+/// MemoryTagScope sets the tag that alignedLargePageAlloc() accounts allocations
+/// to on this thread (OTHER by default) during its lifetime.
+class MemoryTagScope
+{
+public:
+    explicit MemoryTagScope(MemoryTag tag);
+    ~MemoryTagScope();
+    MemoryTagScope(const MemoryTagScope &)            = delete;
+    MemoryTagScope &operator=(const MemoryTagScope &) = delete;
+
+private:
+    MemoryTag prevTag;
+};
+
 }  // namespace MemAlloc
 
 template <typename T>
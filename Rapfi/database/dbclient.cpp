@@ -18,6 +18,7 @@
 
 #include "dbclient.h"
 
+#include "../core/platform.h"
 #include "../game/board.h"
 
 #include <algorithm>
@@ -26,6 +27,8 @@
 #include <mutex>
 #include <set>
 #ifdef MULTI_THREADING
+    #include <atomic>
+    #include <condition_variable>
     #include <thread>
 #endif
 
@@ -473,6 +476,104 @@ bool checkOverwrite(const DBRecord &oldRecord,
     }
 }
 
+#ifdef MULTI_THREADING
+
+/// Prefetcher reads the storage for prefetch requests on a background thread.
+/// Requests are consumed in batches, and results are only handed back to the owning
+/// client, as all caches of the client are not thread-safe.
+struct DBClient::Prefetcher
+{
+    /// Requests beyond this number are dropped to keep the queue latency low.
+    static constexpr size_t MaxPendingRequests = 64;
+
+    struct Request
+    {
+        HashKey  hashKey;
+        uint32_t generation;
+        uint32_t storageGeneration;
+        DBKey    key;  // Not yet sorted or transformed to the smallest key
+    };
+    struct Result
+    {
+        HashKey  hashKey;
+        uint32_t generation;
+        uint32_t storageGeneration;
+        bool     found;
+        DBRecord record;
+    };
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    std::vector<Request>    requests;
+    std::vector<Result>     results;
+    std::atomic<bool>       hasResults {false};
+    bool                    exit {false};
+    std::thread             thread;
+
+    Prefetcher(DBStorage &storage, DBRecordMask mask)
+    {
+        requests.reserve(MaxPendingRequests);
+        thread = std::thread([this, &storage, mask] { run(storage, mask); });
+    }
+
+    ~Prefetcher()
+    {
+        {
+            std::lock_guard lock(mutex);
+            exit = true;
+        }
+        cv.notify_one();
+        thread.join();
+    }
+
+    void run(DBStorage &storage, DBRecordMask mask)
+    {
+        std::vector<Request> batch;
+        std::vector<Result>  fetched;
+        batch.reserve(MaxPendingRequests);
+
+        while (true) {
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&] { return exit || !requests.empty(); });
+                if (exit)
+                    return;
+                batch.swap(requests);
+            }
+
+            for (Request &req : batch) {
+                DBKey &key = req.key;
+                std::sort(key.stones, key.stones + key.numBlackStones, std::less<StonePos>());
+                std::sort(key.stones + key.numBlackStones,
+                          key.stones + key.numStones(),
+                          std::less<StonePos>());
+                toSmallestDBKey(key);
+
+                Result &result           = fetched.emplace_back();
+                result.hashKey           = req.hashKey;
+                result.generation        = req.generation;
+                result.storageGeneration = req.storageGeneration;
+                result.found             = storage.get(key, result.record, mask);
+            }
+            batch.clear();
+
+            {
+                std::lock_guard lock(mutex);
+                std::move(fetched.begin(), fetched.end(), std::back_inserter(results));
+                hasResults.store(true, std::memory_order_release);
+            }
+            fetched.clear();
+        }
+    }
+};
+
+#else
+
+struct DBClient::Prefetcher
+{};
+
+#endif
+
 DBClient::DBClient(DBStorage   &storage,
                    DBRecordMask recordMask,
                    size_t       dbCacheSize,
@@ -481,14 +582,22 @@ DBClient::DBClient(DBStorage   &storage,
     , mask(recordMask)
     , dbCache(std::max<size_t>(dbCacheSize, 1))
     , dbRecordCache(std::max<size_t>(dbRecordCacheSize, 1))
-{}
+    , cacheGeneration(0)
+{
+    updateMemoryUsage();
+}
 
 DBClient ::~DBClient()
 {
+    // Stop the prefetcher first, as it might still be reading the storage
+    prefetcher.reset();
+
     for (auto &[hashKey, entryCache] : dbCache) {
         if (entryCache.dirty)
-            storage.set(entryCache.key, entryCache.record, mask);
+            writeBack(entryCache);
     }
+
+    MemAlloc::trackFree(MemAlloc::MemoryTag::DATABASE, trackedMemorySize);
 }
 
 bool DBClient::query(const Board &board, Rule rule, DBRecord &record)
@@ -500,11 +609,23 @@ bool DBClient::query(const Board &board, Rule rule, DBRecord &record)
     if (cachedHashKey == hashKey)
         return record = cachedRecord, true;
 
+#ifdef MULTI_THREADING
+    if (prefetcher && prefetcher->hasResults.load(std::memory_order_acquire)) {
+        collectPrefetchResults();
+        if (cachedHashKey == hashKey)
+            return record = cachedRecord, true;
+    }
+#endif
+
     // Try find this database entry in dbCache
     auto entryCache = dbCache.get(hashKey);
     if (entryCache)
         return record = entryCache->record, true;
 
+    // Skip the storage if a prefetch has already found no such entry
+    if (isKnownMissing(hashKey))
+        return false;
+
     // Read record from storage and save it in record cache
     DBKey dbKey = constructDBKey(board, rule);
     if (storage.get(dbKey, record, mask)) {
@@ -514,18 +635,123 @@ bool DBClient::query(const Board &board, Rule rule, DBRecord &record)
                     [&](std::pair<HashKey, EntryCache> &&cache) {
                         auto &&entryCache = cache.second;
                         if (entryCache.dirty)
-                            storage.set(entryCache.key, entryCache.record, mask);
+                            writeBack(entryCache);
                     });
 
         // Svae a new record cache in dbRecordCache
         dbRecordCache[hashKey] = std::make_pair(hashKey, record);
 
+        updateMemoryUsage();
         return true;
     }
 
     return false;
 }
 
+void DBClient::prefetch(const Board &board, Rule rule, const Pos *moves, size_t numMoves)
+{
+#ifdef MULTI_THREADING
+    if (!prefetcher) {
+        prefetcher = std::make_unique<Prefetcher>(storage, mask);
+        dbMissCache.assign(dbRecordCache.size(), MissEntry {DBRecordCache::NullKey, 0});
+        updateMemoryUsage();
+    }
+
+    // Collect stones of the current position, the same way as constructDBKey()
+    int      numStones[SIDE_NB] = {0, 0};
+    StonePos stones[SIDE_NB][MAX_MOVES];
+    for (int ply = 0; ply < board.ply(); ply++) {
+        Pos move = board.getHistoryMove(ply);
+        if (move == Pos::PASS)
+            continue;
+
+        Color c = board.cell(move).piece;
+        if (c == BLACK || c == WHITE)
+            stones[c][numStones[c]++] = {move.x(), move.y()};
+    }
+
+    Color    side              = board.sideToMove();
+    HashKey  hashKey           = board.zobristKey();
+    uint32_t storageGeneration = storage.clientWriteGeneration.load(std::memory_order_acquire);
+    for (size_t i = 0; i < numMoves; i++) {
+        Pos move = moves[i];
+        if (move != Pos::PASS) {
+            if (!board.isInBoard(move) || !board.isEmpty(move))
+                break;
+            stones[side][numStones[side]++] = {move.x(), move.y()};
+        }
+        // Follows Board::zobristKeyAfter()
+        hashKey ^= Hash::zobristSide[side] ^ Hash::zobristSide[~side]
+                   ^ (move != Pos::PASS ? Hash::zobrist[side][move] : HashKey {});
+        side = ~side;
+
+        // Skip positions whose query will not reach the storage anyway
+        if (dbRecordCache[hashKey].first == hashKey || isKnownMissing(hashKey))
+            continue;
+
+        std::lock_guard lock(prefetcher->mutex);
+        if (prefetcher->requests.size() >= Prefetcher::MaxPendingRequests)
+            break;
+
+        Prefetcher::Request &req = prefetcher->requests.emplace_back();
+        req.hashKey              = hashKey;
+        req.generation           = cacheGeneration;
+        req.storageGeneration    = storageGeneration;
+        req.key.rule             = rule;
+        req.key.boardWidth       = board.size();
+        req.key.boardHeight      = board.size();
+        req.key.sideToMove       = side;
+        req.key.numBlackStones   = numStones[BLACK];
+        req.key.numWhiteStones   = numStones[WHITE];
+        auto it = std::copy_n(stones[BLACK], numStones[BLACK], req.key.stones);
+        std::copy_n(stones[WHITE], numStones[WHITE], it);
+        prefetcher->cv.notify_one();
+    }
+#endif
+}
+
+void DBClient::collectPrefetchResults()
+{
+#ifdef MULTI_THREADING
+    std::vector<Prefetcher::Result> results;
+    {
+        std::lock_guard lock(prefetcher->mutex);
+        results.swap(prefetcher->results);
+        prefetcher->hasResults.store(false, std::memory_order_relaxed);
+    }
+
+    for (Prefetcher::Result &result : results) {
+        // Records fetched before a save or sync might be outdated
+        if (result.generation != cacheGeneration)
+            continue;
+
+        HashKey hashKey = result.hashKey;
+        if (result.found)
+            dbRecordCache[hashKey] = std::make_pair(hashKey, std::move(result.record));
+        else
+            dbMissCache[(uint32_t)hashKey & (dbMissCache.size() - 1)] = {hashKey,
+                                                                         result.storageGeneration};
+    }
+#endif
+}
+
+bool DBClient::isKnownMissing(HashKey hashKey) const
+{
+    if (dbMissCache.empty())
+        return false;
+
+    const MissEntry &entry = dbMissCache[(uint32_t)hashKey & (dbMissCache.size() - 1)];
+    return entry.hashKey == hashKey
+           && entry.storageGeneration
+                  == storage.clientWriteGeneration.load(std::memory_order_acquire);
+}
+
+void DBClient::writeBack(const EntryCache &entryCache)
+{
+    storage.set(entryCache.key, entryCache.record, mask);
+    storage.clientWriteGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
 std::vector<std::pair<Pos, DBRecord>> DBClient::queryChildren(const Board &board, Rule rule)
 {
     DBRecord record;
@@ -646,6 +872,10 @@ bool DBClient::save(const Board &board, Rule rule, const DBRecord &record, Overw
     bool    overwrite = owRule == OverwriteRule::Always
                      || owRule != OverwriteRule::Disabled && !(mask & RECORD_MASK_LVDB);
 
+    // Outdate all in-flight prefetches and previously missing entries of all clients
+    cacheGeneration++;
+    storage.clientWriteGeneration.fetch_add(1, std::memory_order_acq_rel);
+
     // Try find this database entry in dbCache
     if (auto entryCache = dbCache.get(hashKey); entryCache) {
         if (overwrite || checkOverwrite(entryCache->record, record, owRule)) {
@@ -689,9 +919,10 @@ bool DBClient::save(const Board &board, Rule rule, const DBRecord &record, Overw
                     [&](std::pair<HashKey, EntryCache> &&cache) {
                         auto &&entryCache = cache.second;
                         if (entryCache.dirty)
-                            storage.set(entryCache.key, entryCache.record, mask);
+                            writeBack(entryCache);
                     });
         dbRecordCache[hashKey] = std::make_pair(hashKey, record);
+        updateMemoryUsage();
         return true;
     }
     else
@@ -706,6 +937,8 @@ void DBClient::del(const Board &board, Rule rule)
     auto &[cachedHashKey, cachedRecord] = dbRecordCache[hashKey];
     if (cachedHashKey == hashKey)
         cachedHashKey = DBRecordCache::NullKey;
+    cacheGeneration++;
+    storage.clientWriteGeneration.fetch_add(1, std::memory_order_acq_rel);
 
     // Iterate all parent keys of the deleted key, to remove its board text
     auto deleteParentBoardText = [&](const DBKey    &parentKey,
@@ -739,6 +972,7 @@ void DBClient::del(const Board &board, Rule rule)
         storage.del(entryCache->key);
         iterateParentKeys(storage, entryCache->key, deleteParentBoardText);
         dbCache.remove(hashKey);
+        updateMemoryUsage();
     }
     else {
         DBKey dbKey = constructDBKey(board, rule);
@@ -784,7 +1018,7 @@ void DBClient::sync(bool clearCache)
 {
     for (auto &[hashKey, entryCache] : dbCache) {
         if (entryCache.dirty) {
-            storage.set(entryCache.key, entryCache.record, mask);
+            writeBack(entryCache);
             entryCache.dirty = false;
         }
     }
@@ -793,7 +1027,27 @@ void DBClient::sync(bool clearCache)
         // Clear all cache as records in dbStorage might be newer
         dbCache.clear();
         dbRecordCache.clear();
+        std::fill(dbMissCache.begin(), dbMissCache.end(), MissEntry {DBRecordCache::NullKey, 0});
+        cacheGeneration++;
+        updateMemoryUsage();
     }
 }
 
+void DBClient::updateMemoryUsage()
+{
+    // Each LRU cache entry also has a list node and a hash map node, which are estimated
+    // as a few pointers. Memory of record texts is not accounted.
+    constexpr size_t EntryCacheSize =
+        sizeof(std::pair<HashKey, EntryCache>) + sizeof(HashKey) + 5 * sizeof(void *);
+
+    size_t memorySize = dbCache.size() * EntryCacheSize
+                        + dbRecordCache.size() * sizeof(DBRecordCache::KVType)
+                        + dbMissCache.capacity() * sizeof(MissEntry);
+    if (memorySize > trackedMemorySize)
+        MemAlloc::trackAlloc(MemAlloc::MemoryTag::DATABASE, memorySize - trackedMemorySize);
+    else
+        MemAlloc::trackFree(MemAlloc::MemoryTag::DATABASE, trackedMemorySize - memorySize);
+    trackedMemorySize = memorySize;
+}
+
 }  // namespace Database
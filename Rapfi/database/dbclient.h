@@ -88,6 +88,13 @@ public:
     /// @return Whether current position exists in the database.
     bool query(const Board &board, Rule rule, DBRecord &record);
 
+    /// Asynchronously fetch the records of the positions reached by playing the given
+    /// move sequence from the current position, one position per prefix of the sequence.
+    /// Fetched records are moved into the record cache on a later query(), so that their
+    /// queries no longer block on the storage. This is a no-op without multi-threading.
+    /// @param moves The move sequence to play, with alternating side to move.
+    void prefetch(const Board &board, Rule rule, const Pos *moves, size_t numMoves);
+
     /// Query all existing children of the current position.
     /// @return The list of all children, in forms of (Pos, Record).
     ///     The list is sorted by Pos's board traversal order (ascending order).
@@ -157,6 +164,7 @@ private:
             clear();
         }
         KVType &operator[](HashKey key) { return table[(uint32_t)key & (table.size() - 1)]; }
+        size_t  size() const { return table.size(); }
         void    clear()
         {
             for (auto &[k, v] : table)
@@ -166,6 +174,35 @@ private:
     private:
         std::vector<KVType> table;
     } dbRecordCache;
+
+    /// Positions that a prefetch has found to be missing from the storage, so that
+    /// querying them again does not hit the storage. A miss is only valid until the next
+    /// write to the storage through any client. Index only by hash key.
+    struct MissEntry
+    {
+        HashKey  hashKey;
+        uint32_t storageGeneration;
+    };
+    std::vector<MissEntry> dbMissCache;
+    /// Generation of the cache content, increased on every save or sync, so that records
+    /// fetched before a modification are discarded instead of overwriting newer ones.
+    uint32_t cacheGeneration;
+
+    /// Prefetcher owns the background thread that reads the storage for prefetch requests.
+    struct Prefetcher;
+    std::unique_ptr<Prefetcher> prefetcher;
+
+    /// Bytes of the caches above that are accounted to the database memory tag.
+    size_t trackedMemorySize = 0;
+
+    /// Move all finished prefetch results into the record cache and the miss cache.
+    void collectPrefetchResults();
+    /// Check if a prefetch has found the position to be missing since the last write.
+    bool isKnownMissing(HashKey hashKey) const;
+    /// Write a dirty entry back to the storage.
+    void writeBack(const EntryCache &entryCache);
+    /// Update the accounted memory after the caches have grown or shrunk.
+    void updateMemoryUsage();
 };
 
 }  // namespace Database
@@ -22,6 +22,7 @@
 #include "dbtypes.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <ostream>
@@ -231,6 +232,11 @@ public:
     ///     cursor which means all entries in the database have been iterated.
     virtual Cursor
     scan(Cursor cursor, size_t count, std::vector<std::pair<DBKey, DBRecord>> &out) noexcept = 0;
+
+    /// Generation of the storage content shared by all clients of this storage. Clients
+    /// increase it whenever they write to the storage, which expires the missing entries
+    /// that any client has cached.
+    std::atomic<uint32_t> clientWriteGeneration = 0;
 };
 
 /// The base exception class for a db storage error.
@@ -172,7 +172,7 @@ bool YXDBStorage::flush() noexcept
     std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
     if (file.is_open()) {
         Compressor    compressor(static_cast<std::ostream &>(file),
-                              compressedSave ? Compressor::Type::LZ4_DEFAULT
+                              compressedSave ? Compressor::Type::LZ4_PARALLEL
                                                 : Compressor::Type::NO_COMPRESS);
         std::ostream *ostreamPtr = compressor.openOutputStream();
         if (ostreamPtr && *ostreamPtr) {
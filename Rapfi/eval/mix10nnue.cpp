@@ -210,10 +210,13 @@ Accumulator::Accumulator(int boardSize)
     versionChangeNumTable  = new ChangeNum[nCells + 1];
     versionInnerIndexTable = new uint16_t[(nCells + 1) * nCells];
     versionOuterIndexTable = new uint16_t[(nCells + 2) * outerBoardSize * outerBoardSize];
+    versionPlyTable        = new uint16_t[nCells + 1];
+    stoneHistory           = new StonePlacement[nCells];
     indexTable             = new std::array<uint32_t, 4>[nInnerChanges];
     mapSum = MemAlloc::alignedArrayAlloc<std::array<int16_t, FeatureDim>, Alignment>(nInnerChanges);
     mapConv =
         MemAlloc::alignedArrayAlloc<std::array<int16_t, FeatDWConvDim>, Alignment>(nOuterChanges);
+    MemAlloc::trackAlloc(MemAlloc::MemoryTag::ACCUMULATOR, memoryUsage());
 
     // Compute group index based on board pos
     std::fill_n(groupIndex, arraySize(groupIndex), 0);
@@ -240,9 +243,28 @@ Accumulator::~Accumulator()
     delete[] versionChangeNumTable;
     delete[] versionInnerIndexTable;
     delete[] versionOuterIndexTable;
+    delete[] versionPlyTable;
+    delete[] stoneHistory;
     delete[] indexTable;
     MemAlloc::alignedFree(mapSum);
     MemAlloc::alignedFree(mapConv);
+    MemAlloc::trackFree(MemAlloc::MemoryTag::ACCUMULATOR, memoryUsage());
+}
+
+/// Memory owned by this accumulator, including all its tables.
+size_t Accumulator::memoryUsage() const
+{
+    size_t nCells        = boardSize * boardSize;
+    size_t nOuterCells   = outerBoardSize * outerBoardSize;
+    size_t nInnerChanges = MaxInnerChanges[boardSize];
+    size_t nOuterChanges = MaxOuterChanges[boardSize];
+
+    return sizeof(Accumulator) + (nCells + 1) * sizeof(ValueSumType)
+           + (nCells + 1) * sizeof(ChangeNum) + (nCells + 1) * nCells * sizeof(uint16_t)
+           + (nCells + 2) * nOuterCells * sizeof(uint16_t) + (nCells + 1) * sizeof(uint16_t)
+           + nCells * sizeof(StonePlacement) + nInnerChanges * sizeof(std::array<uint32_t, 4>)
+           + nInnerChanges * sizeof(std::array<int16_t, FeatureDim>)
+           + nOuterChanges * sizeof(std::array<int16_t, FeatDWConvDim>);
 }
 
 void Accumulator::initIndexTable()
@@ -406,7 +428,8 @@ void Accumulator::clear(const Weight &w)
     }
 
     // Reset version and init version table to be zeros
-    currentVersion = 0;
+    currentVersion     = 0;
+    versionPlyTable[0] = 0;
 }
 
 void Accumulator::move(const Weight &w, Color pieceColor, int x, int y)
@@ -620,6 +643,246 @@ void Accumulator::move(const Weight &w, Color pieceColor, int x, int y)
             }
     valueSumNew.small_value_feature_valid = false;
     valueSumNew.large_value_feature_valid = false;
+
+    // Record the placed stone
+    const int ply                   = versionPlyTable[currentVersion - 1];
+    versionPlyTable[currentVersion] = ply + 1;
+    stoneHistory[ply]               = {pieceColor, int8_t(x), int8_t(y)};
+}
+
+void Accumulator::move(const Weight &w, const StonePlacement *stones, int numStones)
+{
+    assert(numStones > 0);
+    if (numStones == 1) {
+        move(w, stones[0].color, stones[0].x, stones[0].y);
+        return;
+    }
+
+    // Copy version info to the next ply
+    const int       innerBoardSizeSqr       = boardSize * boardSize;
+    const int       outerBoardSizeSqr       = outerBoardSize * outerBoardSize;
+    const int       innerVersionIdxBasePrev = currentVersion * innerBoardSizeSqr;
+    const int       outerVersionIdxBasePrev = currentVersion * outerBoardSizeSqr;
+    const int       innerVersionIdxBase     = innerVersionIdxBasePrev + innerBoardSizeSqr;
+    const int       outerVersionIdxBase     = outerVersionIdxBasePrev + outerBoardSizeSqr;
+    const ChangeNum changeNum               = versionChangeNumTable[currentVersion];
+    std::copy_n(versionInnerIndexTable + innerVersionIdxBasePrev,
+                innerBoardSizeSqr,
+                versionInnerIndexTable + innerVersionIdxBase);
+    std::copy_n(versionOuterIndexTable + outerVersionIdxBasePrev,
+                outerBoardSizeSqr,
+                versionOuterIndexTable + outerVersionIdxBase);
+
+    typedef Batch<FeatureDim, int16_t>    FeatB;
+    typedef Batch<FeatDWConvDim, int16_t> ConvB;
+    typedef Batch<FeatureDim, int32_t>    VSumB;
+
+    struct CellChange
+    {
+        int8_t  x;
+        int8_t  y;
+        int16_t oldMapIdx;
+        int16_t newMapIdx;
+    } changeTable[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+    int changeCount = 0;
+
+    // Update shape table of all stones, each affected cell gets only one new map slot
+    const int boardSizeSub1 = boardSize - 1;
+    int       newMapIdx     = changeNum.inner;
+    for (int s = 0; s < numStones; s++) {
+        const StonePlacement &stone = stones[s];
+        assert(stone.color == BLACK || stone.color == WHITE);
+        int dPower3 = stone.color + 1;
+
+        for (int dir = 0; dir < 4; dir++) {
+            for (int dist = -5; dist <= 5; dist++) {
+                int xi = stone.x + dist * DX[dir];
+                int yi = stone.y + dist * DY[dir];
+
+                // branchless test: xi < 0 || xi >= boardSize || yi < 0 || yi >= boardSize
+                if ((xi | (boardSizeSub1 - xi) | yi | (boardSizeSub1 - yi)) < 0)
+                    continue;
+
+                // Map slots below changeNum.inner belong to previous versions
+                int innerIdx = boardSize * yi + xi;
+                int mapIdx   = versionInnerIndexTable[innerVersionIdxBase + innerIdx];
+                if (mapIdx < changeNum.inner) {
+                    CellChange &c         = changeTable[changeCount++];
+                    c.x                   = xi;
+                    c.y                   = yi;
+                    c.oldMapIdx           = mapIdx;
+                    c.newMapIdx           = newMapIdx;
+                    indexTable[newMapIdx] = indexTable[mapIdx];
+                    mapIdx                = newMapIdx++;
+                    versionInnerIndexTable[innerVersionIdxBase + innerIdx] = mapIdx;
+                }
+                indexTable[mapIdx][dir] += dPower3 * Power3[dist + 5];
+                assert(indexTable[mapIdx][dir] < ShapeNum);
+            }
+        }
+    }
+
+    // Init value sum accumulator
+    I32Op::R vSumGlobal[VSumB::NumBatch];
+    I32Op::R vSumGroup[ValueSumType::NGroup][ValueSumType::NGroup][VSumB::NumBatch];
+    for (int b = 0; b < VSumB::NumBatch; b++)
+        vSumGlobal[b] = I32Op::setzero();
+    for (int i = 0; i < ValueSumType::NGroup; i++)
+        for (int j = 0; j < ValueSumType::NGroup; j++)
+            for (int b = 0; b < VSumB::NumBatch; b++)
+                vSumGroup[i][j][b] = I32Op::setzero();
+
+    // Outer cells whose mapConv got a new slot, in the order of slot allocation
+    uint16_t changedOuterIdx[(MAX_BOARD_SIZE + 2) * (MAX_BOARD_SIZE + 2)];
+    int      newMapConvIdx = changeNum.outer;
+
+    // Incremental update feature sum of each changed cell once
+    for (int i = 0; i < changeCount; i++) {
+        const CellChange &c = changeTable[i];
+
+        // Update mapSum with the shape delta of all changed directions
+        I16Op::R oldFeats[FeatB::NumBatch];
+        I16Op::R newFeats[FeatB::NumBatch];
+        for (int b = 0; b < FeatB::NumBatch; b++) {
+            oldFeats[b] = I16LS::load(mapSum[c.oldMapIdx].data() + b * FeatB::RegWidth);
+            newFeats[b] = oldFeats[b];
+        }
+        for (int dir = 0; dir < 4; dir++) {
+            uint32_t oldShape = indexTable[c.oldMapIdx][dir];
+            uint32_t newShape = indexTable[c.newMapIdx][dir];
+            if (oldShape == newShape)
+                continue;
+
+            for (int b = 0; b < FeatB::NumBatch; b++) {
+                auto newMapFeat = I16LS::load(w.mapping[dir / 2][newShape] + b * FeatB::RegWidth);
+                auto oldMapFeat = I16LS::load(w.mapping[dir / 2][oldShape] + b * FeatB::RegWidth);
+                newFeats[b]     = I16Op::sub(newFeats[b], oldMapFeat);
+                newFeats[b]     = I16Op::add(newFeats[b], newMapFeat);
+            }
+        }
+        for (int b = 0; b < FeatB::NumBatch; b++) {
+            I16LS::store(mapSum[c.newMapIdx].data() + b * FeatB::RegWidth, newFeats[b]);
+            oldFeats[b] = I16Op::max(oldFeats[b], I16Op::setzero());
+            newFeats[b] = I16Op::max(newFeats[b], I16Op::setzero());
+        }
+
+        // Accumulate mapConv delta of the inner outer cells
+        for (int b = 0; b < ConvB::NumBatch; b++) {
+            oldFeats[b] = I16Op::slli<2>(oldFeats[b]);  // mul 4
+            newFeats[b] = I16Op::slli<2>(newFeats[b]);  // mul 4
+        }
+        for (int dy = 0, outerIdxBase = c.y * outerBoardSize + c.x; dy <= 2;
+             dy++, outerIdxBase += outerBoardSize) {
+            int yo = c.y + dy;
+            if (yo == 0 || yo > boardSize)
+                continue;  // mapConv of the outer border is never read
+
+            for (int dx = 0; dx <= 2; dx++) {
+                int xo = c.x + dx;
+                if (xo == 0 || xo > boardSize)
+                    continue;
+
+                int outerIdx   = dx + outerIdxBase;
+                int mapConvIdx = versionOuterIndexTable[outerVersionIdxBase + outerIdx];
+                if (mapConvIdx < changeNum.outer) {
+                    changedOuterIdx[newMapConvIdx - changeNum.outer] = outerIdx;
+                    mapConvIdx                                       = newMapConvIdx++;
+                    versionOuterIndexTable[outerVersionIdxBase + outerIdx] = mapConvIdx;
+                    for (int b = 0; b < ConvB::NumBatch; b++)
+                        I16LS::store(mapConv[mapConvIdx].data() + b * ConvB::RegWidth,
+                                     I16Op::setzero());
+                }
+
+                auto *convWeightBase = w.feature_dwconv_weight[8 - dy * 3 - dx];
+                auto *convBase       = mapConv[mapConvIdx].data();
+                for (int b = 0; b < ConvB::NumBatch; b++) {
+                    auto convW      = I16LS::load(convWeightBase + b * ConvB::RegWidth);
+                    auto deltaConvF = I16Op::sub(I16Op::mulhi(convW, newFeats[b]),
+                                                 I16Op::mulhi(convW, oldFeats[b]));
+                    auto convPtr    = convBase + b * ConvB::RegWidth;
+                    I16LS::store(convPtr, I16Op::add(I16LS::load(convPtr), deltaConvF));
+                }
+            }
+        }
+
+        // Update valueSum
+        for (int b = ConvB::NumBatch; b < FeatB::NumBatch; b++) {
+            auto deltaF             = I16Op::sub(newFeats[b], oldFeats[b]);
+            auto [deltaF0, deltaF1] = Convert<int16_t, int32_t>::convert(deltaF);
+
+            const int offset       = 2 * b;
+            vSumGlobal[offset + 0] = I32Op::add(vSumGlobal[offset + 0], deltaF0);
+            vSumGlobal[offset + 1] = I32Op::add(vSumGlobal[offset + 1], deltaF1);
+            auto &vGroup           = vSumGroup[groupIndex[c.y]][groupIndex[c.x]];
+            vGroup[offset + 0]     = I32Op::add(vGroup[offset + 0], deltaF0);
+            vGroup[offset + 1]     = I32Op::add(vGroup[offset + 1], deltaF1);
+        }
+    }
+
+    // Add value feature sum of all changed mapConv
+    for (int mapConvIdx = changeNum.outer; mapConvIdx < newMapConvIdx; mapConvIdx++) {
+        int outerIdx      = changedOuterIdx[mapConvIdx - changeNum.outer];
+        int i             = groupIndex[outerIdx / outerBoardSize - 1];
+        int j             = groupIndex[outerIdx % outerBoardSize - 1];
+        int oldMapConvIdx = versionOuterIndexTable[outerVersionIdxBasePrev + outerIdx];
+        for (int b = 0; b < ConvB::NumBatch; b++) {
+            auto oldConvF   = I16LS::load(mapConv[oldMapConvIdx].data() + b * ConvB::RegWidth);
+            auto deltaConvF = I16LS::load(mapConv[mapConvIdx].data() + b * ConvB::RegWidth);
+            auto newConvF   = I16Op::add(oldConvF, deltaConvF);
+            I16LS::store(mapConv[mapConvIdx].data() + b * ConvB::RegWidth, newConvF);
+            oldConvF      = I16Op::max(oldConvF, I16Op::setzero());  // relu
+            newConvF      = I16Op::max(newConvF, I16Op::setzero());  // relu
+            auto deltaF   = I16Op::sub(newConvF, oldConvF);
+            auto [v0, v1] = Convert<int16_t, int32_t>::convert(deltaF);
+
+            const int offset            = 2 * b;
+            vSumGlobal[offset + 0]      = I32Op::add(vSumGlobal[offset + 0], v0);
+            vSumGlobal[offset + 1]      = I32Op::add(vSumGlobal[offset + 1], v1);
+            vSumGroup[i][j][offset + 0] = I32Op::add(vSumGroup[i][j][offset + 0], v0);
+            vSumGroup[i][j][offset + 1] = I32Op::add(vSumGroup[i][j][offset + 1], v1);
+        }
+    }
+
+    // Move to next version
+    currentVersion++;
+    versionChangeNumTable[currentVersion] = {uint16_t(newMapIdx), uint16_t(newMapConvIdx)};
+
+    // Store value sum
+    auto &valueSumOld = valueSumTable[currentVersion - 1];
+    auto &valueSumNew = valueSumTable[currentVersion];
+    for (int b = 0; b < VSumB::NumBatch; b++) {
+        auto vOld = I32LS::load(valueSumOld.global.data() + b * VSumB::RegWidth);
+        auto vNew = I32Op::add(vOld, vSumGlobal[b]);
+        I32LS::store(valueSumNew.global.data() + b * VSumB::RegWidth, vNew);
+    }
+    for (int i = 0; i < ValueSumType::NGroup; i++)
+        for (int j = 0; j < ValueSumType::NGroup; j++)
+            for (int b = 0; b < VSumB::NumBatch; b++) {
+                auto vOld = I32LS::load(valueSumOld.group[i][j].data() + b * VSumB::RegWidth);
+                auto vNew = I32Op::add(vOld, vSumGroup[i][j][b]);
+                I32LS::store(valueSumNew.group[i][j].data() + b * VSumB::RegWidth, vNew);
+            }
+    valueSumNew.small_value_feature_valid = false;
+    valueSumNew.large_value_feature_valid = false;
+
+    // Record the placed stones, which are already in place when re-applied by undo()
+    const int ply = versionPlyTable[currentVersion - 1];
+    if (stones != stoneHistory + ply)
+        std::copy_n(stones, numStones, stoneHistory + ply);
+    versionPlyTable[currentVersion] = ply + numStones;
+}
+
+void Accumulator::undo(const Weight &w, int numStones)
+{
+    assert(0 < numStones && numStones <= versionPlyTable[currentVersion]);
+    const int targetPly = versionPlyTable[currentVersion] - numStones;
+    while (versionPlyTable[currentVersion] > targetPly)
+        currentVersion--;
+
+    // Apply the remaining stones again if a fused version was partially undone
+    const int ply = versionPlyTable[currentVersion];
+    if (targetPly > ply)
+        move(w, stoneHistory + ply, targetPly - ply);
 }
 
 void Accumulator::updateSharedSmallHead(const Weight &w)
@@ -982,7 +1245,9 @@ Evaluator::Evaluator(int                   boardSize,
     }
 
     if (printLoadInfo)
-        MESSAGEL("mix10 nnue: weight loaded in " << timeText(now() - startTime));
+        MESSAGEL("mix10 nnue: weight loaded in "
+                 << timeText(now() - startTime) << " with "
+                 << MemAlloc::largePageTypeName(MemAlloc::largePageType(weight[BLACK])) << ".");
 
     accumulator[BLACK] = std::make_unique<Accumulator>(boardSize);
     accumulator[WHITE] = std::make_unique<Accumulator>(boardSize);
@@ -1042,6 +1307,19 @@ void Evaluator::clearCache(Color side)
 {
     constexpr Color opponentMap[4] = {WHITE, BLACK, WALL, EMPTY};
 
+    // Consecutive moves and undos are gathered and applied as one fused update
+    Accumulator::StonePlacement stones[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+    int                         numStones = 0;
+    int                         numUndos  = 0;
+
+    auto flush = [&]() {
+        if (numUndos)
+            accumulator[side]->undo(*weight[side], numUndos);
+        if (numStones)
+            accumulator[side]->move(*weight[side], stones, numStones);
+        numStones = numUndos = 0;
+    };
+
     for (MoveCache &mc : moveCache[side]) {
         if (side == WHITE) {
             mc.oldColor = opponentMap[mc.oldColor];
@@ -1049,10 +1327,14 @@ void Evaluator::clearCache(Color side)
         }
 
         if (mc.oldColor == EMPTY)
-            accumulator[side]->move(*weight[side], mc.newColor, mc.x, mc.y);
-        else
-            accumulator[side]->undo();
+            stones[numStones++] = {mc.newColor, mc.x, mc.y};
+        else {
+            if (numStones)
+                flush();
+            numUndos++;
+        }
     }
+    flush();
     moveCache[side].clear();
 }
 
@@ -133,6 +133,13 @@ public:
     static_assert(offsetof(ValueSumType, small_value_feature) % 64 == 0);
     static_assert(offsetof(ValueSumType, large_value_feature) % 64 == 0);
 
+    /// A stone placed on the board, used by the fused multi-stone update.
+    struct StonePlacement
+    {
+        Color  color;
+        int8_t x, y;
+    };
+
     Accumulator(int boardSize);
     ~Accumulator();
 
@@ -140,7 +147,12 @@ public:
     void clear(const Weight &w);
     /// Incremental update mix6 network state.
     void move(const Weight &w, Color pieceColor, int x, int y);
-    void undo() { currentVersion--; }
+    /// Incremental update network state with several stones at once. Line shapes of the
+    /// union of affected cells are updated once, and all stones share one new version.
+    void move(const Weight &w, const StonePlacement *stones, int numStones);
+    /// Rollback the last placed stones. If a fused version is only partially undone,
+    /// the remaining stones of that version are applied again as one fused update.
+    void undo(const Weight &w, int numStones = 1);
 
     void updateSharedSmallHead(const Weight &w);
     void updateSharedLargeHead(const Weight &w);
@@ -164,10 +176,12 @@ private:
     // Network states
 
     /// Value feature sum of the full board
-    ValueSumType *valueSumTable;          // [H*W+1, FeatureDim] (aligned)
-    ChangeNum    *versionChangeNumTable;  // [H*W+1] (unaligned) num inner changes and outer changes
-    uint16_t     *versionInnerIndexTable;  // [H*W+1, H*W] (unaligned)
-    uint16_t     *versionOuterIndexTable;  // [H*W+1, (H+2)*(W+2)] (unaligned)
+    ValueSumType   *valueSumTable;          // [H*W+1, FeatureDim] (aligned)
+    ChangeNum      *versionChangeNumTable;  // [H*W+1] num inner changes and outer changes
+    uint16_t       *versionInnerIndexTable;  // [H*W+1, H*W] (unaligned)
+    uint16_t       *versionOuterIndexTable;  // [H*W+1, (H+2)*(W+2)] (unaligned)
+    uint16_t       *versionPlyTable;         // [H*W+1] num stones placed at each version
+    StonePlacement *stoneHistory;            // [H*W] stones in placement order
     /// Index table to convert line shape to map feature
     std::array<uint32_t, 4> *indexTable;  // [N_inner, 4] (unaligned)
     /// Sumed map feature of four directions
@@ -181,8 +195,9 @@ private:
     int    currentVersion;
     int8_t groupIndex[32];
 
-    void initIndexTable();
-    int  getBucketIndex() { return 0; }
+    void   initIndexTable();
+    int    getBucketIndex() { return 0; }
+    size_t memoryUsage() const;
 };
 
 class Evaluator : public Evaluation::Evaluator
@@ -92,6 +92,12 @@ enum OnnxModelIOVersion : uint16_t {
     VERSION_END,
 };
 
+/// Whether the onnx device runs inference on host cpus.
+bool isCpuDevice(OnnxDevice device)
+{
+    return device == CPU_ST || device == CPU_MT;
+}
+
 /// Get the default device of this machine.
 OnnxDevice getDefaultDevice()
 {
@@ -101,9 +107,15 @@ OnnxDevice getDefaultDevice()
 /// Arguments for creating a onnx model instance.
 struct OnnxModelArguments
 {
-    OnnxDevice device;
+    OnnxDevice       device;
+    Numa::NumaNodeId numaNodeId;
+    bool             pinNumaNode;  // Pin the cpu thread pool to the cpus of the numa node
 
-    bool operator==(const OnnxModelArguments &other) const { return device == other.device; }
+    bool operator==(const OnnxModelArguments &other) const
+    {
+        return device == other.device && numaNodeId == other.numaNodeId
+               && pinNumaNode == other.pinNumaNode;
+    }
 };
 
 /// Warpper interface for an onnx session instance.
@@ -112,7 +124,7 @@ class OnnxModel
 public:
     OnnxModel(std::istream &istream, OnnxModelArguments args)
     {
-        setupSessionOptions(args.device);
+        setupSessionOptions(args.device, args.numaNodeId, args.pinNumaNode);
 
         // Read model data from stream to memory
         std::vector<char> modelData {
@@ -131,6 +143,13 @@ public:
         modelRuleMask            = (modelVersionMask >> 32) & 0xFFFF;
         modelBoardSizeMask       = modelVersionMask & 0xFFFFFFFF;
 
+        // Quantized models are marked with a "quantization" metadata (eg. "int8"),
+        // which is empty for float models. Static quantized (QDQ) models need no extra
+        // session option, as the QDQ nodes are fused into integer kernels on cpu.
+        auto quantMeta = metainfo.LookupCustomMetadataMapAllocated("quantization", allocator);
+        if (quantMeta)
+            quantization = quantMeta.get();
+
         if (modelVersion >= VERSION_START && modelVersion < VERSION_END)
             modelIOVersion = static_cast<OnnxModelIOVersion>(modelVersion);
         else
@@ -157,6 +176,8 @@ public:
 
     OnnxModelIOVersion getIOVersion() const { return modelIOVersion; }
 
+    const std::string &getQuantization() const { return quantization; }
+
     std::vector<std::string> getInputNames() const
     {
         std::vector<std::string> inputNames;
@@ -194,7 +215,7 @@ public:
     }
 
 private:
-    void setupSessionOptions(OnnxDevice device)
+    void setupSessionOptions(OnnxDevice device, Numa::NumaNodeId numaNodeId, bool pinNumaNode)
     {
         if (device == CPU_ST) {
             sessionOptions.SetIntraOpNumThreads(1);
@@ -202,7 +223,28 @@ private:
             return;
         }
         else if (device == CPU_MT) {
-            sessionOptions.SetIntraOpNumThreads(0);
+            std::vector<int> nodeCpus;
+            if (pinNumaNode)
+                nodeCpus = Numa::getNodeCpus(numaNodeId);
+            if (nodeCpus.size() > 1) {
+                // Size the intra-op pool to the cpus of this numa node and pin every
+                // pool thread to that cpu set. The calling search thread also takes
+                // part in the computation, so only (numThreads - 1) affinities are
+                // given. Onnx runtime expects 1-based logical processor ids.
+                std::string cpuList;
+                for (int cpu : nodeCpus)
+                    cpuList += (cpuList.empty() ? "" : ",") + std::to_string(cpu + 1);
+
+                std::string affinities;
+                for (size_t i = 1; i < nodeCpus.size(); i++)
+                    affinities += (affinities.empty() ? "" : ";") + cpuList;
+
+                sessionOptions.SetIntraOpNumThreads(static_cast<int>(nodeCpus.size()));
+                sessionOptions.AddConfigEntry("session.intra_op_thread_affinities",
+                                              affinities.c_str());
+            }
+            else
+                sessionOptions.SetIntraOpNumThreads(0);
             sessionOptions.SetInterOpNumThreads(0);
             sessionOptions.AddConfigEntry("session.intra_op.allow_spinning", "0");
             sessionOptions.AddConfigEntry("session.inter_op.allow_spinning", "0");
@@ -272,6 +314,7 @@ private:
     int32_t                          modelBoardSizeMask;
     int16_t                          modelRuleMask;
     OnnxModelIOVersion               modelIOVersion;
+    std::string                      quantization;
 };
 
 class OnnxRapfiModelV1 : public OnnxAccumulator
@@ -451,8 +494,16 @@ struct OnnxModelLoader : WeightLoader<OnnxModel, OnnxModelArguments>
             if (!ptr->supportBoardSize(boardSize))
                 return nullptr;
 
+            if (!ptr->getQuantization().empty() && !isCpuDevice(args.device))
+                MESSAGEL("Warning: " << ptr->getQuantization()
+                                     << " quantized onnx model is intended for cpu devices");
+
             MESSAGEL("Initialized onnx model " << pathToConsoleString(onnxModelPath)
-                                               << " on device: " << deviceString(args.device));
+                                               << (ptr->getQuantization().empty()
+                                                       ? ""
+                                                       : " (" + ptr->getQuantization() + ")")
+                                               << " on device: " << deviceString(args.device)
+                                               << " (numa node " << args.numaNodeId << ")");
             return ptr;
         }
         catch (const std::exception &e) {
@@ -490,6 +541,8 @@ namespace Evaluation::onnx {
 
 OnnxEvaluator::OnnxEvaluator(int                   boardSize,
                              Rule                  rule,
+                             Numa::NumaNodeId      numaNodeId,
+                             bool                  numaBound,
                              std::filesystem::path onnxModelPath,
                              std::string           device)
     : Evaluator(boardSize, rule)
@@ -502,10 +555,15 @@ OnnxEvaluator::OnnxEvaluator(int                   boardSize,
     args.device = parseDeviceString(device);
     if (args.device == DEFAULT_DEV)
         args.device = getDefaultDevice();
+    // When search threads are bound to numa nodes, cpu sessions are created once per node,
+    // so that each search thread runs inference in a session whose thread pool and arena
+    // are local to its node. Otherwise all threads share one session with the default
+    // unpinned pool. Sessions on gpu devices are always shared by all search threads.
+    args.pinNumaNode = isCpuDevice(args.device) && numaBound;
+    args.numaNodeId  = args.pinNumaNode ? numaNodeId : Numa::DefaultNumaNodeId;
 
     OnnxModelLoader loader {boardSize, rule, onnxModelPath};
-    model =
-        OnnxModelRegistry.loadWeightFromFile(loader, onnxModelPath, Numa::DefaultNumaNodeId, args);
+    model = OnnxModelRegistry.loadWeightFromFile(loader, onnxModelPath, args.numaNodeId, args);
     if (!model)
         throw std::runtime_error("Failed to load onnx model from "
                                  + pathToConsoleString(onnxModelPath));
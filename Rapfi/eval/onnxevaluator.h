@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "../core/platform.h"
 #include "evaluator.h"
 
 #include <filesystem>
@@ -51,8 +52,13 @@ public:
 class OnnxEvaluator : public Evaluator
 {
 public:
+    /// @param numaNodeId Numa node of the search thread that owns this evaluator.
+    /// @param numaBound Whether search threads are bound to numa nodes. Only then the cpu
+    ///     session pool is sized and pinned to the cpus of the node.
     OnnxEvaluator(int                   boardSize,
                   Rule                  rule,
+                  Numa::NumaNodeId      numaNodeId,
+                  bool                  numaBound,
                   std::filesystem::path onnxModelPath,
                   std::string           device);
     ~OnnxEvaluator();
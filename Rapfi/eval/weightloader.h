@@ -269,6 +269,7 @@ WeightRegistry<WeightLoader>::loadWeightFromFile(
     typename WeightRegistry<WeightLoader>::LoadArgs loadArgs)
 {
     std::lock_guard<std::mutex> lock(poolMutex);
+    MemAlloc::MemoryTagScope    memoryTag(MemAlloc::MemoryTag::WEIGHT);
 
     // Find weights in loaded weight weightPool
     for (auto &w : weightPool) {
@@ -19,6 +19,7 @@
 #include "board.h"
 
 #include "../core/iohelper.h"
+#include "../core/platform.h"
 #include "../core/pos.h"
 #include "../core/utils.h"
 #include "../eval/evaluator.h"
@@ -66,6 +67,7 @@ Board::Board(int boardSize, CandidateRange candRange)
     assert(0 < boardSize && boardSize <= MAX_BOARD_SIZE);
     stateInfos  = new StateInfo[1 + boardCellCount * 2] {};
     updateCache = new UpdateCache[1 + boardCellCount * 2];
+    MemAlloc::trackAlloc(MemAlloc::MemoryTag::BOARD, memoryUsage());
 
     // Set candidate range of the board
     switch (candRange) {
@@ -120,6 +122,7 @@ Board::Board(const Board &other, Search::SearchThread *thread)
 
     stateInfos  = new StateInfo[1 + boardCellCount * 2] {};
     updateCache = new UpdateCache[1 + boardCellCount * 2];
+    MemAlloc::trackAlloc(MemAlloc::MemoryTag::BOARD, memoryUsage());
     // Only copy stateinfo in [0, moveCount]
     std::copy_n(other.stateInfos, 1 + moveCount, stateInfos);
     std::copy_n(other.updateCache, 1 + moveCount, updateCache);
@@ -133,6 +136,13 @@ Board::~Board()
 {
     delete[] stateInfos;
     delete[] updateCache;
+    MemAlloc::trackFree(MemAlloc::MemoryTag::BOARD, memoryUsage());
+}
+
+/// Memory owned by this board, including its state info and update cache arrays.
+size_t Board::memoryUsage() const
+{
+    return sizeof(Board) + (1 + boardCellCount * 2) * (sizeof(StateInfo) + sizeof(UpdateCache));
 }
 
 template <Rule R>
@@ -215,7 +225,7 @@ void Board::move(Pos pos)
         currentSide = ~currentSide;
 
         // after move evaluator update
-        if (MT == MoveType::NORMAL && evaluator_)
+        if ((MT == MoveType::NORMAL || MT == MoveType::NO_CLASSICAL_EVAL) && evaluator_)
             evaluator_->afterPass(*this);
         return;
     }
@@ -224,7 +234,7 @@ void Board::move(Pos pos)
     assert(isEmpty(pos));
 
     // before move evaluator update
-    if (MT == MoveType::NORMAL && evaluator_)
+    if ((MT == MoveType::NORMAL || MT == MoveType::NO_CLASSICAL_EVAL) && evaluator_)
         evaluator_->beforeMove(*this, pos);
 
     UpdateCache &pc = updateCache[moveCount];
@@ -321,15 +331,18 @@ void Board::move(Pos pos)
     }
 
     // after move evaluator update
-    if (MT == MoveType::NORMAL && evaluator_)
+    if ((MT == MoveType::NORMAL || MT == MoveType::NO_CLASSICAL_EVAL) && evaluator_)
         evaluator_->afterMove(*this, pos);
 }
 
 template void Board::move<FREESTYLE, Board::MoveType::NORMAL>(Pos pos);
+template void Board::move<FREESTYLE, Board::MoveType::NO_CLASSICAL_EVAL>(Pos pos);
 template void Board::move<FREESTYLE, Board::MoveType::NO_EVAL>(Pos pos);
 template void Board::move<STANDARD, Board::MoveType::NORMAL>(Pos pos);
+template void Board::move<STANDARD, Board::MoveType::NO_CLASSICAL_EVAL>(Pos pos);
 template void Board::move<STANDARD, Board::MoveType::NO_EVAL>(Pos pos);
 template void Board::move<RENJU, Board::MoveType::NORMAL>(Pos pos);
+template void Board::move<RENJU, Board::MoveType::NO_CLASSICAL_EVAL>(Pos pos);
 template void Board::move<RENJU, Board::MoveType::NO_EVAL>(Pos pos);
 
 template <Rule R, Board::MoveType MT>
@@ -346,13 +359,13 @@ void Board::undo()
         moveCount--;
 
         // after undo evaluator update
-        if (MT == MoveType::NORMAL && evaluator_)
+        if ((MT == MoveType::NORMAL || MT == MoveType::NO_CLASSICAL_EVAL) && evaluator_)
             evaluator_->afterUndoPass(*this);
         return;
     }
 
     // before undo evaluator update
-    if (MT == MoveType::NORMAL && evaluator_)
+    if ((MT == MoveType::NORMAL || MT == MoveType::NO_CLASSICAL_EVAL) && evaluator_)
         evaluator_->beforeUndo(*this, lastPos);
 
     if (MT != MoveType::NO_EVAL_MULTI)
@@ -409,15 +422,18 @@ void Board::undo()
         cells[lastPos + candidateRange[i]].cand--;
 
     // after undo evaluator update
-    if (MT == MoveType::NORMAL && evaluator_)
+    if ((MT == MoveType::NORMAL || MT == MoveType::NO_CLASSICAL_EVAL) && evaluator_)
         evaluator_->afterUndo(*this, lastPos);
 }
 
 template void Board::undo<FREESTYLE, Board::MoveType::NORMAL>();
+template void Board::undo<FREESTYLE, Board::MoveType::NO_CLASSICAL_EVAL>();
 template void Board::undo<FREESTYLE, Board::MoveType::NO_EVAL>();
 template void Board::undo<STANDARD, Board::MoveType::NORMAL>();
+template void Board::undo<STANDARD, Board::MoveType::NO_CLASSICAL_EVAL>();
 template void Board::undo<STANDARD, Board::MoveType::NO_EVAL>();
 template void Board::undo<RENJU, Board::MoveType::NORMAL>();
+template void Board::undo<RENJU, Board::MoveType::NO_CLASSICAL_EVAL>();
 template void Board::undo<RENJU, Board::MoveType::NO_EVAL>();
 
 bool Board::checkForbiddenPoint(Pos pos) const
@@ -519,6 +535,37 @@ Pos Board::getLastActualMoveOfSide(Color side) const
     return Pos::NONE;
 }
 
+bool Board::syncTo(Rule rule, const Board &other, int maxMoves)
+{
+    if (boardSize != other.boardSize || candidateRange != other.candidateRange
+        || candidateRangeSize != other.candidateRangeSize)
+        return false;
+
+    int commonPly = 0;
+    int minPly    = std::min(moveCount, other.moveCount);
+    while (commonPly < minPly && getHistoryMove(commonPly) == other.getHistoryMove(commonPly))
+        commonPly++;
+    if (moveCount + other.moveCount - 2 * commonPly > maxMoves)
+        return false;
+
+    while (moveCount > commonPly)
+        undo(rule);
+    for (int i = commonPly; i < other.moveCount; i++)
+        move(rule, other.getHistoryMove(i));
+
+    // Candidates expanded by expandCandArea() are not reverted by undo(), so we check
+    // the candidate state to see if both boards really end in the same state.
+    const CandArea &area = stateInfo().candArea, &otherArea = other.stateInfo().candArea;
+    if (area.x0 != otherArea.x0 || area.y0 != otherArea.y0 || area.x1 != otherArea.x1
+        || area.y1 != otherArea.y1)
+        return false;
+    for (Pos pos = Pos::FULL_BOARD_START; pos < Pos::FULL_BOARD_END; pos++)
+        if (cells[pos].cand != other.cells[pos].cand)
+            return false;
+
+    return true;
+}
+
 void Board::expandCandArea(Pos pos, int fillDist, int lineDist)
 {
     CandArea &area = stateInfos[moveCount].candArea;
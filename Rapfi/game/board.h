@@ -152,7 +152,7 @@ class Board
 {
 public:
     /// MoveType represents the update mode of move/undo.
-    enum class MoveType { NORMAL, NO_EVALUATOR, NO_EVAL, NO_EVAL_MULTI };
+    enum class MoveType { NORMAL, NO_CLASSICAL_EVAL, NO_EVALUATOR, NO_EVAL, NO_EVAL_MULTI };
 
     /// Creates a board with board size and condidate range.
     /// @param boardSize Size of the board, in range [1, MAX_BOARD_SIZE].
@@ -175,11 +175,14 @@ public:
     /// Make move and incremental update the board state.
     /// @param pos Pos to put the next stone. A Pass move is allowed.
     /// @tparam R Game rule to use.
-    /// @tparam MT Type of this move. There are four types of move:
+    /// @tparam MT Type of this move. There are five types of move:
     ///     1. NORMAL: Updates cell, pattern, score, eval and external evaluator.
-    ///     2. NO_EVALUATOR: Updates cell, pattern, score, eval.
-    ///     3. NO_EVAL: Updates cell, pattern, score.
-    ///     4. NO_EVAL_MULTI: Updates cell, pattern, score. Side to move is not swapped.
+    ///     2. NO_CLASSICAL_EVAL: Updates cell, pattern, score and external evaluator.
+    ///        Classical eval is left stale, which is only safe when the evaluator
+    ///        fully replaces the classical eval for the whole line of moves.
+    ///     3. NO_EVALUATOR: Updates cell, pattern, score, eval.
+    ///     4. NO_EVAL: Updates cell, pattern, score.
+    ///     5. NO_EVAL_MULTI: Updates cell, pattern, score. Side to move is not swapped.
     /// @note Recursive pass move is allowed, but the total number of null moves
     ///     must be not greater than MAX_PASS_MOVES. As long as consecutive pass
     ///     moves are not allowed, this condition should be met.
@@ -195,10 +198,23 @@ public:
     /// A dynamic dispatch version of newGame().
     void newGame(Rule rule);
     /// A dynamic dispatch version of move().
+    template <MoveType MT = MoveType::NORMAL>
     void move(Rule rule, Pos pos);
     /// A dynamic dispatch version of undo().
+    template <MoveType MT = MoveType::NORMAL>
     void undo(Rule rule);
 
+    /// Bring this board to the position of another board by undoing moves back to their
+    /// common prefix and making the remaining moves. This is much cheaper than cloning
+    /// when the positions share most of their moves, as the evaluator is updated by the
+    /// differing moves only, instead of being synced by replaying all moves.
+    /// @param rule Game rule that the moves on both boards are made with.
+    /// @param other Board to sync to.
+    /// @param maxMoves Maximum number of moves to undo and make.
+    /// @return Whether this board reaches the same state as other. If not, this board
+    ///     may have been changed to a different state, and should be cloned instead.
+    bool syncTo(Rule rule, const Board &other, int maxMoves);
+
     // ------------------------------------------------------------------------
     // special helper function
 
@@ -362,8 +378,9 @@ private:
     Evaluation::Evaluator *evaluator_;          /// External evaluator pointer
     Search::SearchThread  *thisThread_;         /// External search thread pointer
 
-    void setBitKey(Pos pos, Color c);
-    void flipBitKey(Pos pos, Color c);
+    void   setBitKey(Pos pos, Color c);
+    void   flipBitKey(Pos pos, Color c);
+    size_t memoryUsage() const;
 };
 
 /// Set bitkey of 4 directions at pos to color.
@@ -427,17 +444,22 @@ inline void Board::newGame(Rule rule)
     (this->*F[rule])();
 }
 
+template <Board::MoveType MT>
 inline void Board::move(Rule rule, Pos pos)
 {
     assert(rule < RULE_NB);
-    void (Board::*F[])(
-        Pos) = {&Board::move<FREESTYLE>, &Board::move<STANDARD>, &Board::move<RENJU>};
+    void (Board::*F[])(Pos) = {&Board::move<FREESTYLE, MT>,
+                               &Board::move<STANDARD, MT>,
+                               &Board::move<RENJU, MT>};
     (this->*F[rule])(pos);
 }
 
+template <Board::MoveType MT>
 inline void Board::undo(Rule rule)
 {
     assert(rule < RULE_NB);
-    void (Board::*F[])() = {&Board::undo<FREESTYLE>, &Board::undo<STANDARD>, &Board::undo<RENJU>};
+    void (Board::*F[])() = {&Board::undo<FREESTYLE, MT>,
+                            &Board::undo<STANDARD, MT>,
+                            &Board::undo<RENJU, MT>};
     (this->*F[rule])();
 }
@@ -45,19 +45,32 @@ int main(int argc, char *argv[])
         SELFPLAY,
         DATAPREP,
         DATABASE,
+        SIMDBENCH,
+        ONNXQUANT,
+        ANALYZE,
+        MATCH,
+        TIMETUNE,
     } runMode = GOMOCUP_PROTOCOL;
+    bool   memoryReport     = false;
+    size_t placementThreads = 0;
 
     {
         cxxopts::Options options("rapfi");
         options.add_options()  //
             ("mode",
-             "One of [gomocup, bench, opengen, tuning, selfplay, dataprep, database] run modes",
+             "One of [gomocup, bench, opengen, tuning, selfplay, dataprep, database, simdbench, "
+             "onnxquant, analyze, match, timetune] run modes",
              cxxopts::value<std::string>()->default_value("gomocup"))  //
             ("config",
              "Path to the specified config file",
              cxxopts::value<std::string>())  //
             ("force-utf8",
              "Force to use utf-8 encoding for stdin and stdout (for Windows)")  //
+            ("memory-report",
+             "Print memory usage of each subsystem after the benchmark")  //
+            ("placement-threads",
+             "Number of threads to compare search speed of thread bind policies in the benchmark",
+             cxxopts::value<size_t>()->default_value("0"))  //
             ("h,help", "Print usage");
         options.parse_positional("mode");
         options.positional_help("[mode]");
@@ -83,6 +96,16 @@ int main(int argc, char *argv[])
                 runMode = DATAPREP;
             else if (mode == "DATABASE")
                 runMode = DATABASE;
+            else if (mode == "SIMDBENCH")
+                runMode = SIMDBENCH;
+            else if (mode == "ONNXQUANT")
+                runMode = ONNXQUANT;
+            else if (mode == "ANALYZE")
+                runMode = ANALYZE;
+            else if (mode == "MATCH")
+                runMode = MATCH;
+            else if (mode == "TIMETUNE")
+                runMode = TIMETUNE;
             else
                 throw std::invalid_argument("unknown mode " + mode);
 
@@ -91,6 +114,10 @@ int main(int argc, char *argv[])
                 std::exit(EXIT_SUCCESS);
             }
 
+            if (result.count("memory-report"))
+                memoryReport = true;
+            placementThreads = result["placement-threads"].as<size_t>();
+
             if (result.count("config")) {
                 Command::configPath          = result["config"].as<std::string>();
                 Command::allowInternalConfig = false;
@@ -117,12 +144,17 @@ int main(int argc, char *argv[])
 
 #ifdef COMMAND_MODULES
     switch (runMode) {
-    case BENCHMARK: Command::benchmark(); break;
+    case BENCHMARK: Command::benchmark(memoryReport, placementThreads); break;
     case OPENGEN: Command::opengen(argc, argv); break;
     case TUNING: Command::tuning(argc, argv); break;
     case SELFPLAY: Command::selfplay(argc, argv); break;
     case DATAPREP: Command::dataprep(argc, argv); break;
     case DATABASE: Command::database(argc, argv); break;
+    case SIMDBENCH: Command::simdbench(argc, argv); break;
+    case ONNXQUANT: Command::onnxquant(argc, argv); break;
+    case ANALYZE: Command::analyze(argc, argv); break;
+    case MATCH: Command::match(argc, argv); break;
+    case TIMETUNE: Command::timetune(argc, argv); break;
     default: Command::gomocupLoop(); break;
     }
 #else
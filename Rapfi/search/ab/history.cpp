@@ -58,19 +58,20 @@ void HistoryTracker::updateBestmoveStats(Depth depth, Pos bestMove, Value bestVa
     int      bonus  = statBonus(depth);
 
     if (selfP4 >= H_FLEX3) {
-        searchData->mainHistory[self][bestMove][HIST_ATTACK] << bonus;
+        (*searchData->mainHistory)[self][bestMove.moveIndex()][HIST_ATTACK] << bonus;
     }
     else if (!oppo4 && selfP4 < H_FLEX3) {
         updateQuietStats(bestMove, bonus);
 
         // Decrease stats for all the other played non-best quiet moves
         for (int i = 0; i < quietCount; i++)
-            searchData->mainHistory[self][quietsSearched[i]][HIST_QUIET] << -bonus;
+            (*searchData->mainHistory)[self][quietsSearched[i].moveIndex()][HIST_QUIET]
+                << -bonus;
     }
 
     // Decrease stats for all the other played non-best attack moves
     for (int i = 0; i < attackCount; i++)
-        searchData->mainHistory[self][attacksSearched[i]][HIST_ATTACK] << -bonus;
+        (*searchData->mainHistory)[self][attacksSearched[i].moveIndex()][HIST_ATTACK] << -bonus;
 
     // Update counter move history if last move is valid (not a pass)
     // Only update if last opponent move is not a four (otherwise we only have one possible reply)
@@ -98,7 +99,7 @@ void HistoryTracker::updateTTMoveStats(Depth depth, Pos ttMove, Value ttValue, V
             updateQuietStats(ttMove, bonus);
         // Penalty for a quiet ttMove that fails low
         else
-            searchData->mainHistory[self][ttMove][HIST_QUIET] << -bonus;
+            (*searchData->mainHistory)[self][ttMove.moveIndex()][HIST_QUIET] << -bonus;
     }
 }
 
@@ -106,7 +107,7 @@ void HistoryTracker::updateQuietStats(Pos move, int bonus)
 {
     Color self = board.sideToMove();
 
-    searchData->mainHistory[self][move][HIST_QUIET] << bonus;
+    (*searchData->mainHistory)[self][move.moveIndex()][HIST_QUIET] << bonus;
     searchStack->setKiller(move);  // Update killer heruistic move
 }
 
@@ -257,8 +257,9 @@ constexpr int policyPruningScore(Depth d)
 /// Compute stat score of current move from history table.
 inline int statScore(const MainHistory &mainHistory, Color stm, Pos move)
 {
-    return mainHistory[stm][move][HIST_ATTACK]                // history attack score
-           + mainHistory[stm][move][HIST_QUIET] * 780 / 1024  // history quiet score
+    const auto &hist = mainHistory[stm][move.moveIndex()];
+    return hist[HIST_ATTACK]                // history attack score
+           + hist[HIST_QUIET] * 780 / 1024  // history quiet score
            - 3322;
 }
 
@@ -76,12 +76,38 @@ void ABSearchData::clearData(SearchThread &th)
     pvIdx           = 0;
     rootDepth       = 0;
     completedDepth  = 0;
-    bestMoveChanges = 0;
-    singularRoot    = false;
-    mainHistory.init(0);
+    bestMoveChanges  = 0;
+    numBalance2Pairs = 0;
+    singularRoot     = false;
+    if (clearMainHistory)
+        mainHistory->init(0);
     counterMoveHistory.init(std::make_pair(Pos::NONE, NONE));
 }
 
+std::unique_ptr<SearchData> ABSearcher::makeSearchData(SearchThread &th)
+{
+    auto data = std::make_unique<ABSearchData>();
+
+    if (Config::SharedHistory) {
+        std::lock_guard<std::mutex> lock(sharedHistoryMutex);
+
+        std::weak_ptr<MainHistory> &sharedHistory = sharedHistories[th.numaNodeId()];
+        data->mainHistory                          = sharedHistory.lock();
+        // Only the thread that creates the shared table clears it before each search
+        data->clearMainHistory = !data->mainHistory;
+        if (!data->mainHistory) {
+            data->mainHistory = std::make_shared<MainHistory>();
+            sharedHistory     = data->mainHistory;
+        }
+    }
+    else {
+        data->mainHistory      = std::make_shared<MainHistory>();
+        data->clearMainHistory = true;
+    }
+
+    return data;
+}
+
 void ABSearcher::setMemoryLimit(size_t memorySizeKB)
 {
     TT.resize(memorySizeKB);
@@ -107,6 +133,7 @@ void ABSearcher::clear(ThreadPool &pool, bool clearAllMemory)
 void ABSearcher::searchMain(MainSearchThread &th)
 {
     SearchOptions &opts = th.options();
+    timectl.clearRecord();
 
     // Probe opening database and find if there is a prepared opening
     if (!opts.disableOpeningQuery
@@ -188,6 +215,40 @@ void ABSearcher::searchMain(MainSearchThread &th)
     // Starts worker threads, then starts main thread
     printer.printSearchStarts(th, timectl);
     th.runCustomTaskAndWait([this](SearchThread &t) { search(t); }, true);
+    timectl.recordSearchEnd();
+
+    // In balance2 mode, each thread group only searches the pairs of its own first moves,
+    // so bring the best pair found by the deepest thread of each group to the front.
+    if (opts.balanceMode == SearchOptions::BALANCE_TWO) {
+        const uint32_t              numGroups = th.balance2Moves.numGroups();
+        std::vector<SearchThread *> groupBestThreads(numGroups, nullptr);
+        uint64_t                    numPairs = 0;
+        for (const auto &t : th.threads) {
+            SearchThread *&groupBest = groupBestThreads[t->id % numGroups];
+            if (!groupBest
+                || t->searchDataAs<ABSearchData>()->completedDepth
+                       > groupBest->searchDataAs<ABSearchData>()->completedDepth)
+                groupBest = t.get();
+            numPairs += t->searchDataAs<ABSearchData>()->numBalance2Pairs;
+        }
+
+        const RootMove *bestMove  = &th.rootMoves[0];
+        int             bestDepth = th.searchDataAs<ABSearchData>()->completedDepth;
+        for (SearchThread *t : groupBestThreads)
+            if (t && BalanceMoveValueComparator {opts.balanceBias}(t->rootMoves[0], *bestMove)) {
+                bestMove  = &t->rootMoves[0];
+                bestDepth = t->searchDataAs<ABSearchData>()->completedDepth;
+            }
+        if (bestMove != &th.rootMoves[0]) {
+            Balance2Move b2move {bestMove->pv[0], bestMove->pv[1]};
+            auto         rm = std::find(th.rootMoves.begin(), th.rootMoves.end(), b2move);
+            assert(rm != th.rootMoves.end());
+            *rm = *bestMove;
+            std::rotate(th.rootMoves.begin(), rm, rm + 1);
+        }
+
+        printer.printBalance2Result(th, timectl, bestDepth, numPairs, numGroups);
+    }
 
     // Select best thread according to eval and completed depth when needed
     SearchThread *bestThread = &th;
@@ -248,6 +309,9 @@ void ABSearcher::search(SearchThread &th)
     int               firstMateDepth = 0, firstSingularDepth = 0;
     MainSearchThread *mainThread = (&th == th.threads.main() ? th.threads.main() : nullptr);
 
+    // Evaluator results are only worth caching when an evaluator is used
+    sd.nodeCache.init(th.evaluator ? th.board->size() : 0);
+
     if (options.vcnMode != SearchOptions::VCN_NONE && options.vcnN >= 2 && options.vcnN <= 6) {
         Color vcnAttacker = (options.vcnMode == SearchOptions::VCN_BLACK) ? BLACK : WHITE;
         int   passLimit   = 6 - options.vcnN;
@@ -295,9 +359,7 @@ void ABSearcher::search(SearchThread &th)
             th.rootMoves[0].value = vcnValue;
 
             if (vcnValue >= VALUE_MATE_IN_MAX_PLY) {
-                th.rootMoves[0].pv = std::vector<Pos>(ss->pv, ss->pv + MAX_PLY);
-                while (!th.rootMoves[0].pv.empty() && th.rootMoves[0].pv.back() == Pos::NONE)
-                    th.rootMoves[0].pv.pop_back();
+                th.rootMoves[0].pv = std::vector<Pos>(ss->pvBegin(), ss->pvEnd());
             }
             else {
                 th.rootMoves[0].pv = {Pos::NONE};
@@ -366,6 +428,17 @@ void ABSearcher::search(SearchThread &th)
             rm.previousPv    = rm.pv;
         }
 
+        // With collapsed symmetry moves, each PV line also reports its equivalent moves,
+        // so we only search enough lines (in last iteration's order) to cover multiPV.
+        if (options.collapseSymmetryMoves && !rmp.enabled()) {
+            size_t numCoveredMoves = 0;
+            for (sd.multiPv = 0; sd.multiPv < th.rootMoves.size(); sd.multiPv++) {
+                if (numCoveredMoves >= options.multiPV)
+                    break;
+                numCoveredMoves += 1 + th.rootMoves[sd.multiPv].symmetryMoves.size();
+            }
+        }
+
         // MultiPV loop. We perform a full root search for each PV line
         for (sd.pvIdx = 0; sd.pvIdx < sd.multiPv && !th.threads.isTerminating(); ++sd.pvIdx) {
             // Reset selDepth for each depth and each PV line
@@ -433,21 +506,23 @@ void ABSearcher::search(SearchThread &th)
             printer.printDepthCompletes(*mainThread, timectl, sd.completedDepth);
 
         // Check do we have time for the next iteration?
-        if (options.timeLimit && !th.threads.isTerminating()) {
+        if (!th.threads.isTerminating()) {
             // Accumulate all best move changes across threads
             for (const auto &th : th.threads) {
                 totalBestMoveChanges += sd.bestMoveChanges;
                 sd.bestMoveChanges = 0;
             }
 
+            TimeControl::IterParams iterParams {sd.rootDepth,
+                                                lastMoveChangeDepth,
+                                                bestValue,
+                                                previousBestValue,
+                                                previousTimeReduction,
+                                                totalBestMoveChanges / th.threads.size()};
+            timectl.recordIteration(iterParams, th.rootMoves[0].pv[0]);
+
             // Stop the search if exceeds time limit (do not stop in inPonder mode)
-            if (timectl.checkStop({sd.rootDepth,
-                                   lastMoveChangeDepth,
-                                   bestValue,
-                                   previousBestValue,
-                                   previousTimeReduction,
-                                   totalBestMoveChanges / th.threads.size()},
-                                  timeReduction)
+            if (options.timeLimit && timectl.checkStop(iterParams, timeReduction)
                 && !mainThread->inPonder) {
                 // Start pondering after foreground searching naturally ended
                 mainThread->markPonderingAvailable();
@@ -516,9 +591,15 @@ SearchThread *ABSearcher::pickBestThread(ThreadPool &threads) const
     for (size_t i = 1; i < threads.size(); i++)
         minValue = std::min(minValue, threads[i]->rootMoves[0].value);
 
-    // Vote moves according to value and depth
-    std::unordered_map<Pos, int64_t> votes;
-    constexpr int                    DepthBias = 15;
+    // Vote moves according to value and depth, with the map allocated from main thread arena
+    constexpr int DepthBias = 15;
+
+    using VoteMap = std::unordered_map<Pos,
+                                       int64_t,
+                                       std::hash<Pos>,
+                                       std::equal_to<Pos>,
+                                       ArenaAllocator<std::pair<const Pos, int64_t>>>;
+    VoteMap votes(threads.size(), std::hash<Pos> {}, std::equal_to<Pos> {}, threads.main()->arena);
     for (const auto &th : threads) {
         Pos   move  = th->rootMoves[0].pv[0];
         Value value = th->rootMoves[0].value;
@@ -550,6 +631,24 @@ SearchThread *ABSearcher::pickBestThread(ThreadPool &threads) const
 
 namespace {
 
+/// Evaluate the board, reusing the static value saved in the node cache of this thread.
+template <Rule R>
+Value cachedEvaluate(const Board &board, HashKey posKey, Value alpha, Value beta)
+{
+    // Classical evaluation is cheaper than a cache lookup
+    if (!board.evaluator())
+        return Evaluation::evaluate<R>(board, alpha, beta);
+
+    NodeCache &nodeCache = board.thisThread()->searchDataAs<ABSearchData>()->nodeCache;
+
+    Value eval;
+    if (!nodeCache.probeValue(posKey, eval)) {
+        eval = Evaluation::evaluate<R>(board, alpha, beta);
+        nodeCache.storeValue(posKey, eval);
+    }
+    return eval;
+}
+
 /// The aspiration window search loop. First start with a small aspiration window, in the case
 /// of a fail high/low, re-search with a bigger window until we don't fail high/low anymore.
 void aspirationSearch(Rule rule, Board &board, SearchStack *ss, Value prevValue, Depth depth)
@@ -666,18 +765,22 @@ Value search(Rule         rule,
                       board,
                       MovePicker::ExtraArgs<MovePicker::MAIN> {
                           thisThread->rootMoves[0].pv[0],
-                          &thisThread->searchDataAs<ABSearchData>()->mainHistory,
+                          thisThread->searchDataAs<ABSearchData>()->mainHistory.get(),
                           &thisThread->searchDataAs<ABSearchData>()->counterMoveHistory,
                       });
 
         // Refresh root move index in balance2Moves
         for (size_t i = 0; i < thisThread->rootMoves.size(); i++) {
             Balance2Move b2move {thisThread->rootMoves[i].pv[0], thisThread->rootMoves[i].pv[1]};
-            thisThread->balance2Moves[b2move] = i;
+            thisThread->balance2Moves.set(b2move, i);
         }
 
-        // Iterate first move in balance2 move pair
+        // Iterate first move in balance2 move pair, only in the partition of this thread
+        const uint32_t threadGroup = thisThread->id % thisThread->balance2Moves.numGroups();
         while (Pos move = mp()) {
+            if (thisThread->balance2Moves.groupOf(move) != threadGroup)
+                continue;
+
             board.move(rule, move);
             Value value = searchWithRule(rule);
             board.undo(rule);
@@ -792,7 +895,9 @@ Value search(Board &board, SearchStack *ss, Value alpha, Value beta, Depth depth
     Bound   ttBound  = BOUND_NONE;
     Pos     ttMove   = Pos::NONE;
     int     ttDepth  = 0;
-    bool    ttHit    = TT.probe(posKey, ttValue, ttEval, ttIsPv, ttBound, ttMove, ttDepth, ss->ply);
+    bool    ttLocal  = depth < Config::TTNodeLocalDepth;  // Probe node-local TT partition
+    bool    ttHit =
+        TT.probe(posKey, ttValue, ttEval, ttIsPv, ttBound, ttMove, ttDepth, ss->ply, ttLocal);
     if (RootNode && searchData->completedDepth.load(std::memory_order_relaxed))
         ttMove = thisThread->rootMoves[0].pv[options.balanceMode == SearchOptions::BALANCE_TWO];
     if (!skipMove)
@@ -873,7 +978,8 @@ Value search(Board &board, SearchStack *ss, Value alpha, Value beta, Depth depth
                              dbLabelBound == BOUND_EXACT
                                  ? (int)DEPTH_UPPER_BOUND
                                  : std::min(dbDepth, (int)DEPTH_UPPER_BOUND),
-                             ss->ply);
+                             ss->ply,
+                             ttLocal);
                     return dbValue;
                 }
 
@@ -882,6 +988,17 @@ Value search(Board &board, SearchStack *ss, Value alpha, Value beta, Depth depth
                     alpha = -VALUE_INFINITE, beta = VALUE_INFINITE;
             }
         }
+
+        // Prefetch the positions we are likely to query next in the background, which are
+        // the previous PV at root and the ttMove child at other nodes in the query plies.
+        if (Config::DatabasePrefetch && !skipMove && ss->ply < queryPly) {
+            if (RootNode) {
+                const auto &pv = thisThread->rootMoves[searchData->pvIdx].pv;
+                dbClient.prefetch(board, Rule, pv.data(), std::min<size_t>(pv.size(), queryPly));
+            }
+            else if (ttMove)
+                dbClient.prefetch(board, Rule, &ttMove, 1);
+        }
     }
 
     // Step 6. Static evaluation
@@ -905,14 +1022,14 @@ Value search(Board &board, SearchStack *ss, Value alpha, Value beta, Depth depth
             // Never assume anything about values stored in TT
             ss->staticEval = eval = ttEval;
             if (eval == VALUE_NONE)
-                ss->staticEval = eval = Evaluation::evaluate<Rule>(board, alpha, beta);
+                ss->staticEval = eval = cachedEvaluate<Rule>(board, posKey, alpha, beta);
 
             // Try to use ttValue as a better eval estimation
             if (ttValue != VALUE_NONE && (ttBound & (ttValue > eval ? BOUND_LOWER : BOUND_UPPER)))
                 eval = ttValue;
         }
         else {
-            ss->staticEval = eval = Evaluation::evaluate<Rule>(board, alpha, beta);
+            ss->staticEval = eval = cachedEvaluate<Rule>(board, posKey, alpha, beta);
 
             // Save static evaluation into transposition table
             if (!skipMove)
@@ -923,7 +1040,8 @@ Value search(Board &board, SearchStack *ss, Value alpha, Value beta, Depth depth
                          BOUND_NONE,
                          Pos::NONE,
                          (int)DEPTH_NONE,
-                         ss->ply);
+                         ss->ply,
+                         ttLocal);
         }
 
         improvement = ss->staticEval - (ss - 2)->staticEval;
@@ -952,7 +1070,7 @@ Value search(Board &board, SearchStack *ss, Value alpha, Value beta, Depth depth
 
         (ss + 1)->numNullMoves++;
         board.move<Rule>(Pos::PASS);
-        TT.prefetch(board.zobristKey());
+        TT.prefetch(board.zobristKey(), depth - r < Config::TTNodeLocalDepth);
         value = -search<Rule, NonPV>(board, ss + 1, -beta, -beta + 1, depth - r, !cutNode);
         board.undo<Rule>();
         (ss + 1)->numNullMoves--;
@@ -997,7 +1115,15 @@ Value search(Board &board, SearchStack *ss, Value alpha, Value beta, Depth depth
         bool  tmpIsPv;
         Bound tmpBound;
         int   tmpDepth;
-        ttHit = TT.probe(posKey, ttValue, tmpEval, tmpIsPv, tmpBound, ttMove, tmpDepth, ss->ply);
+        ttHit = TT.probe(posKey,
+                         ttValue,
+                         tmpEval,
+                         tmpIsPv,
+                         tmpBound,
+                         ttMove,
+                         tmpDepth,
+                         ss->ply,
+                         ttLocal);
     }
 
     // When opponent is doing A_FIVE attack, search starts from here
@@ -1023,13 +1149,16 @@ moves_loop:
                   board,
                   MovePicker::ExtraArgs<MovePicker::MAIN> {
                       ttMove,
-                      &searchData->mainHistory,
+                      searchData->mainHistory.get(),
                       &searchData->counterMoveHistory,
+                      false,
+                      1.0f,
+                      &searchData->nodeCache,
                   });
 
     // Step 11. Loop through all legal moves until no moves remain
     // or a beta cutoff occurs.
-    while (Pos move = mp()) {
+    while (Pos move = mp.next<Rule>()) {
         assert(board.isLegal(move));
 
         // Skip excluded move when in Singular extension search
@@ -1038,16 +1167,10 @@ moves_loop:
 
         if (RootNode) {
             if (options.balanceMode == SearchOptions::BALANCE_TWO) {
-                Balance2Move b2move {board.getLastMove(), move};
-
-                // Skip balance move pair not listed in Root Move List
-                if (thisThread->balance2Moves.find(b2move) == thisThread->balance2Moves.end())
-                    continue;
-
-                // Skip moves not in root move list and PV moves that have been already searched
-                if (std::count(thisThread->rootMoves.begin(),
-                               thisThread->rootMoves.begin() + searchData->pvIdx,
-                               b2move))
+                // Skip balance move pair not listed in Root Move List, and PV move pairs
+                // that have been already searched (root moves before pvIdx)
+                uint32_t rootMoveIdx = thisThread->balance2Moves[{board.getLastMove(), move}];
+                if (rootMoveIdx == Balance2MoveIndex::None || rootMoveIdx < searchData->pvIdx)
                     continue;
 
                 // Restore previous movecount from stack
@@ -1189,7 +1312,7 @@ moves_loop:
 
         // Step 14. Make the move
         board.move<Rule>(move);
-        TT.prefetch(board.zobristKey());
+        TT.prefetch(board.zobristKey(), newDepth < Config::TTNodeLocalDepth);
 
         // Step 15. Late move reduction (LMR). Moves are searched with a reduced
         // depth and will be re-searched at full depth if fail high.
@@ -1239,7 +1362,7 @@ moves_loop:
             }
 
             // Update statScore of this node
-            ss->statScore = statScore(searchData->mainHistory, self, move);
+            ss->statScore = statScore(*searchData->mainHistory, self, move);
 
             // Decrease/increase reduction for moves with a good/bad history (~9 elo)
             r -= extensionFromStatScore(ss->statScore, depth);
@@ -1289,7 +1412,7 @@ moves_loop:
                 || (RootNode && options.balanceMode
                         ? balancedValue(value, options.balanceBias) > alpha
                         : value > alpha && (RootNode || value < beta)))) {
-            (ss + 1)->pv[0]        = Pos::NONE;
+            (ss + 1)->clearPv();
             (ss + 1)->dbValueDepth = INT16_MIN;  // Clear database value depth of next move
             value = -search<Rule, PV>(board, ss + 1, -beta, -alpha, newDepth, false);
         }
@@ -1330,9 +1453,10 @@ moves_loop:
             Value      moveValue = value;
             RootMove  &rm =
                 balance2
-                     ? thisThread->rootMoves
-                          [thisThread->balance2Moves[Balance2Move {board.getLastMove(), move}]]
+                     ? thisThread->rootMoves[thisThread->balance2Moves[{board.getLastMove(), move}]]
                      : *std::find(thisThread->rootMoves.begin(), thisThread->rootMoves.end(), move);
+            if (balance2)
+                searchData->numBalance2Pairs++;
 
             // If we are in balance move mode, map the original move value to its negetive
             // absolute value, which makes best move and PV selection based on how balanced
@@ -1349,9 +1473,7 @@ moves_loop:
                 rm.pv.resize(1 + balance2);
 
                 assert((ss + 1)->pv);
-
-                for (Pos *m = (ss + 1)->pv; *m != Pos::NONE; m++)
-                    rm.pv.push_back(*m);
+                rm.pv.insert(rm.pv.end(), (ss + 1)->pvBegin(), (ss + 1)->pvEnd());
 
                 assert(!balance2 || rm.pv.size() >= 2);
 
@@ -1556,7 +1678,15 @@ moves_loop:
     // Don't save partial result in singular extension, multi pv at root or balance mode.
     if (!skipMove
         && !(RootNode && (searchData->pvIdx || options.balanceMode || options.blockMoves.size())))
-        TT.store(posKey, bestValue, ss->staticEval, ss->ttPv, bound, bestMove, (int)depth, ss->ply);
+        TT.store(posKey,
+                 bestValue,
+                 ss->staticEval,
+                 ss->ttPv,
+                 bound,
+                 bestMove,
+                 (int)depth,
+                 ss->ply,
+                 ttLocal);
 
     assert(bestValue > -VALUE_INFINITE && bestValue < VALUE_INFINITE);
     return bestValue;
@@ -1701,7 +1831,7 @@ Value vcfsearch(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
                                                  depth,
                                                  {(ss - 2)->moveP4[self], (ss - 4)->moveP4[self]}});
 
-    while (Pos move = mp()) {
+    while (Pos move = mp.next<Rule>()) {
         assert(board.isLegal(move));
 
         ss->currentMove   = move;
@@ -1709,7 +1839,7 @@ Value vcfsearch(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
         ss->moveP4[BLACK] = board.cell(move).pattern4[BLACK];
         ss->moveP4[WHITE] = board.cell(move).pattern4[WHITE];
         if (PvNode)
-            (ss + 1)->pv[0] = Pos::NONE;
+            (ss + 1)->clearPv();
 
         // Step 8. Make and search the move
         board.move<Rule>(move);
@@ -1808,7 +1938,7 @@ Value vcfdefend(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
         ss->moveP4[BLACK] = board.cell(move).pattern4[BLACK];
         ss->moveP4[WHITE] = board.cell(move).pattern4[WHITE];
         if (PvNode)
-            (ss + 1)->pv[0] = Pos::NONE;
+            (ss + 1)->clearPv();
 
         board.move<Rule>(move);
         TT.prefetch(board.zobristKey());
@@ -1919,12 +2049,12 @@ Value vcnsearch(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
         return bestValue;
     }
 
-    MovePicker mp(Rule, board, MovePicker::ExtraArgs<MovePicker::MAIN> {ttMove, &searchData->mainHistory, &searchData->counterMoveHistory});
+    MovePicker mp(Rule, board, MovePicker::ExtraArgs<MovePicker::MAIN> {ttMove, searchData->mainHistory.get(), &searchData->counterMoveHistory});
 
     constexpr int VCN_TOP_K = 10;
     int           candidatesChecked = 0;
 
-    while (Pos move = mp()) {
+    while (Pos move = mp.next<Rule>()) {
         if (Rule == Rule::RENJU && self == BLACK && board.checkForbiddenPoint(move))
             continue;
 
@@ -1940,7 +2070,7 @@ Value vcnsearch(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
         candidatesChecked++;
 
         if (PvNode)
-            (ss + 1)->pv[0] = Pos::NONE;
+            (ss + 1)->clearPv();
 
         board.move<Rule>(move);
 
@@ -2068,7 +2198,7 @@ Value vcndefend(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
         ss->moveP4[WHITE] = NONE;
 
         if (PvNode)
-            (ss + 1)->pv[0] = Pos::NONE;
+            (ss + 1)->clearPv();
 
         (ss + 1)->vcnPassCount = ss->vcnPassCount + 1;
 
@@ -2110,7 +2240,7 @@ Value vcndefend(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
         ss->moveP4[WHITE] = board.cell(move).pattern4[WHITE];
 
         if (PvNode)
-            (ss + 1)->pv[0] = Pos::NONE;
+            (ss + 1)->clearPv();
 
         (ss + 1)->vcnPassCount = ss->vcnPassCount;
 
@@ -2138,9 +2268,9 @@ Value vcndefend(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
     }
     else if (oppo4) {
         ABSearchData *searchData = thisThread->searchDataAs<ABSearchData>();
-        MovePicker mp(Rule, board, MovePicker::ExtraArgs<MovePicker::MAIN> {Pos::NONE, &searchData->mainHistory, &searchData->counterMoveHistory});
+        MovePicker mp(Rule, board, MovePicker::ExtraArgs<MovePicker::MAIN> {Pos::NONE, searchData->mainHistory.get(), &searchData->counterMoveHistory});
 
-        while (Pos move = mp()) {
+        while (Pos move = mp.next<Rule>()) {
             if (Rule == Rule::RENJU && self == BLACK && board.checkForbiddenPoint(move))
                 continue;
 
@@ -2155,7 +2285,7 @@ Value vcndefend(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
             ss->moveP4[WHITE] = board.cell(move).pattern4[WHITE];
 
             if (PvNode)
-                (ss + 1)->pv[0] = Pos::NONE;
+                (ss + 1)->clearPv();
 
             (ss + 1)->vcnPassCount = ss->vcnPassCount;
 
@@ -2184,9 +2314,9 @@ Value vcndefend(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
     }
     else {
         ABSearchData *searchData = thisThread->searchDataAs<ABSearchData>();
-        MovePicker mp(Rule, board, MovePicker::ExtraArgs<MovePicker::MAIN> {Pos::NONE, &searchData->mainHistory, &searchData->counterMoveHistory});
+        MovePicker mp(Rule, board, MovePicker::ExtraArgs<MovePicker::MAIN> {Pos::NONE, searchData->mainHistory.get(), &searchData->counterMoveHistory});
 
-        while (Pos move = mp()) {
+        while (Pos move = mp.next<Rule>()) {
             if (Rule == Rule::RENJU && self == BLACK && board.checkForbiddenPoint(move))
                 continue;
 
@@ -2195,7 +2325,7 @@ Value vcndefend(Board &board, SearchStack *ss, Value alpha, Value beta, Depth de
             ss->moveP4[WHITE] = board.cell(move).pattern4[WHITE];
 
             if (PvNode)
-                (ss + 1)->pv[0] = Pos::NONE;
+                (ss + 1)->clearPv();
 
             (ss + 1)->vcnPassCount = ss->vcnPassCount;
 
@@ -20,6 +20,7 @@
 
 #include "../../core/pos.h"
 #include "../../core/types.h"
+#include "../nodecache.h"
 #include "../searcher.h"
 #include "../searchoutput.h"
 #include "../searchthread.h"
@@ -27,6 +28,9 @@
 #include "history.h"
 
 #include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 
 namespace Search::AB {
 
@@ -40,9 +44,12 @@ struct ABSearchData : SearchData
     bool             singularRoot;     /// Is there only a single response at root?
     std::atomic<int> completedDepth;   /// Previously completed depth
     std::atomic<int> bestMoveChanges;  /// How many time best move has changed in this search
+    uint64_t         numBalance2Pairs;  /// Number of balance2 move pairs searched at root
 
-    MainHistory        mainHistory;         /// Heuristic history table
-    CounterMoveHistory counterMoveHistory;  /// Counter move history table
+    std::shared_ptr<MainHistory> mainHistory;         /// Heuristic history table (maybe shared)
+    CounterMoveHistory           counterMoveHistory;  /// Counter move history table
+    bool                         clearMainHistory;    /// Whether this thread clears mainHistory
+    NodeCache                    nodeCache;           /// Evaluator results of this search
 
     ~ABSearchData() = default;
 
@@ -66,10 +73,10 @@ public:
     std::array<Depth, MAX_MOVES + 1> reductions[RULE_NB];
 
     ~ABSearcher() = default;
-    std::unique_ptr<SearchData> makeSearchData(SearchThread &th) override
-    {
-        return std::make_unique<ABSearchData>();
-    }
+
+    /// Create search data for a search thread. If shared history is enabled, threads
+    /// on the same NUMA node are given the same main history table.
+    std::unique_ptr<SearchData> makeSearchData(SearchThread &th) override;
 
     /// Set the memory size limit of the search.
     void setMemoryLimit(size_t memorySizeKB) override;
@@ -91,6 +98,9 @@ public:
     /// Checks if current search reaches timeup condition.
     bool checkTimeupCondition() override;
 
+    /// Get the time controller of this searcher.
+    const TimeControl *timeControl() const override { return &timectl; }
+
 private:
     /// Choose the next search depth by checking completed depth of all other
     /// threads and selecting the next depth with least working threads to
@@ -99,6 +109,10 @@ private:
 
     /// Pick thread with the best result according to eval and completed depth.
     SearchThread *pickBestThread(ThreadPool &threads) const;
+
+    /// Main history tables shared by threads in each NUMA node.
+    std::map<Numa::NumaNodeId, std::weak_ptr<MainHistory>> sharedHistories;
+    std::mutex                                             sharedHistoryMutex;
 };
 
 }  // namespace Search::AB
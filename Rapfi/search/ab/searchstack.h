@@ -22,17 +22,19 @@
 #include "../../core/types.h"
 
 #include <cassert>
+#include <cstring>
 #include <vector>
 
 namespace Search::AB {
 
 /// SearchStack struct keeps track of the information we need between nodes in the
 /// tree during the search. Each search thread has its own array of SearchStack
-/// objects, indexed by the current ply.
-struct SearchStack
+/// objects, indexed by the current ply. Each stack fits exactly in one cache line.
+struct alignas(64) SearchStack
 {
-    Pos *const pv;
+    Pos *const pv;        /// PV buffer of this ply, valid in [pv, pv + pvLength)
     const int  ply;
+    int        pvLength;  /// Number of moves in the pv buffer
     int        moveCount;
     Depth      extraExtension;  /// cumulative extension depth that larger than one ply
     int        dbValueDepth;
@@ -47,19 +49,24 @@ struct SearchStack
     bool       ttPv;
     bool       dbChildWritten;
 
-    /// Append current move and to the end of child PV.
+    /// Clear the PV of this ply, which must be done before searching a PV child.
+    void clearPv() { pvLength = 0; }
+
+    /// Set PV of this ply to current move followed by the child PV.
     void updatePv(Pos move)
     {
-        Pos *thisPv  = this->pv;
-        Pos *childPv = (this + 1)->pv;
-        assert(thisPv && childPv);
-
-        *thisPv++ = move;
-        while (*childPv != Pos::NONE)
-            *thisPv++ = *childPv++;
-        *thisPv = Pos::NONE;
+        const SearchStack *child = this + 1;
+        assert(pv && child->pv);
+
+        pv[0] = move;
+        std::memcpy(pv + 1, child->pv, child->pvLength * sizeof(Pos));
+        pvLength = child->pvLength + 1;
     }
 
+    /// Get the range of moves in the PV of this ply.
+    const Pos *pvBegin() const { return pv; }
+    const Pos *pvEnd() const { return pv + pvLength; }
+
     /// Check whether a move is killer at this ply.
     bool isKiller(Pos move) const { return move == killers[0] || move == killers[1]; }
     /// Update killer heruistic move.
@@ -94,7 +101,7 @@ public:
 
         reserve(maxPly + plyBeforeRoot + plyAfterMax);
         for (int i = -plyBeforeRoot; i < maxPly + plyAfterMax; i++)
-            push_back(SearchStack {nextTriPvIndex(i), i});
+            push_back(SearchStack {nextTriPvIndex(i), i, 0});
 
         // Initialize static evaluation for plies before root
         Value staticEval = initStaticEval;
@@ -109,4 +116,6 @@ private:
     std::vector<Pos> triPvTable;
 };
 
+static_assert(sizeof(SearchStack) == 64, "SearchStack should fit exactly in one cache line");
+
 }  // namespace Search::AB
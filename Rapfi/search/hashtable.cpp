@@ -23,14 +23,24 @@
 #include "../core/utils.h"
 #include "searchthread.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>  // For std::memset
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
 #include <vector>
 #ifdef MULTI_THREADING
     #include <thread>
 #endif
 
-static const char HashDumpMagicString[32] = "RAPFI HASH DUMP VER 001";
+static const char HashDumpMagicString[32]   = "RAPFI HASH DUMP VER 001";  // raw buckets
+static const char HashDumpMagicStringV2[32] = "RAPFI HASH DUMP VER 002";  // compact entries
+
+/// Flag in the header of a compact dump that marks it as an incremental dump
+static constexpr uint8_t HashDumpIncrementalFlag = 0x1;
 
 namespace Search {
 
@@ -79,10 +89,22 @@ struct TTBucket
 // Make sure the size of TTBucket can be fitted into one cache line
 static_assert(CACHE_LINE_SIZE % sizeof(TTBucket) == 0, "TTBucket not fitted into cache line");
 
+/// NUMA node of the current thread for node-local probing, -1 if not set
+static thread_local int threadNumaNode = -1;
+
 /// Global shared transposition table
 HashTable TT {16 * 1024};  // default size is 16 MB
 
-HashTable::HashTable(size_t hashSizeKB) : table(nullptr), numBuckets(0)
+HashTable::HashTable(size_t hashSizeKB)
+    : table(nullptr)
+    , numBuckets(0)
+    , numaPolicy(NumaPolicy::DEFAULT)
+    , numPartitions(1)
+    , partitionBuckets(0)
+    , numGenerations(0)
+    , lastDumpId(0)
+    , dumpGenerations(0)
+    , idleGenerations(0)
 {
     resize(hashSizeKB);
 }
@@ -92,6 +114,20 @@ HashTable::~HashTable()
     MemAlloc::alignedLargePageFree(table);
 }
 
+void HashTable::swap(HashTable &other) noexcept
+{
+    std::swap(table, other.table);
+    std::swap(numBuckets, other.numBuckets);
+    std::swap(generation, other.generation);
+    std::swap(numaPolicy, other.numaPolicy);
+    std::swap(numPartitions, other.numPartitions);
+    std::swap(partitionBuckets, other.partitionBuckets);
+    std::swap(numGenerations, other.numGenerations);
+    std::swap(lastDumpId, other.lastDumpId);
+    std::swap(dumpGenerations, other.dumpGenerations);
+    std::swap(idleGenerations, other.idleGenerations);
+}
+
 void HashTable::resize(size_t hashSizeKB)
 {
     size_t newNumBuckets = hashSizeKB * (1024 / sizeof(TTBucket));
@@ -102,12 +138,17 @@ void HashTable::resize(size_t hashSizeKB)
 
     numBuckets = newNumBuckets;
 
+    // Do not report the initial table allocated in the constructor, which might be
+    // during static initialization
+    bool reportPageType = table && Config::MessageMode != MsgMode::NONE;
     if (table) {
         Threads.waitForIdle();
         MemAlloc::alignedLargePageFree(table);
         table = nullptr;
     }
 
+    MemAlloc::MemoryTagScope memoryTag(MemAlloc::MemoryTag::HASH_TABLE);
+
     size_t tryNumBuckets = numBuckets;
     while (tryNumBuckets) {
         size_t allocSize = sizeof(TTBucket) * tryNumBuckets;
@@ -131,12 +172,60 @@ void HashTable::resize(size_t hashSizeKB)
                               << " KB for transposition table.");
     }
 
+    if (reportPageType)
+        MESSAGEL("Transposition table uses "
+                 << MemAlloc::largePageTypeName(MemAlloc::largePageType(table)) << ".");
+
+    setupNumaPlacement();
     clear();
 }
 
+void HashTable::reallocate()
+{
+    size_t sizeKB = hashSizeKB();
+    numBuckets    = 0;  // Force resize() to allocate a new table
+    resize(sizeKB);
+}
+
+void HashTable::setNumaPolicy(NumaPolicy policy)
+{
+    if (policy == numaPolicy)
+        return;
+
+    numaPolicy = policy;
+    reallocate();
+}
+
+void HashTable::setThreadNumaNode(int numaNodeId)
+{
+    threadNumaNode = numaNodeId;
+}
+
+void HashTable::setupNumaPlacement()
+{
+    numPartitions    = numaPolicy == NumaPolicy::PARTITION
+                           ? std::clamp<size_t>(Numa::getNumNodes(), 1, numBuckets)
+                           : 1;
+    partitionBuckets = numBuckets / numPartitions;
+
+    if (numaPolicy == NumaPolicy::INTERLEAVE
+        && !Numa::interleaveMemory(table, numBuckets * sizeof(TTBucket)))
+        MESSAGEL("Warning: failed to interleave transposition table across numa nodes.");
+}
+
 void HashTable::clear()
 {
+    // Incremental dumps can not be applied on a cleared table
+    lastDumpId      = 0;
+    idleGenerations = 0;
+
 #if defined(MULTI_THREADING) && !defined(__EMSCRIPTEN__)
+    if (numPartitions > 1) {
+        clearPartitions();
+        generation = 0;
+        return;
+    }
+
     // Clear hash table in a multi-threaded way
     std::vector<std::thread> threads;
     size_t                   numThreads = std::max<size_t>(Threads.size(), 1);
@@ -165,14 +254,51 @@ void HashTable::clear()
     generation = 0;
 }
 
-TTEntry *HashTable::firstEntry(HashKey key) const
+#if defined(MULTI_THREADING) && !defined(__EMSCRIPTEN__)
+void HashTable::clearPartitions()
+{
+    // Each partition is zeroed chunk by chunk by threads bound to its node, so that
+    // its pages are first touched by (thus placed on) the node that probes it locally
+    constexpr size_t ChunkBuckets = (2 << 20) / sizeof(TTBucket);
+    auto             nextChunk    = std::make_unique<std::atomic<size_t>[]>(numPartitions);
+    auto             clearChunks  = [&](size_t partition) {
+        size_t begin = partition * partitionBuckets;
+        size_t end   = partition + 1 < numPartitions ? begin + partitionBuckets : numBuckets;
+        for (size_t start; (start = begin + nextChunk[partition]++ * ChunkBuckets) < end;)
+            std::memset(&table[start], 0, std::min(ChunkBuckets, end - start) * sizeof(TTBucket));
+    };
+
+    std::vector<std::thread> threads;
+    size_t                   numThreads = std::max(Threads.size(), numPartitions);
+    for (size_t idx = 0; idx < numThreads; idx++)
+        threads.emplace_back([&, idx]() {
+            // Memory placement is per node, regardless of the thread bind policy
+            size_t node = size_t(std::max(Numa::bindThisThread(idx, Numa::BindPolicy::NUMA), 0));
+            clearChunks(node % numPartitions);
+        });
+
+    for (std::thread &th : threads)
+        th.join();
+
+    // Zero the remaining chunks of partitions that no thread has been bound to
+    for (size_t partition = 0; partition < numPartitions; partition++)
+        clearChunks(partition);
+}
+#endif
+
+TTEntry *HashTable::firstEntry(HashKey key, bool nodeLocal) const
 {
+    if (nodeLocal && numPartitions > 1 && threadNumaNode >= 0) {
+        size_t partition = size_t(threadNumaNode) % numPartitions;
+        return table[partition * partitionBuckets + mulhi64(key, partitionBuckets)].entry;
+    }
+
     return table[mulhi64(key, numBuckets)].entry;
 }
 
-void HashTable::prefetch(HashKey key) const
+void HashTable::prefetch(HashKey key, bool nodeLocal) const
 {
-    ::prefetch(firstEntry(key));
+    ::prefetch(firstEntry(key, nodeLocal));
 }
 
 bool HashTable::probe(HashKey hashKey,
@@ -182,9 +308,10 @@ bool HashTable::probe(HashKey hashKey,
                       Bound  &ttBound,
                       Pos    &ttMove,
                       int    &ttDepth,
-                      int     ply)
+                      int     ply,
+                      bool    nodeLocal)
 {
-    TTEntry *entry = firstEntry(hashKey);
+    TTEntry *entry = firstEntry(hashKey, nodeLocal);
     uint32_t key32 = uint32_t(hashKey);
 
     // Iterate the bucket to find a matched entry
@@ -217,9 +344,10 @@ void HashTable::store(HashKey hashKey,
                       Bound   bound,
                       Pos     move,
                       int     depth,
-                      int     ply)
+                      int     ply,
+                      bool    nodeLocal)
 {
-    TTEntry *entry        = firstEntry(hashKey);
+    TTEntry *entry        = firstEntry(hashKey, nodeLocal);
     uint32_t newKey32     = uint32_t(hashKey);
     TTEntry *replace      = &entry[0];
     auto     replaceValue = [=](const TTEntry &e) {
@@ -265,26 +393,163 @@ void HashTable::store(HashKey hashKey,
     *replace = newEntry;  // Copy to shared memory
 }
 
-void HashTable::dump(std::ostream &outStream) const
+namespace {
+
+/// Compact dumps store the bucket index of each record as a LEB128 varint of the
+/// distance from the bucket of the previous record.
+void writeVarint(std::string &out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(char(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+bool readVarint(std::istream &in, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = in.get();
+        if (byte == std::istream::traits_type::eof())
+            return false;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+/// DumpChunk is the encoded records of a range of buckets. The distance of the first
+/// record is left out, as it depends on the last record of the previous chunk.
+struct DumpChunk
+{
+    size_t      firstBucket = 0;
+    size_t      lastBucket  = 0;
+    bool        empty       = true;
+    std::string records;
+};
+
+}  // namespace
+
+bool HashTable::dump(std::ostream &outStream, HashDumpOptions options)
 {
-    Compressor    compressor(outStream, Compressor::Type::LZ4_DEFAULT);
+    // Incremental dump needs a base, and all entries changed since it must still be
+    // distinguishable by their 8-bit generation
+    uint64_t generationsSinceDump = numGenerations - dumpGenerations;
+    bool     incremental          = options.incremental && lastDumpId && generationsSinceDump < 256;
+    uint64_t dumpId               = 0;
+    for (std::random_device rd; !dumpId;)
+        dumpId = uint64_t(rd()) << 32 | rd();
+
+    // Incremental dumps take entries accessed after the last dump, which bumped the
+    // generation. Full dumps take entries of recent search generations, which excludes
+    // generations bumped by dumps and loads.
+    uint8_t maxAge   = incremental
+                           ? uint8_t(generationsSinceDump - 1)
+                           : uint8_t(std::min(options.maxAge + idleGenerations, 255));
+    auto    selected = [=](const TTEntry &e) {
+        return e.depth8 && uint8_t(generation - e.generation8) <= maxAge;
+    };
+    auto encodeChunk = [&](size_t begin, size_t end, DumpChunk &chunk) {
+        chunk.records.clear();
+        chunk.empty = true;
+        for (size_t i = begin; i < end; i++) {
+            const TTEntry *entry = table[i].entry;
+            uint8_t        mask  = 0;
+            for (int j = 0; j < ENTRIES_PER_BUCKET; j++)
+                mask |= uint8_t(selected(entry[j])) << j;
+            if (!mask)
+                continue;
+
+            if (chunk.empty) {
+                chunk.firstBucket = i;
+                chunk.empty       = false;
+            }
+            else
+                writeVarint(chunk.records, i - chunk.lastBucket);
+            chunk.lastBucket = i;
+
+            chunk.records.push_back(char(mask));
+            for (int j = 0; j < ENTRIES_PER_BUCKET; j++)
+                if (mask >> j & 1)
+                    chunk.records.append(reinterpret_cast<const char *>(&entry[j]),
+                                         sizeof(TTEntry));
+        }
+    };
+
+    Compressor    compressor(outStream,
+                          options.compress ? Compressor::Type::LZ4_PARALLEL
+                                              : Compressor::Type::NO_COMPRESS);
     std::ostream *out = compressor.openOutputStream();
     assert(out);
 
-    // Write hash dump magic
-    out->write(HashDumpMagicString, sizeof(HashDumpMagicString));
+    // Write hash dump header
+    uint8_t  flags      = incremental ? HashDumpIncrementalFlag : 0;
+    uint64_t baseDumpId = incremental ? lastDumpId : 0;
+    out->write(HashDumpMagicStringV2, sizeof(HashDumpMagicStringV2));
     out->write(reinterpret_cast<const char *>(&numBuckets), sizeof(numBuckets));
     out->write(reinterpret_cast<const char *>(&generation), sizeof(generation));
+    out->write(reinterpret_cast<const char *>(&flags), sizeof(flags));
+    out->write(reinterpret_cast<const char *>(&dumpId), sizeof(dumpId));
+    out->write(reinterpret_cast<const char *>(&baseDumpId), sizeof(baseDumpId));
 
-    for (size_t i = 0; i < numBuckets; i++) {
-        TTBucket &cluster = table[i];
-        out->write(reinterpret_cast<const char *>(&cluster), sizeof(TTBucket));
+    // Encode chunks of buckets in parallel, then write them in order
+    constexpr size_t ChunkBuckets = 1 << 18;
+#if defined(MULTI_THREADING) && !defined(__EMSCRIPTEN__)
+    size_t numThreads = std::max<size_t>(Threads.size(), 1);
+#else
+    size_t numThreads = 1;
+#endif
+    std::vector<DumpChunk> chunks(numThreads);
+    size_t                 lastBucket = 0;
+    std::string            distance;
+
+    for (size_t batchBegin = 0; batchBegin < numBuckets; batchBegin += numThreads * ChunkBuckets) {
+        auto encodeBatchChunk = [&, batchBegin](size_t idx) {
+            size_t begin = std::min(batchBegin + idx * ChunkBuckets, numBuckets);
+            size_t end   = std::min(begin + ChunkBuckets, numBuckets);
+            encodeChunk(begin, end, chunks[idx]);
+        };
+
+#if defined(MULTI_THREADING) && !defined(__EMSCRIPTEN__)
+        std::vector<std::thread> threads;
+        for (size_t idx = 1; idx < numThreads; idx++)
+            threads.emplace_back(encodeBatchChunk, idx);
+        encodeBatchChunk(0);
+        for (std::thread &th : threads)
+            th.join();
+#else
+        encodeBatchChunk(0);
+#endif
+
+        for (const DumpChunk &chunk : chunks) {
+            if (chunk.empty)
+                continue;
+
+            distance.clear();
+            writeVarint(distance, chunk.firstBucket - lastBucket);
+            out->write(distance.data(), distance.size());
+            out->write(chunk.records.data(), chunk.records.size());
+            lastBucket = chunk.lastBucket;
+        }
     }
+
+    // A record with an empty slot mask terminates the dump
+    distance.assign(2, '\0');
+    out->write(distance.data(), distance.size());
+
+    // Entries accessed from now on are newer than this dump
+    markDumpBase(dumpId);
+    return incremental;
 }
 
 bool HashTable::load(std::istream &inStream)
 {
-    Compressor    compressor(inStream, Compressor::Type::LZ4_DEFAULT);
+    // Compressed dumps start with the LZ4 frame magic instead of the dump magic
+    bool          compressed = inStream.peek() != HashDumpMagicString[0];
+    auto          type = compressed ? Compressor::Type::LZ4_DEFAULT : Compressor::Type::NO_COMPRESS;
+    Compressor    compressor(inStream, type);
     std::istream *in = compressor.openInputStream();
     if (!in)
         return false;
@@ -292,24 +557,110 @@ bool HashTable::load(std::istream &inStream)
     // Validate hash dump magic
     char magic[sizeof(HashDumpMagicString)];
     in->read(magic, sizeof(HashDumpMagicString));
-    if (std::memcmp(magic, HashDumpMagicString, sizeof(HashDumpMagicString)) != 0)
+    if (std::memcmp(magic, HashDumpMagicString, sizeof(HashDumpMagicString)) == 0)
+        return loadRaw(*in);
+    else if (std::memcmp(magic, HashDumpMagicStringV2, sizeof(HashDumpMagicStringV2)) == 0)
+        return loadEntries(*in);
+    else
         return false;
+}
 
-    in->read(reinterpret_cast<char *>(&numBuckets), sizeof(numBuckets));
-    in->read(reinterpret_cast<char *>(&generation), sizeof(generation));
+bool HashTable::loadRaw(std::istream &in)
+{
+    in.read(reinterpret_cast<char *>(&numBuckets), sizeof(numBuckets));
+    in.read(reinterpret_cast<char *>(&generation), sizeof(generation));
     if (numBuckets == 0)
         return false;
 
     if (table)
         MemAlloc::alignedLargePageFree(table);
+
+    MemAlloc::MemoryTagScope memoryTag(MemAlloc::MemoryTag::HASH_TABLE);
+
     size_t allocSize = sizeof(TTBucket) * numBuckets;
     table            = static_cast<TTBucket *>(MemAlloc::alignedLargePageAlloc(allocSize));
+    setupNumaPlacement();
 
     for (size_t i = 0; i < numBuckets; i++) {
         TTBucket &cluster = table[i];
-        in->read(reinterpret_cast<char *>(&cluster), sizeof(TTBucket));
+        in.read(reinterpret_cast<char *>(&cluster), sizeof(TTBucket));
+    }
+
+    lastDumpId = 0;
+    return in && in.peek() == std::ios::traits_type::eof();
+}
+
+bool HashTable::loadEntries(std::istream &in)
+{
+    size_t   dumpNumBuckets;
+    uint8_t  dumpGeneration;
+    uint8_t  flags;
+    uint64_t dumpId, baseDumpId;
+    in.read(reinterpret_cast<char *>(&dumpNumBuckets), sizeof(dumpNumBuckets));
+    in.read(reinterpret_cast<char *>(&dumpGeneration), sizeof(dumpGeneration));
+    in.read(reinterpret_cast<char *>(&flags), sizeof(flags));
+    in.read(reinterpret_cast<char *>(&dumpId), sizeof(dumpId));
+    in.read(reinterpret_cast<char *>(&baseDumpId), sizeof(baseDumpId));
+    if (!in || dumpNumBuckets == 0)
+        return false;
+
+    if (flags & HashDumpIncrementalFlag) {
+        // Incremental dump only applies on the exact table state it is based on
+        if (!lastDumpId || baseDumpId != lastDumpId || dumpNumBuckets != numBuckets)
+            return false;
+    }
+    else {
+        if (dumpNumBuckets != numBuckets) {
+            if (table)
+                MemAlloc::alignedLargePageFree(table);
+            numBuckets = dumpNumBuckets;
+
+            MemAlloc::MemoryTagScope memoryTag(MemAlloc::MemoryTag::HASH_TABLE);
+
+            size_t allocSize = sizeof(TTBucket) * numBuckets;
+            table = static_cast<TTBucket *>(MemAlloc::alignedLargePageAlloc(allocSize));
+            if (!table) {
+                numBuckets = 0;
+                return false;
+            }
+            setupNumaPlacement();
+        }
+        clear();
+    }
+    generation = dumpGeneration;
+
+    size_t bucket = 0;
+    for (uint64_t distance; readVarint(in, distance);) {
+        int mask = in.get();
+        if (mask == 0)
+            break;
+        if (mask == std::istream::traits_type::eof() || mask >> ENTRIES_PER_BUCKET)
+            return false;
+
+        bucket += distance;
+        if (bucket >= numBuckets)
+            return false;
+
+        TTEntry *entry = table[bucket].entry;
+        for (int j = 0; j < ENTRIES_PER_BUCKET; j++)
+            if (mask >> j & 1)
+                in.read(reinterpret_cast<char *>(&entry[j]), sizeof(TTEntry));
     }
-    return *in && in->peek() == std::ios::traits_type::eof();
+
+    markDumpBase(dumpId);
+    return in && in.peek() == std::ios::traits_type::eof();
+}
+
+void HashTable::markDumpBase(uint64_t dumpId)
+{
+    lastDumpId      = dumpId;
+    dumpGenerations = numGenerations;
+
+    // Bump the generation so that entries accessed from now on are newer than the base,
+    // even if they are stored without starting a new search generation
+    generation += 1;
+    numGenerations += 1;
+    idleGenerations += idleGenerations < 255;
 }
 
 int HashTable::hashUsage() const
@@ -31,11 +31,31 @@ namespace Search {
 struct TTEntry;   // forward declaration of TTEntry
 struct TTBucket;  // forward declaration of TTBucket
 
+/// HashDumpOptions controls the content and encoding of a transposition table dump.
+struct HashDumpOptions
+{
+    /// Only dump entries changed since the last dump or load of this table. A full
+    /// dump is written instead if there is no base dump to apply the changes on.
+    bool incremental = false;
+    /// Compress the dump with independent LZ4 frames in parallel.
+    bool compress = true;
+    /// Full dumps only contain entries accessed within the last (maxAge + 1)
+    /// generations, so the default dumps entries of the current generation.
+    uint8_t maxAge = 0;
+};
+
 /// HashTable class is the shared transposition table implementation
 /// with a five-tier bucket system replacement strategies.
 class HashTable
 {
 public:
+    /// NumaPolicy controls how the table memory is placed on NUMA nodes.
+    enum class NumaPolicy {
+        DEFAULT,     // Pages are placed by first touch of the clearing threads
+        INTERLEAVE,  // Pages are interleaved across all nodes
+        PARTITION,   // Buckets are partitioned by node, with node-local probing
+    };
+
     HashTable(size_t hashSizeKB);
     ~HashTable();
 
@@ -44,10 +64,21 @@ public:
     /// When memory allocation failed, it will try to find the max available hash
     /// size by reducing cluster count to half recursively.
     void resize(size_t hashSizeKB);
+    /// Reallocate the table with the same size, so that it picks up a changed large
+    /// page setting. All hash entries will be cleared.
+    void reallocate();
+    /// Set the NUMA placement policy. The table is reallocated if the policy changed.
+    void setNumaPolicy(NumaPolicy policy);
+    /// Set the NUMA node of the calling thread, which selects the partition used by
+    /// node-local probes. Threads with no node set always probe the whole table.
+    static void setThreadNumaNode(int numaNodeId);
     /// Clear all hash entries. If multi-threading is enabled, clearing will be
     /// performed in parallel with number of threads equals to `Threads.size()`.
     void clear();
     /// Probe the transposition table for a hash key.
+    /// @param nodeLocal Whether to probe the partition of this thread's NUMA node. It
+    ///     must be the same for probing and storing a position, and it only takes
+    ///     effect with the PARTITION policy.
     /// @return True if found a matched entry or a not used entry.
     bool probe(HashKey hashKey,
                Value  &ttValue,
@@ -56,7 +87,8 @@ public:
                Bound  &ttBound,
                Pos    &ttMove,
                int    &ttDepth,
-               int     ply);
+               int     ply,
+               bool    nodeLocal = false);
     /// Store a new entry in the transposition table.
     void store(HashKey hashKey,
                Value   value,
@@ -65,15 +97,27 @@ public:
                Bound   bound,
                Pos     move,
                int     depth,
-               int     ply);
+               int     ply,
+               bool    nodeLocal = false);
     /// Prefetch the cacheline at the address of a hash key.
-    void prefetch(HashKey key) const;
+    void prefetch(HashKey key, bool nodeLocal = false) const;
+    /// Exchange all entries with another table, without copying any of them.
+    void swap(HashTable &other) noexcept;
     /// Increase the current generation (aging all entries in the table).
-    void incGeneration() { generation += 1; }
-    /// Dump the transposition table to an ostream.
-    void dump(std::ostream &out) const;
-    /// Load the transposition table from the stream, previous TT will be
-    /// released. Incorrect data stream will cause loading to fail.
+    void incGeneration()
+    {
+        generation += 1;
+        numGenerations += 1;
+        idleGenerations = 0;
+    }
+    /// Dump the occupied entries of the transposition table to an ostream. Only the
+    /// bucket index and slot of each entry is stored besides the entry itself.
+    /// @return Whether an incremental dump is written.
+    bool dump(std::ostream &out, HashDumpOptions options = {});
+    /// Load the transposition table from the stream. A full dump releases the previous
+    /// table, while an incremental dump is applied on top of the table state it is based
+    /// on, which must be the last dump or load of this table. Incorrect data stream will
+    /// cause loading to fail.
     /// @return Whether loading succeeded.
     bool load(std::istream &in);
     /// Estimate the occupation ratio of the tt table during a search.
@@ -83,12 +127,29 @@ public:
     size_t hashSizeKB() const;
 
 private:
-    TTBucket *table;
-    size_t    numBuckets;
-    uint8_t   generation;
+    TTBucket  *table;
+    size_t     numBuckets;
+    uint8_t    generation;
+    NumaPolicy numaPolicy;
+    size_t     numPartitions;     // Number of NUMA partitions, 1 if not partitioned
+    size_t     partitionBuckets;  // Number of buckets in each NUMA partition
+    uint64_t   numGenerations;    // Number of generation increases since construction
+    uint64_t   lastDumpId;        // Id of the last dump written or loaded, 0 if none
+    uint64_t   dumpGenerations;   // numGenerations at the last dump or load
+    uint8_t    idleGenerations;   // Generations added by dumps and loads since last search
 
+    /// Setup NUMA placement of a newly allocated table before it is first touched.
+    void setupNumaPlacement();
+    /// Clear a partitioned table with threads bound to the node of each partition.
+    void clearPartitions();
+    /// Load the raw bucket array of a dump in the old uncompacted format.
+    bool loadRaw(std::istream &in);
+    /// Load the entries of a compact dump into the table.
+    bool loadEntries(std::istream &in);
+    /// Mark the current table state as the base of the next incremental dump.
+    void markDumpBase(uint64_t dumpId);
     /// Get address of the first entry for a hash key.
-    TTEntry *firstEntry(HashKey key) const;
+    TTEntry *firstEntry(HashKey key, bool nodeLocal) const;
 };
 
 extern HashTable TT;
@@ -74,8 +74,9 @@ enum MoveHistoryType { HIST_ATTACK, HIST_QUIET, MAIN_HIST_TYPE_NB };
 
 /// MainHistory records how often a certain type of move has been successful or unsuccessful
 /// (causing a beta cutoff) during the current search. It is indexed by color of the move,
-/// move's position, and the move's history type.
-typedef HistTable<int16_t, 10692, SIDE_NB, FULL_BOARD_CELL_COUNT, MAIN_HIST_TYPE_NB> MainHistory;
+/// move's index (Pos::moveIndex(), without the full board padding), and the move's history
+/// type. Both history types of one move are adjacent, so they are read in one cache line.
+typedef HistTable<int16_t, 10692, SIDE_NB, MAX_MOVES, MAIN_HIST_TYPE_NB> MainHistory;
 
 /// CounterMoveHistory records a natural response of moves irrespective of the actual position.
 /// It is indexed by color of the previous move, previous move's position and current move's type.
@@ -42,6 +42,12 @@ Node::~Node()
         delete edgeArray;
 }
 
+size_t Node::memoryUsage() const
+{
+    const EdgeArray *edgeArray = getEdges();
+    return sizeof(Node) + (edgeArray ? sizeof(EdgeArray) + edgeArray->numEdges * sizeof(Edge) : 0);
+}
+
 void Node::setTerminal(Value value)
 {
     assert(value != VALUE_NONE);
@@ -85,7 +91,7 @@ void Node::setNonTerminal(float utility, float drawRate)
     n.store(1, std::memory_order_release);
 }
 
-bool Node::createEdges(MovePicker &movePicker)
+bool Node::createEdges(MovePicker &movePicker, NodeTable &nodeTable)
 {
     Pos      moveList[MAX_MOVES];
     float    policyList[MAX_MOVES];
@@ -117,6 +123,8 @@ bool Node::createEdges(MovePicker &movePicker)
     // If we are not the one that sets the edge array, then we need to delete the temp edge array
     if (!suc)
         delete[] tempEdges;
+    else
+        nodeTable.trackEdgeAlloc(hash, numAllocs * sizeof(AllocType));
 
     return false;
 }
@@ -174,9 +174,13 @@ public:
 
     /// Initializes the edges of this node from the given move picker.
     /// @param movePicker The move picker to generate the edges.
+    /// @param nodeTable The node table of this node, where the edge memory is accounted.
     /// @return Whether this node has no valid edges. If true,
     ///   this node is a terminal node that has been mated.
-    bool createEdges(MovePicker &movePicker);
+    bool createEdges(MovePicker &movePicker, NodeTable &nodeTable);
+
+    /// Returns the memory of this node and its edges in bytes.
+    size_t memoryUsage() const;
 
     /// Returns the graph hash key of this node.
     HashKey getHash() const { return hash; }
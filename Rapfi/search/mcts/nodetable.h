@@ -16,9 +16,11 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "../../core/platform.h"
 #include "../../core/types.h"
 #include "node.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -43,9 +45,10 @@ public:
 
     struct Shard
     {
-        size_t             index;
-        Table             &table;
-        std::shared_mutex &mutex;
+        size_t               index;
+        Table               &table;
+        std::shared_mutex   &mutex;
+        std::atomic<size_t> &memoryBytes;
     };
 
     NodeTable(size_t numShardsPowerOfTwo)
@@ -53,7 +56,14 @@ public:
         , mask(numShards - 1)
         , tables(std::make_unique<Table[]>(numShards))
         , mutexes(std::make_unique<std::shared_mutex[]>(numShards))
-    {}
+        , memoryCounters(std::make_unique<MemoryCounter[]>(numShards))
+    {
+        MemAlloc::addMemoryCounter(MemAlloc::MemoryTag::MCTS_TREE, this, [this]() {
+            return memoryUsage();
+        });
+    }
+
+    ~NodeTable() { MemAlloc::removeMemoryCounter(this); }
 
     /// Get the total number of shards of this node table.
     size_t getNumShards() const { return numShards; }
@@ -62,7 +72,7 @@ public:
     /// @note This function is thread-safe.
     Shard getShardByShardIndex(size_t index) const
     {
-        return Shard {index, tables[index], mutexes[index]};
+        return Shard {index, tables[index], mutexes[index], memoryCounters[index].bytes};
     }
 
     /// Get the shard that contains the node with the given hash key.
@@ -103,15 +113,57 @@ public:
 
         // Try to emplace the node after acquiring the writer lock
         auto [it, inserted] = shard.table.emplace(hash, std::forward<Args>(args)...);
+        if (inserted)
+            shard.memoryBytes.fetch_add(sizeof(Node), std::memory_order_relaxed);
         // We also return whether the node is actually created by us
         return {std::addressof(const_cast<Node &>(*it)), inserted};
     }
 
+    /// Erase the node at the iterator from the shard, whose writer lock must be held.
+    /// @return Iterator following the erased node.
+    Table::iterator eraseNode(Shard shard, Table::iterator it)
+    {
+        shard.memoryBytes.fetch_sub(it->memoryUsage(), std::memory_order_relaxed);
+        return shard.table.erase(it);
+    }
+
+    /// Erase all nodes in the shard, whose writer lock must be held.
+    void clearShard(Shard shard)
+    {
+        shard.table.clear();
+        shard.memoryBytes.store(0, std::memory_order_relaxed);
+    }
+
+    /// Account the memory of an edge array created by the node with the given hash key.
+    /// @note This function is thread-safe.
+    void trackEdgeAlloc(HashKey hash, size_t size)
+    {
+        getShardByHash(hash).memoryBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    /// Returns the memory of all nodes and edges in this table in bytes. The shard counters
+    /// are only summed here, so that expanding the tree never touches a global counter.
+    /// @note This function is thread-safe.
+    size_t memoryUsage() const
+    {
+        size_t bytes = 0;
+        for (size_t i = 0; i < numShards; i++)
+            bytes += memoryCounters[i].bytes.load(std::memory_order_relaxed);
+        return bytes;
+    }
+
 private:
+    /// Memory counter of a shard, padded to a cache line to avoid false sharing.
+    struct alignas(64) MemoryCounter
+    {
+        std::atomic<size_t> bytes = 0;
+    };
+
     size_t                               numShards;
     size_t                               mask;
     std::unique_ptr<Table[]>             tables;
     std::unique_ptr<std::shared_mutex[]> mutexes;
+    std::unique_ptr<MemoryCounter[]>     memoryCounters;
 };
 
 }  // namespace Search::MCTS
@@ -140,7 +140,7 @@ Value vcfsearch(Board &board, SearchStack *ss, int ply, Value alpha, Value beta,
                       depth,
                       {ss[ply - 2].moveP4[self], ss[ply - 4].moveP4[self]}});
 
-    while (Pos move = mp()) {
+    while (Pos move = mp.next<Rule>()) {
         assert(board.isLegal(move));
         ss[ply].moveP4[BLACK] = board.cell(move).pattern4[BLACK];
         ss[ply].moveP4[WHITE] = board.cell(move).pattern4[WHITE];
@@ -401,6 +401,8 @@ std::pair<Edge *, Node *> selectChild(Node &node, const Board &board)
 template <bool Root = false>
 bool expandNode(Node &node, const SearchOptions &options, const Board &board, int ply)
 {
+    MCTSSearcher &searcher = static_cast<MCTSSearcher &>(*board.thisThread()->threads.searcher());
+
     if constexpr (Root) {
         MovePicker mp(options.rule,
                       board,
@@ -408,7 +410,7 @@ bool expandNode(Node &node, const SearchOptions &options, const Board &board, in
                           true,
                           RootPolicyTemperature,
                       });
-        bool       noValidMove = node.createEdges(mp);
+        bool       noValidMove = node.createEdges(mp, *searcher.nodeTable);
         assert(!node.isLeaf());
         assert(!noValidMove);
         return false;
@@ -424,7 +426,7 @@ bool expandNode(Node &node, const SearchOptions &options, const Board &board, in
                           PolicyTemperature,
                       });
 
-        bool noValidMove = node.createEdges(mp);
+        bool noValidMove = node.createEdges(mp, *searcher.nodeTable);
         if (noValidMove) {
             Value terminalValue = board.p4Count(~board.sideToMove(), A_FIVE)
                                       ? mated_in(board.ply() + 2)
@@ -538,9 +540,10 @@ uint32_t searchNode(Node &node, Board &board, int ply, uint32_t newVisits)
         // Select the best edge to explore
         auto [childEdge, childNode] = selectChild<Root>(node, board);
 
-        // Make the move to reach the child node
+        // Make the move to reach the child node. Mcts reads only the evaluator value,
+        // so classical eval maintenance is skipped in the playout.
         Pos move = childEdge->getMove();
-        board.move(options.rule, move);
+        board.move<Board::MoveType::NO_CLASSICAL_EVAL>(options.rule, move);
 
         // Reaching a leaf node, expand it
         bool allocatedNode = false;
@@ -603,7 +606,7 @@ uint32_t searchNode(Node &node, Board &board, int ply, uint32_t newVisits)
         }
 
         // Undo the move
-        board.undo(options.rule);
+        board.undo<Board::MoveType::NO_CLASSICAL_EVAL>(options.rule);
 
         // Record root move's seldepth
         if constexpr (Root) {
@@ -893,7 +896,7 @@ void MCTSSearcher::clear(ThreadPool &pool, bool clearAllMemory)
 
                     NodeTable::Shard shard = this->nodeTable->getShardByShardIndex(shardIdx);
                     std::unique_lock lock(shard.mutex);
-                    shard.table.clear();
+                    this->nodeTable->clearShard(shard);
                 }
             },
             true);
@@ -909,6 +912,7 @@ void MCTSSearcher::searchMain(MainSearchThread &th)
 {
     SearchOptions &opts  = th.options();
     Board         &board = *th.board;
+    timectl.clearRecord();
 
     // Probe opening database and find if there is a prepared opening
     if (!opts.disableOpeningQuery
@@ -964,6 +968,7 @@ void MCTSSearcher::searchMain(MainSearchThread &th)
     printer.printSearchStarts(th, timectl);
     setupRootNode(th);  // Setup root node and other stuffs
     th.runCustomTaskAndWait([this](SearchThread &t) { search(t); }, true);
+    timectl.recordSearchEnd();
 
     // Rank root moves and record best move
     updateRootMovesData(th);
@@ -1128,7 +1133,7 @@ void MCTSSearcher::recycleOldNodes(MainSearchThread &th)
                 for (auto it = shard.table.begin(); it != shard.table.end();) {
                     Node *node = std::addressof(const_cast<Node &>(*it));
                     if (node->getAgeRef().load(std::memory_order_relaxed) != this->globalNodeAge) {
-                        it = shard.table.erase(it);
+                        it = this->nodeTable->eraseNode(shard, it);
                         numRecycledNodes.fetch_add(1, std::memory_order_relaxed);
                     }
                     else
@@ -64,6 +64,9 @@ public:
     /// Get the current memory size limit of the search.
     size_t getMemoryLimit() const override;
 
+    /// The memory limit is ignored, as the tree is not bounded by the hash table size.
+    bool hasMemoryLimit() const override { return false; }
+
     /// Clear the state of the searcher between two different games
     void clear(ThreadPool &pool, bool clearAllMemory) override;
 
@@ -78,6 +81,9 @@ public:
     /// Checks if current search reaches timeup condition.
     bool checkTimeupCondition() override;
 
+    /// Get the time controller of this searcher.
+    const TimeControl *timeControl() const override { return &timectl; }
+
 private:
     /// Setup root node for the search
     void setupRootNode(MainSearchThread &th);
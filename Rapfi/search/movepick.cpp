@@ -24,6 +24,7 @@
 #include "searchthread.h"
 
 #include <algorithm>
+#include <tuple>
 
 namespace {
 
@@ -92,6 +93,7 @@ MovePicker::MovePicker(Rule rule, const Board &board, ExtraArgs<MovePicker::ROOT
     : board(board)
     , mainHistory(nullptr)
     , counterMoveHistory(nullptr)
+    , nodeCache(nullptr)
     , stage(ALLMOVES)
     , rule(rule)
     , ttMove(Pos::NONE)
@@ -157,6 +159,7 @@ MovePicker::MovePicker(Rule rule, const Board &board, ExtraArgs<MovePicker::MAIN
     : board(board)
     , mainHistory(args.mainHistory)
     , counterMoveHistory(args.counterMoveHistory)
+    , nodeCache(args.useNormalizedPolicy ? nullptr : args.nodeCache)
     , rule(rule)
     , allowPlainB4InVCF(false)
     , hasPolicy(false)
@@ -199,6 +202,7 @@ template <>
 MovePicker::MovePicker(Rule rule, const Board &board, ExtraArgs<MovePicker::QVCF> args)
     : board(board)
     , mainHistory(nullptr)
+    , nodeCache(nullptr)
     , rule(rule)
     , allowPlainB4InVCF(
           args.depth >= DEPTH_QVCF_FULL
@@ -229,10 +233,10 @@ MovePicker::MovePicker(Rule rule, const Board &board, ExtraArgs<MovePicker::QVCF
 /// Return the next move satisfying a predicate function.
 /// Selected move is recorded in curMoves. It never returns the TT move.
 /// If there is no move left, it returns Pos::NONE.
-template <MovePicker::PickType T, typename Pred>
+template <Rule R, MovePicker::PickType T, typename Pred>
 Pos MovePicker::pickNextMove(Pred filter)
 {
-    bool forbidden = rule == Rule::RENJU && board.sideToMove() == BLACK;
+    bool forbidden = R == Rule::RENJU && board.sideToMove() == BLACK;
 
     while (curMove < endMove) {
         if constexpr (T == Best)
@@ -268,24 +272,51 @@ void MovePicker::scoreAllMoves()
     PolicyBuffer       *policyBuf = reinterpret_cast<PolicyBuffer *>(&policyBufferStorage);
     Evaluator *evaluator = board.thisThread() ? board.thisThread()->evaluator.get() : nullptr;
 
+    // Policy scores of the move list that are reused from or saved to the node cache
+    const Score *cachedPolicy = nullptr;
+
     if (bool(Type & POLICY) && evaluator) {
-        new (policyBuf) Evaluation::PolicyBuffer(board.size());
+        HashKey key = nodeCache ? board.zobristKey() : 0;
+        if (nodeCache)
+            cachedPolicy = nodeCache->probePolicy(key);
+
+        if (!cachedPolicy) {
+            new (policyBuf) Evaluation::PolicyBuffer(board.size());
+
+            // Set compute flag for all moves in move list
+            for (auto &m : *this)
+                policyBuf->setComputeFlag(m.pos);
 
-        // Set compute flag for all moves in move list
-        for (auto &m : *this)
-            policyBuf->setComputeFlag(m.pos);
+            evaluator->evaluatePolicy(board, *policyBuf);
+
+            if (nodeCache) {
+                Score *policy = nodeCache->storePolicy(key);
+                for (auto &m : *this)
+                    policy[nodeCache->policyIndex(m.pos)] = policyBuf->score(m.pos);
+                cachedPolicy = policy;
+            }
+        }
 
-        evaluator->evaluatePolicy(board, *policyBuf);
         hasPolicy      = true;
         maxPolicyScore = std::numeric_limits<Score>::lowest() / 2;
     }
 
+    // The counter move only depends on the last move, so look it up once for all moves
+    Pos      counterMove   = Pos::NONE;
+    Pattern4 counterMoveP4 = NONE;
+    if (bool(Type & COUNTER_MOVE) && counterMoveHistory) {
+        if (Pos lastMove = board.getLastMove(); board.isInBoard(lastMove))
+            std::tie(counterMove, counterMoveP4) =
+                (*counterMoveHistory)[oppo][lastMove.moveIndex()].get();
+    }
+
     maxScore = std::numeric_limits<Score>::lowest() / 2;
     for (auto &m : *this) {
         const Cell &c = board.cell(m);
 
         if (bool(Type & POLICY) && evaluator) {
-            m.score = m.rawScore = policyBuf->score(m.pos);
+            m.score = m.rawScore = cachedPolicy ? cachedPolicy[nodeCache->policyIndex(m.pos)]
+                                                : policyBuf->score(m.pos);
             maxPolicyScore       = std::max(maxPolicyScore, m.rawScore);
         }
         else if constexpr (bool(Type & BALANCED))
@@ -298,21 +329,17 @@ void MovePicker::scoreAllMoves()
             assert(false && "incorrect score type");
 
         if (bool(Type & MAIN_HISTORY) && mainHistory) {
+            const auto &hist = (*mainHistory)[self][m.pos.moveIndex()];
             if (c.pattern4[self] >= H_FLEX3)
-                m.score += (*mainHistory)[self][m.pos][HIST_ATTACK] / 128;
+                m.score += hist[HIST_ATTACK] / 128;
             else
-                m.score += (*mainHistory)[self][m.pos][HIST_QUIET] / 256;
+                m.score += hist[HIST_QUIET] / 256;
         }
 
-        if (bool(Type & COUNTER_MOVE) && counterMoveHistory) {
-            if (Pos lastMove = board.getLastMove(); board.isInBoard(lastMove)) {
-                const int CounterMoveBonus = 21;
-                auto [counterMove, counterMoveP4] =
-                    (*counterMoveHistory)[oppo][lastMove.moveIndex()].get();
-
-                if (counterMove == m.pos && counterMoveP4 <= c.pattern4[self])
-                    m.score += CounterMoveBonus;
-            }
+        if (bool(Type & COUNTER_MOVE) && counterMove == m.pos
+            && counterMoveP4 <= c.pattern4[self]) {
+            const int CounterMoveBonus = 21;
+            m.score += CounterMoveBonus;
         }
 
         maxScore = std::max(maxScore, m.score);
@@ -346,6 +373,24 @@ void MovePicker::scoreAllMoves()
 /// @return Next legal move, or Pos::NONE if there is no legal move left.
 Pos MovePicker::operator()()
 {
+    switch (rule) {
+    default:
+    case FREESTYLE: return next<FREESTYLE>();
+    case STANDARD: return next<STANDARD>();
+    case RENJU: return next<RENJU>();
+    }
+}
+
+/// Pick the next legal move with the rule specialised at compile time.
+template <Rule R>
+Pos MovePicker::next()
+{
+    constexpr GenType RuleType = R == RENJU      ? RULE_RENJU
+                                 : R == STANDARD ? RULE_STANDARD
+                                                 : RULE_FREESTYLE;
+    constexpr GenType VCFType  = R == RENJU ? VCF | RULE_RENJU : VCF;
+    assert(R == rule);
+
 top:
     switch (stage) {
     case MAIN_TT:
@@ -391,7 +436,7 @@ top:
 
         curMove = moves;
         endMove = generate<DEFEND_FOUR>(board, curMove);
-        endMove = (rule == RENJU ? generate<VCF | RULE_RENJU> : generate<VCF>)(board, endMove);
+        endMove = generate<VCFType>(board, endMove);
 
         if (useNormalizedPolicy) {
             scoreAllMoves<ScoreType(BALANCED | POLICY)>();
@@ -409,19 +454,14 @@ top:
         assert(board.p4Count(~board.sideToMove(), C_BLOCK4_FLEX3));
 
         curMove = moves;
-        switch (rule) {
-        default:
-        case FREESTYLE: endMove = generate<DEFEND_B4F3 | RULE_FREESTYLE>(board, curMove); break;
-        case STANDARD: endMove = generate<DEFEND_B4F3 | RULE_STANDARD>(board, curMove); break;
-        case RENJU: endMove = generate<DEFEND_B4F3 | RULE_RENJU>(board, curMove); break;
-        }
+        endMove = generate<DEFEND_B4F3 | RuleType>(board, curMove);
 
         if (endMove == curMove) {
             stage = MAIN_MOVES;
             goto top;
         }
 
-        endMove = (rule == RENJU ? generate<VCF | RULE_RENJU> : generate<VCF>)(board, endMove);
+        endMove = generate<VCFType>(board, endMove);
 
         if (useNormalizedPolicy) {
             scoreAllMoves<ScoreType(BALANCED | POLICY)>();
@@ -454,7 +494,7 @@ top:
         stage = ALLMOVES;
         [[fallthrough]];
 
-    case ALLMOVES: return pickNextMove<Next>([]() { return true; });
+    case ALLMOVES: return pickNextMove<R, Next>([]() { return true; });
     }
 
     // This should never be reached, unless a bug occurs
@@ -462,4 +502,8 @@ top:
     return Pos::NONE;
 }
 
+template Pos MovePicker::next<FREESTYLE>();
+template Pos MovePicker::next<STANDARD>();
+template Pos MovePicker::next<RENJU>();
+
 }  // namespace Search
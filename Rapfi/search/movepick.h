@@ -20,6 +20,7 @@
 
 #include "../game/movegen.h"
 #include "history.h"
+#include "nodecache.h"
 
 namespace Search {
 
@@ -47,6 +48,12 @@ public:
 
     /// Gets the next move in the sorted move list.
     [[nodiscard]] Pos operator()();
+    /// Gets the next move in the sorted move list, with the rule known at compile
+    /// time. This is the version used in rule-templated search hot loops, where
+    /// move generation and forbidden point checks need no runtime rule dispatch.
+    /// @tparam R Must be the same rule as the one passed to the constructor.
+    template <Rule R>
+    [[nodiscard]] Pos next();
 
     /// Whether this movepicker has policy score from the evaluator.
     bool hasPolicyScore() const { return hasPolicy; }
@@ -76,7 +83,7 @@ private:
         COUNTER_MOVE = 0b10000,
     };
 
-    template <PickType T, typename Pred>
+    template <Rule R, PickType T, typename Pred>
     Pos pickNextMove(Pred);
     template <ScoreType T>
     void        scoreAllMoves();
@@ -86,6 +93,7 @@ private:
     const Board              &board;
     const MainHistory        *mainHistory;
     const CounterMoveHistory *counterMoveHistory;
+    NodeCache                *nodeCache;
     int8_t                    stage;
     Rule                      rule;
     Pos                       ttMove;
@@ -115,6 +123,7 @@ struct MovePicker::ExtraArgs<MovePicker::MAIN>
     CounterMoveHistory *counterMoveHistory;
     bool                useNormalizedPolicy  = false;
     float               normalizedPolicyTemp = 1.0f;
+    NodeCache          *nodeCache            = nullptr;  // Reuses evaluator policy if set
 };
 
 template <>
@@ -0,0 +1,124 @@
+/*
+ *  Rapfi, a Gomoku/Renju playing engine supporting piskvork protocol.
+ *  Copyright (C) 2022  Rapfi developers
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../core/pos.h"
+#include "../core/types.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace Search {
+
+/// NodeCache is a small per-thread cache of evaluator results (static value and policy
+/// scores of the move list) keyed by position hash. It lives for one search, so nodes
+/// revisited by aspiration re-searches and later iterations can skip the evaluator even
+/// after their TT entries have been replaced. It is disabled (all probes miss) until it
+/// is initialized with a board size.
+class NodeCache
+{
+public:
+    /// Number of cached static values (power of two).
+    static constexpr size_t NumValueEntries = 1 << 14;
+    /// Number of cached policy arrays (power of two).
+    static constexpr size_t NumPolicyEntries = 1 << 10;
+
+    /// Resize the cache for the board size and clear all entries.
+    /// @param boardSize Size of the board, or 0 to disable the cache.
+    void init(int boardSize)
+    {
+        size_t cells = size_t(boardSize) * boardSize;
+        if (boardSize != this->boardSize) {
+            this->boardSize = boardSize;
+            valueTable.assign(boardSize ? NumValueEntries : 0, ValueEntry {});
+            policyKeys.assign(boardSize ? NumPolicyEntries : 0, 0);
+            policyTable.assign(boardSize ? NumPolicyEntries * cells : 0, Score {});
+        }
+        else {
+            std::fill(valueTable.begin(), valueTable.end(), ValueEntry {});
+            std::fill(policyKeys.begin(), policyKeys.end(), 0);
+        }
+    }
+
+    /// Whether the cache has been initialized for a board size.
+    bool enabled() const { return boardSize > 0; }
+
+    /// Probe the cached static value of a position.
+    /// @return Whether the value is found.
+    bool probeValue(HashKey key, Value &value) const
+    {
+        if (!enabled())
+            return false;
+        const ValueEntry &entry = valueTable[key & (NumValueEntries - 1)];
+        if (entry.key32 != uint32_t(key >> 32) || entry.value == VALUE_NONE)
+            return false;
+        value = entry.value;
+        return true;
+    }
+
+    /// Store the static value of a position.
+    void storeValue(HashKey key, Value value)
+    {
+        if (!enabled())
+            return;
+        ValueEntry &entry = valueTable[key & (NumValueEntries - 1)];
+        entry.key32       = uint32_t(key >> 32);
+        entry.value       = value;
+    }
+
+    /// Probe the cached policy scores of a position.
+    /// @return Policy score array indexed by policyIndex(), or nullptr if not found.
+    const Score *probePolicy(HashKey key) const
+    {
+        if (!enabled())
+            return nullptr;
+        size_t index = key & (NumPolicyEntries - 1);
+        if (policyKeys[index] != key)
+            return nullptr;
+        return &policyTable[index * boardSize * boardSize];
+    }
+
+    /// Claim the policy entry of a position, which replaces the previous entry.
+    /// @return Policy score array indexed by policyIndex() to be filled by the caller.
+    Score *storePolicy(HashKey key)
+    {
+        assert(enabled());
+        size_t index      = key & (NumPolicyEntries - 1);
+        policyKeys[index] = key;
+        return &policyTable[index * boardSize * boardSize];
+    }
+
+    /// Index of a move in a policy score array.
+    int policyIndex(Pos pos) const { return pos.y() * boardSize + pos.x(); }
+
+private:
+    struct ValueEntry
+    {
+        uint32_t key32 = 0;
+        Value    value = VALUE_NONE;
+    };
+
+    int                     boardSize = 0;
+    std::vector<ValueEntry> valueTable;
+    std::vector<HashKey>    policyKeys;
+    std::vector<Score>      policyTable;
+};
+
+}  // namespace Search
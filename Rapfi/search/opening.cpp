@@ -27,7 +27,6 @@
 #include <iostream>
 #include <numeric>
 #include <random>
-#include <unordered_map>
 #include <vector>
 
 namespace {
@@ -249,16 +248,9 @@ bool isBoardSymmetry(const Board &board, TransformType symTrans)
 
 void filterSymmetryMoves(const Board &board, std::vector<Pos> &moveList)
 {
-    std::unordered_map<Pos, size_t> posToIndexMap;
-    std::unordered_map<size_t, Pos> indexToPosMap;
-    size_t                          index = 0;
-    FOR_EVERY_EMPTY_POS(&board, pos)
-    {
-        posToIndexMap[pos]   = index;
-        indexToPosMap[index] = pos;
-        index++;
-    }
-    IndexDisjointSet ds(index);
+    // Empty cells are indexed by their position directly, which keeps the relative order
+    // of indices and saves building a position <-> index map.
+    IndexDisjointSet ds(size_t(board.endPos()) + 1);
 
     for (int i = 0; i < TRANS_NB; i++) {
         TransformType trans = (TransformType)i;
@@ -269,21 +261,42 @@ void filterSymmetryMoves(const Board &board, std::vector<Pos> &moveList)
         FOR_EVERY_EMPTY_POS(&board, pos)
         {
             Pos transformedPos = applyTransform(pos, board.size(), trans);
-            ds.merge(posToIndexMap[pos], posToIndexMap[transformedPos]);
+            ds.merge(pos, transformedPos);
         }
     }
 
     // Remove all redundant symmetry moves (which is not root in ds)
     auto pred = [&](Pos move) -> bool {
-        if (posToIndexMap.find(move) == posToIndexMap.end())
+        if (!board.isInBoard(move) || !board.isEmpty(move))
             return true;
 
-        size_t idx = posToIndexMap[move];
-        return ds.find(idx) != idx;
+        return ds.find(move) != size_t(move);
     };
     moveList.erase(std::remove_if(moveList.begin(), moveList.end(), pred), moveList.end());
 }
 
+std::vector<std::pair<Pos, TransformType>> getSymmetryMoves(const Board &board, Pos move)
+{
+    std::vector<std::pair<Pos, TransformType>> symMoves;
+    if (!board.isInBoard(move) || move == Pos::PASS)
+        return symMoves;
+
+    // Symmetry transforms of the board form a group, so the orbit of the move
+    // under them is exactly its equivalent class in filterSymmetryMoves().
+    for (int i = IDENTITY + 1; i < TRANS_NB; i++) {
+        TransformType trans = (TransformType)i;
+        if (!isBoardSymmetry(board, trans))
+            continue;
+
+        Pos  symMove  = applyTransform(move, board.size(), trans);
+        auto sameMove = [=](const std::pair<Pos, TransformType> &m) { return m.first == symMove; };
+        if (symMove != move && std::none_of(symMoves.begin(), symMoves.end(), sameMove))
+            symMoves.emplace_back(symMove, trans);
+    }
+
+    return symMoves;
+}
+
 /// Create a opening generator, which can be used to generate balanced
 /// opening with the given board size, rule and config.
 /// @param boardSize The size of board to generate openings.
@@ -50,6 +50,11 @@ bool isBoardSymmetry(const Board &board, TransformType symTrans);
 /// Remove redundant symmetry moves from move list.
 void filterSymmetryMoves(const Board &board, std::vector<Pos> &moveList);
 
+/// Get all moves that are symmetry-equivalent to the given move on the board.
+/// @return A list of (equivalent move, transform from the given move to it), not
+///     including the move itself. Empty if the board has no symmetry.
+std::vector<std::pair<Pos, TransformType>> getSymmetryMoves(const Board &board, Pos move);
+
 /// OpeningGenConfig struct contains information on how to generate a opening.
 struct OpeningGenConfig
 {
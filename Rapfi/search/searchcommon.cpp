@@ -19,8 +19,11 @@
 #include "searchcommon.h"
 
 #include "../config.h"
+#include "../core/platform.h"
 #include "../game/board.h"
 
+#include <algorithm>
+
 namespace Search {
 
 bool RootMoveValueComparator::operator()(const RootMove &a, const RootMove &b) const
@@ -35,6 +38,60 @@ bool BalanceMoveValueComparator::operator()(const RootMove &a, const RootMove &b
                : balancedValue(a.previousValue, bias) > balancedValue(b.previousValue, bias);
 }
 
+Balance2MoveIndex::PairTable::PairTable(size_t numCells)
+    : pairIds(numCells * numCells, None)
+    , firstMoveGroup(numCells, None)
+{
+    MemAlloc::trackAlloc(MemAlloc::MemoryTag::OTHER, (numCells + 1) * numCells * sizeof(uint32_t));
+}
+
+Balance2MoveIndex::PairTable::~PairTable()
+{
+    size_t numCells = firstMoveGroup.size();
+    MemAlloc::trackFree(MemAlloc::MemoryTag::OTHER, (numCells + 1) * numCells * sizeof(uint32_t));
+}
+
+void Balance2MoveIndex::init(int boardSize)
+{
+    this->boardSize = boardSize;
+    numGroups_      = 1;
+    pairTable       = std::make_shared<PairTable>(size_t(boardSize) * boardSize);
+    rootMoveIndices.clear();
+}
+
+void Balance2MoveIndex::clear()
+{
+    boardSize       = 0;
+    numGroups_      = 1;
+    pairTable       = nullptr;
+    rootMoveIndices = {};
+}
+
+void Balance2MoveIndex::add(Balance2Move m, uint32_t rootMoveIndex)
+{
+    assert(pairTable.use_count() == 1);
+    pairTable->pairIds[pairIndex(m)] = rootMoveIndices.size();
+    rootMoveIndices.push_back(rootMoveIndex);
+}
+
+void Balance2MoveIndex::partition(const RootMoves &rootMoves, uint32_t maxGroups)
+{
+    assert(pairTable.use_count() == 1);
+    std::vector<uint32_t> &firstMoveGroup = pairTable->firstMoveGroup;
+    std::fill(firstMoveGroup.begin(), firstMoveGroup.end(), None);
+
+    std::vector<Pos> firstMoves;
+    for (const RootMove &rm : rootMoves)
+        if (groupOf(rm.pv[0]) == None) {
+            firstMoveGroup[cellIndex(rm.pv[0])] = 0;
+            firstMoves.push_back(rm.pv[0]);
+        }
+
+    numGroups_ = std::clamp<uint32_t>(maxGroups, 1, std::max<size_t>(firstMoves.size(), 1));
+    for (size_t i = 0; i < firstMoves.size(); i++)
+        firstMoveGroup[cellIndex(firstMoves[i])] = i % numGroups_;
+}
+
 void SearchOptions::setTimeControl(int64_t turnTime, int64_t matchTime)
 {
     if (turnTime <= 0 && matchTime <= 0) {  // Infinite time
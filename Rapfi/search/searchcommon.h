@@ -24,6 +24,8 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <memory>
+#include <utility>
 #include <vector>
 
 class Board;
@@ -62,8 +64,8 @@ struct Balance2Move
 /// before each iteration so that pv are.
 struct RootMove
 {
-    RootMove(Pos pos) : pv(1, pos), previousPv(pv) {}
-    RootMove(Balance2Move m) : pv {m.move1, m.move2}, previousPv(pv) {}
+    RootMove(Pos pos) : pv(1, pos) {}
+    RootMove(Balance2Move m) : pv {m.move1, m.move2} {}
     bool operator==(const Pos &m) const { return pv[0] == m; }
     bool operator==(const Balance2Move &m) const
     {
@@ -82,11 +84,85 @@ struct RootMove
     float    selectionValue = std::numeric_limits<float>::quiet_NaN();
     uint64_t numNodes       = 0;
 
+    /// PV of the current and last iteration. previousPv is empty before the first
+    /// iteration starts.
     std::vector<Pos> pv, previousPv;
+    /// Symmetry-equivalent moves represented by this move, and the transforms from this
+    /// move to them. Only filled when symmetry moves are collapsed at root.
+    std::vector<std::pair<Pos, TransformType>> symmetryMoves;
 };
 
 using RootMoves = std::vector<RootMove>;
 
+/// Balance2MoveIndex maps a balance2 move pair to its index in the root move list.
+/// A flat table over all cell pairs of the board maps each root pair to a pair id.
+/// The table is built once by the main thread and shared read-only by the copies in
+/// all threads. Each copy only owns the small pair id -> root move index list, as
+/// every thread sorts its own root moves. It also partitions the first moves of the
+/// root pairs into groups, so that each thread group only needs to search the pairs
+/// starting with the first moves in its own group.
+class Balance2MoveIndex
+{
+public:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    /// Reset to an empty index for the given board size.
+    void init(int boardSize);
+    /// Release all memory of the index.
+    void clear();
+    /// Add a move pair with its root move index. Pairs can only be added before the
+    /// index is copied to other threads.
+    void add(Balance2Move m, uint32_t rootMoveIndex);
+    /// Set the root move index of a move pair, which must have been added.
+    void set(Balance2Move m, uint32_t rootMoveIndex)
+    {
+        assert(pairTable && pairTable->pairIds[pairIndex(m)] != None);
+        rootMoveIndices[pairTable->pairIds[pairIndex(m)]] = rootMoveIndex;
+    }
+    /// Get the root move index of a move pair, or None if it is not in root moves.
+    uint32_t operator[](Balance2Move m) const
+    {
+        if (!isIndexable(m.move1) || !isIndexable(m.move2))
+            return None;
+        uint32_t pairId = pairTable->pairIds[pairIndex(m)];
+        return pairId == None ? None : rootMoveIndices[pairId];
+    }
+
+    /// Partition the first moves of all root move pairs into at most maxGroups groups
+    /// in a round-robin way over their first appearance in the root move list.
+    void partition(const RootMoves &rootMoves, uint32_t maxGroups);
+    /// Number of groups that first moves are partitioned into.
+    uint32_t numGroups() const { return numGroups_; }
+    /// Get the group of a first move, or None if no root move pair starts with it.
+    uint32_t groupOf(Pos firstMove) const
+    {
+        return isIndexable(firstMove) ? pairTable->firstMoveGroup[cellIndex(firstMove)] : None;
+    }
+
+private:
+    /// Tables shared by all copies of the index, which are read-only once copied.
+    struct PairTable
+    {
+        std::vector<uint32_t> pairIds;         // [numCells * numCells]
+        std::vector<uint32_t> firstMoveGroup;  // [numCells]
+
+        explicit PairTable(size_t numCells);
+        ~PairTable();
+    };
+
+    int                        boardSize  = 0;
+    uint32_t                   numGroups_ = 1;
+    std::shared_ptr<PairTable> pairTable;
+    std::vector<uint32_t>      rootMoveIndices;  // [numPairs]
+
+    bool isIndexable(Pos p) const { return boardSize && p.isInBoard(boardSize, boardSize); }
+    size_t cellIndex(Pos p) const { return size_t(p.y()) * boardSize + p.x(); }
+    size_t pairIndex(Balance2Move m) const
+    {
+        return cellIndex(m.move1) * boardSize * boardSize + cellIndex(m.move2);
+    }
+};
+
 /// RootMoveValueComparator compares two root moves according to their value, and
 /// sorts them in descending order.
 struct RootMoveValueComparator
@@ -138,6 +214,9 @@ struct SearchOptions
 
     /// MultiPV mode, normally set to 1
     uint16_t multiPV = 1;
+    /// Search one representative for each class of symmetry-equivalent root moves,
+    /// and report its result for all equivalent moves (counted towards multiPV).
+    bool collapseSymmetryMoves = false;
     /// Playing strength control (0~100, 100 for maximum strength level)
     uint16_t strengthLevel = 100;
     /// Balance mode (default is BALANCE_NONE)
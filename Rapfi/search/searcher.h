@@ -25,6 +25,7 @@ namespace Search {
 class SearchThread;       // forward declaration
 class MainSearchThread;  // forward declaration
 class ThreadPool;         // forward declaration
+class TimeControl;        // forward declaration
 
 struct SearchData
 {
@@ -49,6 +50,8 @@ public:
     /// Get the current memory size limit of the search.
     /// @return Maximum memory size in KiB.
     virtual size_t getMemoryLimit() const = 0;
+    /// Whether setMemoryLimit() actually changes the memory used by this searcher.
+    virtual bool hasMemoryLimit() const { return true; }
 
     /// Clear all searcher states between different games.
     /// @param pool The thread pool that holds all the search threads.
@@ -65,6 +68,10 @@ public:
     /// Checks if a search reaches timeup condition.
     /// @return True if time is up, otherwise false.
     virtual bool checkTimeupCondition() = 0;
+
+    /// Get the time controller of this searcher, which holds the time record of the
+    /// last search. Returns nullptr if the searcher has no time management.
+    virtual const TimeControl *timeControl() const { return nullptr; }
 };
 
 }  // namespace Search
@@ -30,6 +30,32 @@
 
 #define INFO(type, ...) sync_cout() << "INFO " << type << ' ' << __VA_ARGS__ << std::endl
 
+namespace {
+
+/// Transform a PV line into the line of one of its symmetry-equivalent root moves.
+std::vector<Pos> transformPv(const std::vector<Pos> &pv, int boardSize, TransformType trans)
+{
+    std::vector<Pos> symPv;
+    symPv.reserve(pv.size());
+    for (Pos move : pv)
+        symPv.push_back(move == Pos::PASS || move == Pos::NONE
+                            ? move
+                            : applyTransform(move, boardSize, trans));
+    return symPv;
+}
+
+/// Returns the number of PV lines of the first numPv root moves after expanding each of
+/// them back to all its symmetry-equivalent moves.
+size_t numExpandedPv(const std::vector<Search::RootMove> &rootMoves, size_t numPv)
+{
+    size_t numExpanded = 0;
+    for (size_t i = 0; i < numPv && i < rootMoves.size(); i++)
+        numExpanded += 1 + rootMoves[i].symmetryMoves.size();
+    return numExpanded;
+}
+
+}  // namespace
+
 namespace Search {
 
 void SearchPrinter::printSearchStarts(MainSearchThread &th, const TimeControl &tc)
@@ -99,39 +125,64 @@ void SearchPrinter::printPvCompletes(MainSearchThread  &th,
                                      int                pvIdx,
                                      int                numPv)
 {
-    // Do not print search messages in ponder mode
-    if (th.inPonder.load(std::memory_order_relaxed))
+    // Do not print search messages in ponder mode, or with only part of the root moves
+    if (th.inPonder.load(std::memory_order_relaxed) || partialRootMoves(th))
         return;
 
     uint64_t nodes = th.threads.nodesSearched();
     uint64_t speed = nodes * 1000 / std::max(tc.elapsed(), (Time)1);
     if (!th.threads.isTerminating()) {
+        // Collapsed symmetry moves are reported as lines of their own, so the multi-PV
+        // output is chosen by the requested number of lines instead of the searched ones
         RootMove &curMove = th.rootMoves[pvIdx];
+        bool      multiPv = th.options().multiPV > 1;
 
         if (showInfo(th)) {
-            INFO("PV", pvIdx);
-            INFO("NUMPV", numPv);
-            INFO("DEPTH", rootDepth);
-            INFO("SELDEPTH", curMove.selDepth);
-            INFO("NODES", curMove.numNodes);
-            INFO("TOTALNODES", nodes);
-            INFO("TOTALTIME", tc.elapsed());
-            INFO("SPEED", speed);
-            INFO("EVAL", curMove.value);
-            INFO("WINRATE", Config::valueToWinRate(curMove.value));
-            INFO("BESTLINE", MovesText {curMove.pv, true, true, th.board->size()});
-            INFO("PV", "DONE");
+            // Each PV line is followed by the lines of its symmetry-equivalent moves
+            size_t expandedPvIdx = numExpandedPv(th.rootMoves, pvIdx);
+            size_t expandedNumPv = numExpandedPv(th.rootMoves, numPv);
+            for (size_t i = 0; i <= curMove.symmetryMoves.size(); i++) {
+                auto pv = i == 0 ? curMove.pv
+                                 : transformPv(curMove.pv,
+                                               th.board->size(),
+                                               curMove.symmetryMoves[i - 1].second);
+                INFO("PV", expandedPvIdx + i);
+                INFO("NUMPV", expandedNumPv);
+                INFO("DEPTH", rootDepth);
+                INFO("SELDEPTH", curMove.selDepth);
+                INFO("NODES", curMove.numNodes);
+                INFO("TOTALNODES", nodes);
+                INFO("TOTALTIME", tc.elapsed());
+                INFO("SPEED", speed);
+                INFO("EVAL", curMove.value);
+                INFO("WINRATE", Config::valueToWinRate(curMove.value));
+                INFO("BESTLINE", MovesText {pv, true, true, th.board->size()});
+                INFO("PV", "DONE");
+            }
         }
 
-        if (numPv > 1 && Config::MessageMode == MsgMode::NORMAL)
+        if (multiPv && Config::MessageMode == MsgMode::NORMAL) {
             MESSAGEL("(" << pvIdx + 1 << ") " << curMove.value << " | " << rootDepth << "-"
                          << curMove.selDepth << " | " << MovesText {curMove.pv});
+            for (auto [move, trans] : curMove.symmetryMoves) {
+                auto symPv = transformPv(curMove.pv, th.board->size(), trans);
+                MESSAGEL("(" << pvIdx + 1 << "=) " << curMove.value << " | " << rootDepth << "-"
+                             << curMove.selDepth << " | " << MovesText {symPv});
+            }
+        }
         else if (Config::MessageMode == MsgMode::UCILIKE) {
-            if (numPv > 1)
+            if (multiPv) {
                 MESSAGEL("depth " << rootDepth << "-" << curMove.selDepth << " multipv "
                                   << pvIdx + 1 << " ev " << curMove.value << " n "
                                   << nodesText(nodes) << " n/ms " << (speed / 1000) << " tm "
                                   << tc.elapsed() << " pv " << MovesText {curMove.pv});
+                for (auto [move, trans] : curMove.symmetryMoves) {
+                    auto symPv = transformPv(curMove.pv, th.board->size(), trans);
+                    MESSAGEL("depth " << rootDepth << "-" << curMove.selDepth << " multipv "
+                                      << pvIdx + 1 << " symmetry ev " << curMove.value << " pv "
+                                      << MovesText {symPv});
+                }
+            }
             else
                 MESSAGEL("depth " << rootDepth << "-" << curMove.selDepth << " ev " << curMove.value
                                   << " n " << nodesText(nodes) << " n/ms " << (speed / 1000)
@@ -147,7 +198,7 @@ void SearchPrinter::printPvCompletes(MainSearchThread  &th,
 
 void SearchPrinter::printDepthCompletes(MainSearchThread &th, const TimeControl &tc, int rootDepth)
 {
-    if (Config::MessageMode == MsgMode::NORMAL) {
+    if (Config::MessageMode == MsgMode::NORMAL && !partialRootMoves(th)) {
         bool showPonder = th.inPonder.load(std::memory_order_relaxed);
 
         MESSAGEL((showPonder ? "[Pondering] " : "")
@@ -169,25 +220,34 @@ void SearchPrinter::printRootMoves(MainSearchThread  &th,
     uint64_t speed = nodes * 1000 / std::max(tc.elapsed(), (Time)1);
 
     numRootMovesToDisplay = std::min(numRootMovesToDisplay, th.rootMoves.size());
+    size_t expandedNumPv  = numExpandedPv(th.rootMoves, numRootMovesToDisplay);
+    size_t expandedPvIdx  = 0;
     for (size_t pvIdx = 0; pvIdx < numRootMovesToDisplay; pvIdx++) {
         RootMove &curMove = th.rootMoves[pvIdx];
 
         if (showInfo(th)) {
-            INFO("PV", pvIdx);
-            INFO("NUMPV", numRootMovesToDisplay);
-            INFO("SELDEPTH", curMove.selDepth);
-            INFO("NODES", curMove.numNodes);
-            INFO("TOTALNODES", nodes);
-            INFO("TOTALTIME", tc.elapsed());
-            INFO("SPEED", speed);
-            INFO("EVAL", curMove.value);
-            INFO("WINRATE", curMove.winRate);
-            INFO("DRAWRATE", curMove.drawRate);
-            INFO("PRIOR", curMove.policyPrior);
-            INFO("STDEV", curMove.utilityStdev);
-            INFO("LCBVALUE", curMove.lcbValue);
-            INFO("BESTLINE", MovesText {curMove.pv, true, true, th.board->size()});
-            INFO("PV", "DONE");
+            // Each PV line is followed by the lines of its symmetry-equivalent moves
+            for (size_t i = 0; i <= curMove.symmetryMoves.size(); i++, expandedPvIdx++) {
+                auto pv = i == 0 ? curMove.pv
+                                 : transformPv(curMove.pv,
+                                               th.board->size(),
+                                               curMove.symmetryMoves[i - 1].second);
+                INFO("PV", expandedPvIdx);
+                INFO("NUMPV", expandedNumPv);
+                INFO("SELDEPTH", curMove.selDepth);
+                INFO("NODES", curMove.numNodes);
+                INFO("TOTALNODES", nodes);
+                INFO("TOTALTIME", tc.elapsed());
+                INFO("SPEED", speed);
+                INFO("EVAL", curMove.value);
+                INFO("WINRATE", curMove.winRate);
+                INFO("DRAWRATE", curMove.drawRate);
+                INFO("PRIOR", curMove.policyPrior);
+                INFO("STDEV", curMove.utilityStdev);
+                INFO("LCBVALUE", curMove.lcbValue);
+                INFO("BESTLINE", MovesText {pv, true, true, th.board->size()});
+                INFO("PV", "DONE");
+            }
         }
 
         std::ios oldState(nullptr);
@@ -199,6 +259,12 @@ void SearchPrinter::printRootMoves(MainSearchThread  &th,
                          << ", D " << (curMove.drawRate * 100) << ", S " << curMove.utilityStdev
                          << ") | V " << nodesText(curMove.numNodes) << " | SD " << curMove.selDepth
                          << " | " << MovesText {curMove.pv});
+            for (auto [move, trans] : curMove.symmetryMoves) {
+                auto symPv = transformPv(curMove.pv, th.board->size(), trans);
+                MESSAGEL("(" << pvIdx + 1 << "=) " << curMove.value << " (W "
+                             << (curMove.winRate * 100) << ", D " << (curMove.drawRate * 100)
+                             << ") | SD " << curMove.selDepth << " | " << MovesText {symPv});
+            }
         }
         else if (Config::MessageMode == MsgMode::UCILIKE) {
             MESSAGEL("multipv " << pvIdx + 1 << " ev " << curMove.value << " w "
@@ -208,6 +274,12 @@ void SearchPrinter::printRootMoves(MainSearchThread  &th,
                                 << " n " << nodesText(nodes) << " n/ms " << (speed / 1000) << " tm "
                                 << tc.elapsed() << " prior " << curMove.policyPrior << " pv "
                                 << MovesText {curMove.pv});
+            for (auto [move, trans] : curMove.symmetryMoves) {
+                auto symPv = transformPv(curMove.pv, th.board->size(), trans);
+                MESSAGEL("multipv " << pvIdx + 1 << " symmetry ev " << curMove.value << " w "
+                                    << (curMove.winRate * 100) << " d "
+                                    << (curMove.drawRate * 100) << " pv " << MovesText {symPv});
+            }
         }
 
         std::cout.copyfmt(oldState);
@@ -235,7 +307,7 @@ void SearchPrinter::printSearchEnds(MainSearchThread  &th,
                  << " | Node " << nodesText(nodes) << " | Time " << timeText(tc.elapsed()));
 
         // Outputs full PV if not shown before
-        if (Config::MessageMode == MsgMode::BRIEF || &bestThread != &th) {
+        if (Config::MessageMode == MsgMode::BRIEF || &bestThread != &th || partialRootMoves(th)) {
             // Select a longer PV for final output
             if (bestThread.rootMoves[0].pv.size() <= 2
                 && bestThread.rootMoves[0].previousPv.size() > 2)
@@ -246,6 +318,45 @@ void SearchPrinter::printSearchEnds(MainSearchThread  &th,
     }
 }
 
+void SearchPrinter::printBalance2Result(MainSearchThread  &th,
+                                        const TimeControl &tc,
+                                        int                rootDepth,
+                                        uint64_t           numPairs,
+                                        uint32_t           numGroups)
+{
+    // The best line of the merged pair has not been reported during search
+    if (partialRootMoves(th) && !th.inPonder.load(std::memory_order_relaxed)) {
+        RootMove &bestMove = th.rootMoves[0];
+
+        if (showInfo(th)) {
+            uint64_t nodes = th.threads.nodesSearched();
+            INFO("PV", 0);
+            INFO("NUMPV", 1);
+            INFO("DEPTH", rootDepth);
+            INFO("SELDEPTH", bestMove.selDepth);
+            INFO("NODES", bestMove.numNodes);
+            INFO("TOTALNODES", nodes);
+            INFO("TOTALTIME", tc.elapsed());
+            INFO("SPEED", nodes * 1000 / std::max(tc.elapsed(), (Time)1));
+            INFO("EVAL", bestMove.value);
+            INFO("WINRATE", Config::valueToWinRate(bestMove.value));
+            INFO("BESTLINE", MovesText {bestMove.pv, true, true, th.board->size()});
+            INFO("PV", "DONE");
+        }
+
+        if (showRealtime(th, tc, rootDepth)) {
+            MESSAGEL("REALTIME REFRESH");
+            REALTIME("BEST", bestMove.pv[0], th.board->size());
+        }
+    }
+
+    if (Config::MessageMode == MsgMode::NORMAL || Config::MessageMode == MsgMode::BRIEF) {
+        uint64_t pairSpeed = numPairs * 1000 / std::max(tc.elapsed(), (Time)1);
+        MESSAGEL("Balance2 Pairs " << nodesText(numPairs) << " | Pairs/s "
+                                   << nodesText(pairSpeed) << " | Thread Groups " << numGroups);
+    }
+}
+
 void SearchPrinter::printBestmoveWithoutSearch(MainSearchThread &th,
                                                Pos               bestMove,
                                                Value             moveValue,
@@ -295,4 +406,10 @@ bool SearchPrinter::showInfo(MainSearchThread &th)
     return th.options().infoMode & SearchOptions::INFO_DETAIL;
 }
 
+bool SearchPrinter::partialRootMoves(MainSearchThread &th)
+{
+    return th.options().balanceMode == SearchOptions::BALANCE_TWO
+           && th.balance2Moves.numGroups() > 1;
+}
+
 }  // namespace Search
@@ -77,6 +77,13 @@ struct SearchPrinter
                          const TimeControl &tc,
                          int                rootDepth,
                          SearchThread      &bestThread);
+    /// Print the merged best pair and statistics of move pairs searched in balance2 mode.
+    /// @param rootDepth The completed depth of the thread that found the best pair.
+    void printBalance2Result(MainSearchThread  &th,
+                             const TimeControl &tc,
+                             int                rootDepth,
+                             uint64_t           numPairs,
+                             uint32_t           numGroups);
     /// Print when search is not needed to choose a bestmove.
     /// @param bestMove The best move to print.
     /// @param moveValue The theoretical value of this best move.
@@ -95,6 +102,10 @@ private:
     bool showRealtimeInLoop(MainSearchThread &th, const TimeControl &tc, int rootDepth);
     /// @brief Checks should we output info.
     bool showInfo(MainSearchThread &th);
+    /// Checks if the main thread only searches part of the root moves. This happens when
+    /// balance2 first moves are partitioned to several thread groups, in which case the
+    /// best lines of the main thread are not reported until the groups are merged.
+    bool partialRootMoves(MainSearchThread &th);
 
     static constexpr int REALTIME_MIN_DEPTH   = 8;
     static constexpr int REALTIME_MIN_ELAPSED = 200;
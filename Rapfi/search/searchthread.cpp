@@ -21,12 +21,12 @@
 #include "../core/iohelper.h"
 #include "../core/platform.h"
 #include "../game/board.h"
+#include "hashtable.h"
 #include "movepick.h"
 #include "opening.h"
 #include "searcher.h"
 
 #include <algorithm>
-#include <unordered_set>
 
 namespace Search {
 
@@ -37,6 +37,7 @@ SearchThread::SearchThread(ThreadPool &threadPool, uint32_t id)
     : numaId(Numa::DefaultNumaNodeId)
     , running(false)
     , exit(false)
+    , boardRule(FREESTYLE)
     , id(id)
     , threads(threadPool)
 {}
@@ -48,19 +49,22 @@ void SearchThread::init(bool bindGroup)
 #endif
 
     runTask([bindGroup](SearchThread &th) {
-        // Create search data for this thread
-        th.searchData = th.threads.searcher()->makeSearchData(th);
-
         // Set thread affinity to a specific group if needed
         if (bindGroup) {
             // If OS already scheduled us on a different group than 0 then don't overwrite
             // the choice, eventually we are one of many one-threaded processes running on
             // some Windows NUMA hardware, for instance in fishtest. To make it simple,
-            // just check if running threads are below a threshold, in this case all this
-            // NUMA machinery is not needed. We also store this thread's numa ID for the
-            // later NUMA-aware loading of evaluator weights.
+            // the default NUMA policy just checks if running threads are below a threshold,
+            // in this case all this NUMA machinery is not needed. We also store this
+            // thread's numa ID for the later NUMA-aware loading of evaluator weights and
+            // node-local TT probing.
             th.numaId = Numa::bindThisThread(th.id);
+            HashTable::setThreadNumaNode(th.numaId);
         }
+
+        // Create search data for this thread, after binding so that it is allocated on
+        // the NUMA node of this thread and the searcher can group threads by node
+        th.searchData = th.threads.searcher()->makeSearchData(th);
     });
 }
 
@@ -143,6 +147,7 @@ void SearchThread::clear()
         searchData->clearData(*this);
     rootMoves.clear();
     balance2Moves.clear();
+    arena.reset();
     numNodes = 0;
     selDepth = 0;
 
@@ -167,26 +172,29 @@ void MainSearchThread::clear()
 
 void SearchThread::setBoardAndEvaluator(const Board &board)
 {
-    // Reset board instance in this thread to be null
-    this->board.reset();
-
-    // Setup evaluator in this thread
-    if (!threads.evaluatorMaker)
+    const int  boardSize = board.size();
+    const Rule rule      = threads.main()->searchOptions.rule;
+
+    // Clear loaded evaluator that does not match, together with the board using it
+    bool evaluatorMatch = threads.evaluatorMaker ? evaluator && evaluator->boardSize == boardSize
+                                                       && evaluator->rule == rule
+                                                 : !evaluator;
+    if (!evaluatorMatch) {
+        this->board.reset();
         evaluator.reset();
-    else {
-        const int  boardSize = board.size();
-        const Rule rule      = threads.main()->searchOptions.rule;
-
-        // Clear loaded evaluator that does not match
-        if (evaluator && (evaluator->boardSize != boardSize || evaluator->rule != rule))
-            evaluator.reset();
-
-        if (!evaluator)
+        if (threads.evaluatorMaker)
             evaluator = threads.evaluatorMaker(boardSize, rule, numaId);
     }
 
+    // Successive roots usually differ by a few moves, so we sync the board of the last
+    // search by the differing moves, if it is cheaper than replaying all moves.
+    if (this->board && boardRule == rule && this->board->syncTo(rule, board, board.ply()))
+        return;
+
     // Clone the board (this will also sync the evaluator to the board state)
+    this->board.reset();
     this->board = std::make_unique<Board>(board, this);
+    boardRule   = rule;
 }
 
 void MainSearchThread::checkExit(uint32_t elapsedCalls)
@@ -258,7 +266,7 @@ void ThreadPool::setNumThreads(size_t numThreads)
 
     // Create requested amount of threads
     if (numThreads > 0) {
-        bool bindGroup = numThreads > Numa::BindGroupThreshold;
+        bool bindGroup = Numa::needBindThreads(numThreads);
 
         // Make sure the first thread created is MainSearchThread
         push_back(std::make_unique<MainSearchThread>(*this));
@@ -340,7 +348,21 @@ void ThreadPool::startThinking(const Board          &board,
     // Expand board candidate if needed
     Opening::expandCandidate(*main()->board);
 
-    auto addMoveToRootMoves = [this](Pos m) {
+    // Scratch tables of this function are allocated from the (just reset) main thread arena
+    ArenaAllocator<bool> arenaAlloc(main()->arena);
+
+    // Candidates before the first move, which balance2 second moves are chosen from
+    ArenaVector<bool> isFirstCand(arenaAlloc);
+    if (options.balanceMode == Search::SearchOptions::BALANCE_TWO) {
+        main()->balance2Moves.init(main()->board->size());
+        isFirstCand.resize(FULL_BOARD_CELL_COUNT, false);
+        FOR_EVERY_CAND_POS(main()->board, pos)
+        {
+            isFirstCand[pos] = true;
+        }
+    }
+
+    auto addMoveToRootMoves = [this, &isFirstCand](Pos m) {
         // Ignore blocked moves
         if (std::count(main()->searchOptions.blockMoves.begin(),
                        main()->searchOptions.blockMoves.end(),
@@ -348,22 +370,16 @@ void ThreadPool::startThinking(const Board          &board,
             return;
 
         if (main()->searchOptions.balanceMode == Search::SearchOptions::BALANCE_TWO) {
-            // Use candidates before first move
-            std::unordered_set<Pos> cands;
-            FOR_EVERY_CAND_POS(main()->board, pos)
-            {
-                cands.insert(pos);
-            }
             main()->board->move(main()->searchOptions.rule, m);
             // Generate second move for balance2
             MovePicker movePicker2(main()->searchOptions.rule,
                                    *main()->board,
                                    MovePicker::ExtraArgs<MovePicker::ROOT> {});
             while (Pos m2 = movePicker2()) {
-                if (cands.find(m2) != cands.end()) {
+                if (isFirstCand[m2]) {
                     Search::Balance2Move bm {m, m2};
                     main()->rootMoves.emplace_back(bm);
-                    main()->balance2Moves[bm] = main()->rootMoves.size() - 1;
+                    main()->balance2Moves.add(bm, main()->rootMoves.size() - 1);
                 }
             }
             main()->board->undo(main()->searchOptions.rule);
@@ -381,10 +397,10 @@ void ThreadPool::startThinking(const Board          &board,
 
     // If all legal moves are blocked, we select all candidate moves as root moves
     if (main()->rootMoves.empty() && options.blockMoves.size() > 0) {
-        std::unordered_set<Pos> cands;
+        ArenaVector<Pos> cands(arenaAlloc);
         FOR_EVERY_CAND_POS(main()->board, pos)
         {
-            cands.insert(pos);
+            cands.push_back(pos);
         }
 
         for (const auto &m : cands) {
@@ -393,10 +409,14 @@ void ThreadPool::startThinking(const Board          &board,
     }
 
     // Filter root moves with symmetry (not for balance two)
-    if (options.balanceMode != Search::SearchOptions::BALANCE_TWO) {
-        std::vector<Pos> rootMoveList;
+    if (options.balanceMode != Search::SearchOptions::BALANCE_TWO
+        && (Config::FilterSymmetryRootMoves || options.collapseSymmetryMoves)) {
+        std::vector<Pos>  rootMoveList;
+        ArenaVector<bool> isRootMove(FULL_BOARD_CELL_COUNT, false, arenaAlloc);
+        rootMoveList.reserve(main()->rootMoves.size());
         for (const auto &rm : main()->rootMoves) {
             rootMoveList.push_back(rm.pv[0]);
+            isRootMove[rm.pv[0]] = true;
         }
 
         Opening::filterSymmetryMoves(*main()->board, rootMoveList);
@@ -410,9 +430,22 @@ void ThreadPool::startThinking(const Board          &board,
             main()->rootMoves.erase(
                 std::remove_if(main()->rootMoves.begin(), main()->rootMoves.end(), pred),
                 main()->rootMoves.end());
+
+            // Record the removed equivalent moves that each remaining move stands for
+            if (options.collapseSymmetryMoves) {
+                for (auto &rm : main()->rootMoves) {
+                    for (auto [move, trans] : Opening::getSymmetryMoves(*main()->board, rm.pv[0]))
+                        if (isRootMove[move])
+                            rm.symmetryMoves.emplace_back(move, trans);
+                }
+            }
         }
     }
 
+    // Partition first moves of balance2 pairs, so that each thread searches its own part
+    if (options.balanceMode == Search::SearchOptions::BALANCE_TWO)
+        main()->balance2Moves.partition(main()->rootMoves, size());
+
     // Launch a small task to clear threads state and copy state from main thread
     main()->runCustomTaskAndWait(
         [mainTh = main()](SearchThread &th) {
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "../core/arena.h"
 #include "../core/platform.h"
 #include "../database/dbclient.h"
 #include "../database/dbstorage.h"
@@ -55,6 +56,7 @@ private:
     friend class ThreadPool;
     Numa::NumaNodeId numaId;
     bool             running, exit;
+    Rule             boardRule;  // Rule that the moves on board are made with
 
 #ifdef MULTI_THREADING
     std::function<void(SearchThread &)> taskFunc;
@@ -76,7 +78,8 @@ public:
     virtual ~SearchThread();
     /// Clear the thread state between two search.
     virtual void clear();
-    /// Setup the board instance in this thread, and update the evaluator.
+    /// Setup the board instance in this thread, and update the evaluator. The board of
+    /// the last search is reused if it can be synced to the new board incrementally.
     virtual void setBoardAndEvaluator(const Board &board);
     /// Return if this thread is the main thread.
     bool isMainThread() const { return id == 0; }
@@ -91,6 +94,8 @@ public:
 
     /// Get the shared search options.
     SearchOptions &options() const;
+    /// Get the NUMA node this thread is bound to.
+    Numa::NumaNodeId numaNodeId() const { return numaId; }
 
 public:
     /// The ID of this search thread.
@@ -115,7 +120,11 @@ public:
     RootMoves rootMoves;
 
     /// Balance2 move -> root move index lookup table
-    std::unordered_map<Balance2Move, size_t, Balance2Move::Hash> balance2Moves;
+    Balance2MoveIndex balance2Moves;
+
+    /// Arena for transient allocations during one search, reset when the thread is cleared
+    /// for the next search. Containers allocated from it must not outlive the search.
+    MonotonicArena arena;
 
     // Common thread-related statistics
     // ----------------------------------------------------
@@ -231,6 +240,9 @@ public:
     bool                 isTerminating() const { return terminate.load(std::memory_order_relaxed); }
     uint64_t             nodesSearched() const { return sum(&SearchThread::numNodes); }
 
+    /// Returns the evaluator maker, so that another thread pool can share the same evaluator.
+    std::function<EvaluatorMaker> evaluatorMakerFunc() const { return evaluatorMaker; }
+
     ThreadPool();
     ~ThreadPool();
 };
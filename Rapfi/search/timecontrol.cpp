@@ -24,6 +24,8 @@
 #include <cassert>
 #include <cfloat>
 #include <cmath>
+#include <istream>
+#include <ostream>
 
 namespace {
 
@@ -74,13 +76,22 @@ void TimeControl::init(Time turnTime, Time matchTime, Time matchTimeLeft, MovePa
     }
 
     assert(optimum() <= maximum());
+
+    moveRecord.turnTime      = turnTime;
+    moveRecord.matchTime     = matchTime;
+    moveRecord.matchTimeLeft = matchTime ? matchTimeLeft : 0;
+    moveRecord.moveParams    = params;
+    moveRecord.optimum       = optimumTime;
+    moveRecord.maximum       = maximumTime;
+    moveRecord.used          = 0;
+    moveRecord.iterations.clear();
 }
 
-bool TimeControl::checkStop(IterParams params, float &timeReduction) const
+Time TimeControl::iterationTimeLimit(IterParams params, float &timeReduction) const
 {
     // If given ample match time, just see if we have used all optimum time
     if (ampleMatchTime)
-        return elapsed() >= optimum();
+        return optimum();
 
     // Calculate a optimum turn time scale factor based on bestmove changes,
     // bestmove stability and eval oscillation
@@ -100,9 +111,7 @@ bool TimeControl::checkStop(IterParams params, float &timeReduction) const
     // Calculate tweaked max turn time and optimum turn time
     Time maxTurn  = Time(maximum() / timeDivisor(params.depth));
     Time optiTurn = Time(optimum() * bestMoveInstability * reduction * fallingFactor);
-    Time turnTime = std::min(optiTurn, maxTurn);
-
-    return elapsed() >= turnTime;
+    return std::min(optiTurn, maxTurn);
 }
 
 bool TimeControl::checkStop(PlayoutParams params) const
@@ -110,4 +119,44 @@ bool TimeControl::checkStop(PlayoutParams params) const
     return elapsed() >= optimum();
 }
 
+void TimeControl::recordIteration(IterParams params, Pos bestMove)
+{
+    moveRecord.iterations.push_back({params, elapsed(), bestMove});
+}
+
+std::ostream &operator<<(std::ostream &out, const TimeControl::MoveRecord &record)
+{
+    out << record.turnTime << ' ' << record.matchTime << ' ' << record.matchTimeLeft << ' '
+        << record.moveParams.ply << ' ' << record.moveParams.movesLeft << ' ' << record.optimum
+        << ' ' << record.maximum << ' ' << record.used << ' ' << record.iterations.size();
+    for (const auto &it : record.iterations) {
+        const TimeControl::IterParams &p = it.params;
+        out << ' ' << p.depth << ' ' << p.lastBestMoveChangeDepth << ' ' << int(p.bestValue)
+            << ' ' << int(p.prevBestValue) << ' ' << p.prevTimeReduction << ' '
+            << p.averageBestMoveChanges << ' ' << it.elapsed << ' ' << it.bestMove._pos;
+    }
+    return out;
+}
+
+std::istream &operator>>(std::istream &in, TimeControl::MoveRecord &record)
+{
+    size_t numIterations = 0;
+    in >> record.turnTime >> record.matchTime >> record.matchTimeLeft >> record.moveParams.ply
+        >> record.moveParams.movesLeft >> record.optimum >> record.maximum >> record.used
+        >> numIterations;
+
+    record.iterations.clear();
+    for (size_t i = 0; i < numIterations && in; i++) {
+        TimeControl::MoveRecord::Iteration it;
+        TimeControl::IterParams           &p = it.params;
+        int                                bestValue, prevBestValue;
+        in >> p.depth >> p.lastBestMoveChangeDepth >> bestValue >> prevBestValue
+            >> p.prevTimeReduction >> p.averageBestMoveChanges >> it.elapsed >> it.bestMove._pos;
+        p.bestValue     = Value(bestValue);
+        p.prevBestValue = Value(prevBestValue);
+        record.iterations.push_back(it);
+    }
+    return in;
+}
+
 }  // namespace Search
@@ -18,9 +18,13 @@
 
 #pragma once
 
+#include "../core/pos.h"
 #include "../core/types.h"
 #include "../core/utils.h"
 
+#include <iosfwd>
+#include <vector>
+
 namespace Search {
 
 /// TimeControl class computes the optimal and maximum turn time
@@ -53,6 +57,25 @@ public:
     struct PlayoutParams
     {};
 
+    /// MoveRecord struct records how time was spent in one search, including the time
+    /// limits and the state after each completed iteration. Records can be written to
+    /// a time log and replayed offline to tune time management parameters.
+    struct MoveRecord
+    {
+        struct Iteration
+        {
+            IterParams params;
+            Time       elapsed;   // Time elapsed when this iteration is completed
+            Pos        bestMove;  // Best move after this iteration
+        };
+
+        Time                   turnTime, matchTime, matchTimeLeft;
+        MoveParams             moveParams;
+        Time                   optimum, maximum;
+        Time                   used;  // Total time used by this search
+        std::vector<Iteration> iterations;
+    };
+
     /// Compute the optimal and maximum turn time at the beginning of a search.
     /// @param turnTime Max turn time from search options.
     /// @param matchTime Max match time from search options.
@@ -60,11 +83,20 @@ public:
     /// @param params Parameters from current move to search.
     void init(Time turnTime, Time matchTime, Time matchTimeLeft, MoveParams params);
 
+    /// Compute the elapsed time after which we stop iterating deepening at this depth.
+    /// @param[in] params The time parameters from last iteration.
+    /// @param[out] timeReduction Record how much time is saved in the last move.
+    /// @return Time limit of starting the next iteration.
+    Time iterationTimeLimit(IterParams params, float &timeReduction) const;
+
     /// Check if we need to stop iterating deepening at this depth.
     /// @param[in] params The time parameters from last iteration.
     /// @param[out] timeReduction Record how much time is saved in the last move.
     /// @return True if we should stop the search.
-    bool checkStop(IterParams params, float &timeReduction) const;
+    bool checkStop(IterParams params, float &timeReduction) const
+    {
+        return elapsed() >= iterationTimeLimit(params, timeReduction);
+    }
 
     /// Check if we need to stop iterating deepening at this depth.
     /// @param[in] params The time parameters from last playout.
@@ -75,6 +107,19 @@ public:
     Time maximum() const { return maximumTime; }
     Time elapsed() const { return now() - startTime; }
 
+    /// Clear the record, so that a search returning without iterating leaves it empty.
+    void clearRecord()
+    {
+        moveRecord.used = 0;
+        moveRecord.iterations.clear();
+    }
+    /// Append a completed iteration to the record of the current search.
+    void recordIteration(IterParams params, Pos bestMove);
+    /// Mark the end of current search and record the total time used.
+    void recordSearchEnd() { moveRecord.used = elapsed(); }
+    /// Get the time record of the last search.
+    const MoveRecord &record() const { return moveRecord; }
+
 private:
     Time startTime;
     Time optimumTime;
@@ -83,6 +128,13 @@ private:
     /// Whether the match time is much longer than the turn time that we will never
     /// spend all the match time even if we spend all turn time at each turn.
     bool ampleMatchTime;
+
+    MoveRecord moveRecord;
 };
 
+/// Write a move record as one line of whitespace separated fields.
+std::ostream &operator<<(std::ostream &out, const TimeControl::MoveRecord &record);
+/// Read a move record written by operator<<().
+std::istream &operator>>(std::istream &in, TimeControl::MoveRecord &record);
+
 }  // namespace Search
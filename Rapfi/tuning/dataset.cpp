@@ -570,15 +570,8 @@ public:
         if (nextFileIdx == filenames.size())
             return false;
 
-        std::ifstream fileStream(filenames[nextFileIdx], std::ios::binary);
-        if (!fileStream.is_open())
-            throw std::runtime_error("unable to open file " + filenames[nextFileIdx]);
-
-        // fileStream will be set std::istream::badbit
-        fileStream.exceptions(std::istream::badbit | std::istream::failbit);
-
-        // Open .npz with ZIP
-        Compressor compressor(fileStream, Compressor::Type::ZIP_DEFAULT);
+        // Open .npz with ZIP directly from the file, entries are inflated while reading
+        Compressor compressor(filenames[nextFileIdx], Compressor::Type::ZIP_DEFAULT);
 
         auto openEntryThen = [&](std::string entryName,
                                  bool        (DataSource::*receiver)(std::istream &is)) {
@@ -586,7 +579,7 @@ public:
             if (!is)
                 throw std::runtime_error("unable to open " + entryName + " in file "
                                          + filenames[nextFileIdx]);
-            if (!(this->*receiver)(*is))
+            if (!(this->*receiver)(*is) || is->bad())
                 throw std::runtime_error("incorrect data in " + entryName + " in file "
                                          + filenames[nextFileIdx]);
             compressor.closeStream(*is);
@@ -24,6 +24,7 @@
 #include <cmath>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <string>
 #include <type_traits>
@@ -56,8 +57,9 @@ class TuneMap
     struct EntryBase
     {
         virtual ~EntryBase()                = default;
-        virtual void init()                 = 0;
-        virtual bool read(std::istream &is) = 0;
+        virtual void init()                        = 0;
+        virtual bool read(std::istream &is)        = 0;
+        virtual void write(std::ostream &os) const = 0;
     };
 
     template <typename T>
@@ -124,6 +126,19 @@ class TuneMap
             }
             return false;
         }
+        void write(std::ostream &os) const override
+        {
+            if constexpr (std::is_enum_v<T>)
+                os << static_cast<std::underlying_type_t<T>>(value);
+            else if constexpr (std::is_floating_point_v<T>) {
+                // Write all significant digits, so that reading it back gives the same value
+                auto oldPrecision = os.precision(std::numeric_limits<T>::max_digits10);
+                os << value;
+                os.precision(oldPrecision);
+            }
+            else
+                os << value;
+        }
 
         std::string    name;
         T             &value;
@@ -187,6 +202,17 @@ public:
         }
         return false;
     }
+    /// Checks if current option name is a hyper-parameter, if so, write its current
+    /// value to the given output stream and return true.
+    static bool tryWriteOption(const std::string &name, std::ostream &os)
+    {
+        auto it = instance().map.find(name);
+        if (it != instance().map.end()) {
+            it->second->write(os);
+            return true;
+        }
+        return false;
+    }
 };
 
 #define STRINGIFY2(x)     #x